@@ -0,0 +1,45 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lancet/base_decode.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "benchmark/benchmark.h"
+#pragma clang diagnostic pop
+
+namespace {
+void DecodeReads(benchmark::State& state, lancet::DecodeKernel kernel) {
+  if (static_cast<int>(kernel) > static_cast<int>(lancet::BestDecodeKernel())) {
+    state.SkipWithError("decode kernel not supported by this CPU");
+    return;
+  }
+
+  const auto readLength = static_cast<std::size_t>(state.range(0));
+  std::mt19937 gen(42);  // NOLINT
+  std::uniform_int_distribution<unsigned> byteDist(0, 255);  // NOLINT
+  std::vector<std::uint8_t> packed((readLength + 1) / 2);
+  for (auto& byte : packed) byte = static_cast<std::uint8_t>(byteDist(gen));
+
+  std::string result(readLength, 'N');
+  for ([[maybe_unused]] auto _ : state) {
+    lancet::DecodeBases(kernel, packed.data(), 0, readLength, result.data());
+    benchmark::DoNotOptimize(result.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(readLength));
+}
+
+void BM_DecodeBasesScalar(benchmark::State& state) { DecodeReads(state, lancet::DecodeKernel::SCALAR); }
+void BM_DecodeBasesSsse3(benchmark::State& state) { DecodeReads(state, lancet::DecodeKernel::SSSE3); }
+void BM_DecodeBasesAvx2(benchmark::State& state) { DecodeReads(state, lancet::DecodeKernel::AVX2); }
+}  // namespace
+
+// short read, long short read and a long read
+BENCHMARK(BM_DecodeBasesScalar)->Arg(150)->Arg(250)->Arg(10000);  // NOLINT
+BENCHMARK(BM_DecodeBasesSsse3)->Arg(150)->Arg(250)->Arg(10000);   // NOLINT
+BENCHMARK(BM_DecodeBasesAvx2)->Arg(150)->Arg(250)->Arg(10000);    // NOLINT
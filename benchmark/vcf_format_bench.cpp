@@ -0,0 +1,181 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "lancet/cli_params.h"
+#include "lancet/fisher_exact.h"
+#include "lancet/transcript.h"
+#include "lancet/variant.h"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#include "benchmark/benchmark.h"
+#pragma clang diagnostic pop
+
+namespace {
+constexpr std::size_t NUM_VARIANTS = 4096;
+
+// Mostly low VAF somatic calls with strand bias, similar to noisy somatic panel output
+auto MakeVariants() -> std::vector<lancet::Variant> {
+  using lancet::BaseCov;
+  using lancet::BaseHpCov;
+  using lancet::SampleCov;
+
+  std::mt19937 gen(42);  // NOLINT
+  std::uniform_int_distribution<std::uint16_t> refCov(10, 200);  // NOLINT
+  std::uniform_int_distribution<std::uint16_t> altCov(0, 6);     // NOLINT
+
+  std::vector<lancet::Variant> result;
+  result.reserve(NUM_VARIANTS);
+  const std::array<SampleCov, 2> covs{SampleCov(BaseHpCov(BaseCov()), BaseHpCov(BaseCov())),
+                                      SampleCov(BaseHpCov(BaseCov()), BaseHpCov(BaseCov()))};
+
+  for (std::size_t idx = 0; idx < NUM_VARIANTS; ++idx) {
+    const lancet::Transcript tr("chr1", 1000 + idx * 50, lancet::TranscriptCode::SNV, {}, {'A', 'T', 'C', 'C'}, covs,
+                                true);
+    lancet::Variant var(tr, 21);  // NOLINT
+
+    const auto tmrAltFwd = static_cast<std::uint16_t>(altCov(gen) + 1);
+    var.TumorCov = lancet::VariantHpCov(lancet::HpCov({refCov(gen), refCov(gen)}, {0, 0, 0}),
+                                        lancet::HpCov({tmrAltFwd, altCov(gen)}, {0, 0, 0}));
+    var.NormalCov = lancet::VariantHpCov(lancet::HpCov({refCov(gen), refCov(gen)}, {0, 0, 0}),
+                                         lancet::HpCov({0, 0}, {0, 0, 0}));
+    result.emplace_back(std::move(var));
+  }
+
+  return result;
+}
+
+auto LegacyGenotype(int ref, int alt) -> std::string {
+  if (ref > 0 && alt == 0) return "0/0";
+  if (ref > 0 && alt > 0) return "0/1";
+  if (ref == 0 && alt > 0) return "1/1";
+  return "./.";
+}
+
+auto LegacySampleFormat(const lancet::VariantHpCov& v, bool is_tenx_mode) -> std::string {
+  using lancet::Haplotype;
+  auto result = absl::StrFormat("%s:%d,%d:%d,%d:%d,%d:%d", LegacyGenotype(v.TotalRefCov(), v.TotalAltCov()),
+                                v.TotalRefCov(), v.TotalAltCov(), v.refAl.fwdCov, v.refAl.revCov, v.altAl.fwdCov,
+                                v.altAl.revCov, v.TotalCov());
+
+  if (is_tenx_mode) {
+    result += absl::StrFormat(":%d,%d,%d:%d,%d,%d", v.RefHP(Haplotype::FIRST), v.RefHP(Haplotype::SECOND),
+                              v.RefHP(Haplotype::UNASSIGNED), v.AltHP(Haplotype::FIRST), v.AltHP(Haplotype::SECOND),
+                              v.AltHP(Haplotype::UNASSIGNED));
+  }
+
+  return result;
+}
+
+// `StrFormat` based formatter that `AppendVcfLine` replaced, kept here as the baseline it is measured against
+auto LegacyMakeVcfLine(const lancet::Variant& var, const lancet::CliParams& params) -> std::string {
+  using lancet::Haplotype;
+  using lancet::PhredFisherScore;
+  const auto& nml = var.NormalCov;
+  const auto& tmr = var.TumorCov;
+
+  const auto somaticScore = PhredFisherScore(nml.TotalRefCov(), tmr.TotalRefCov(), nml.TotalAltCov(),
+                                             tmr.TotalAltCov());
+  const auto strandBiasScore = PhredFisherScore(tmr.refAl.fwdCov, tmr.refAl.revCov, tmr.altAl.fwdCov,
+                                                tmr.altAl.revCov);
+  const auto varState = var.ComputeState();
+
+  auto info = absl::StrFormat("%s;FETS=%f;TYPE=%s;LEN=%d;KMERSIZE=%d;SB=%f", lancet::ToString(varState),
+                              somaticScore, lancet::ToString(var.Kind), var.Length, var.KmerSize, strandBiasScore);
+
+  if (!var.STRResult.empty()) info += absl::StrFormat(";MS=%s", var.STRResult);
+
+  if (params.tenxMode) {
+    const auto nmlHpScore = PhredFisherScore(nml.RefHP(Haplotype::FIRST), nml.RefHP(Haplotype::SECOND),
+                                             nml.AltHP(Haplotype::FIRST), nml.AltHP(Haplotype::SECOND));
+    const auto tmrHpScore = PhredFisherScore(tmr.RefHP(Haplotype::FIRST), tmr.RefHP(Haplotype::SECOND),
+                                             tmr.AltHP(Haplotype::FIRST), tmr.AltHP(Haplotype::SECOND));
+    const auto pairHpScore = PhredFisherScore(nml.TotalHP(Haplotype::FIRST), nml.TotalHP(Haplotype::SECOND),
+                                              tmr.TotalHP(Haplotype::FIRST), tmr.TotalHP(Haplotype::SECOND));
+    info += absl::StrFormat(";HPS=%f;HPSN=%f;HPST=%f", pairHpScore, nmlHpScore, tmrHpScore);
+  }
+
+  const auto lowSomaticScore =
+      !var.STRResult.empty() ? somaticScore < params.minSTRFisher : somaticScore < params.minFisher;
+
+  std::vector<std::string> filters;
+  if (lowSomaticScore && !var.STRResult.empty()) filters.emplace_back("LowFisherSTR");
+  if (lowSomaticScore && var.STRResult.empty()) filters.emplace_back("LowFisherScore");
+  if (nml.TotalCov() < params.minNmlCov) filters.emplace_back("LowCovNormal");
+  if (nml.TotalCov() > params.maxNmlCov) filters.emplace_back("HighCovNormal");
+  if (tmr.TotalCov() < params.minTmrCov) filters.emplace_back("LowCovTumor");
+  if (tmr.TotalCov() > params.maxTmrCov) filters.emplace_back("HighCovTumor");
+  if (tmr.VAF() < params.minTmrVAF) filters.emplace_back("LowVafTumor");
+  if (nml.VAF() > params.maxNmlVAF) filters.emplace_back("HighVafNormal");
+  if (tmr.TotalAltCov() < params.minTmrAltCnt) filters.emplace_back("LowAltCntTumor");
+  if (nml.TotalAltCov() > params.maxNmlAltCnt) filters.emplace_back("HighAltCntNormal");
+
+  if (tmr.altAl.fwdCov < params.minStrandCnt || tmr.altAl.revCov < params.minStrandCnt) {
+    filters.emplace_back("StrandBias");
+  }
+
+  if (params.tenxMode && varState == lancet::VariantState::SOMATIC && tmr.AltHP(Haplotype::FIRST) > 0 &&
+      tmr.AltHP(Haplotype::SECOND) > 0) {
+    filters.emplace_back("MultiHP");
+  }
+
+  const std::string filter = filters.empty() ? "PASS" : absl::StrJoin(filters, ";");
+  const auto* format = params.tenxMode ? "GT:AD:SR:SA:DP:HPR:HPA" : "GT:AD:SR:SA:DP";
+
+  return absl::StrFormat("%s\t%d\t.\t%s\t%s\t%f\t%s\t%s\t%s\t%s\t%s\n", var.ChromName, var.Position,
+                         var.RefAllele, var.AltAllele, somaticScore, filter, info, format,
+                         LegacySampleFormat(nml, params.tenxMode), LegacySampleFormat(tmr, params.tenxMode));
+}
+
+void BM_LegacyMakeVcfLine(benchmark::State& state) {
+  const auto variants = MakeVariants();
+  const lancet::CliParams params;
+  std::size_t idx = 0;
+
+  for ([[maybe_unused]] auto _ : state) {
+    const auto record = LegacyMakeVcfLine(variants[idx++ % NUM_VARIANTS], params);
+    benchmark::DoNotOptimize(record.data());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MakeVcfLine(benchmark::State& state) {
+  const auto variants = MakeVariants();
+  const lancet::CliParams params;
+  std::size_t idx = 0;
+
+  for ([[maybe_unused]] auto _ : state) {
+    const auto record = variants[idx++ % NUM_VARIANTS].MakeVcfLine(params);
+    benchmark::DoNotOptimize(record.data());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_AppendVcfLine(benchmark::State& state) {
+  const auto variants = MakeVariants();
+  const lancet::CliParams params;
+  std::string buffer;
+  std::size_t idx = 0;
+
+  for ([[maybe_unused]] auto _ : state) {
+    buffer.clear();
+    variants[idx++ % NUM_VARIANTS].AppendVcfLine(params, &buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+}  // namespace
+
+BENCHMARK(BM_LegacyMakeVcfLine);  // NOLINT
+BENCHMARK(BM_MakeVcfLine);        // NOLINT
+BENCHMARK(BM_AppendVcfLine);      // NOLINT
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "lancet/cli_params.h"
+#include "lancet/contig_info.h"
+#include "lancet/core_enums.h"
+#include "lancet/genomic_region.h"
+
+namespace lancet {
+constexpr std::uint32_t DEFAULT_ACTIVE_INDEX_BIN_LENGTH = 1000;
+
+/// Half open interval [start0, end0) of 0-based genome positions
+struct ActiveInterval {
+  std::int64_t start0 = 0;  // NOLINT
+  std::int64_t end0 = 0;    // NOLINT
+};
+
+/// Path of a BAM/CRAM along with its size and modification time, so that an index is not used with
+/// alignments other than the ones it was built from. Size and time are 0 for files that are not local
+struct AlignmentFileStamp {
+  std::string path;        // NOLINT canonical path for local files, otherwise path as given
+  std::uint64_t size = 0;  // NOLINT
+  std::int64_t mtime = 0;  // NOLINT ticks of the last write time since the filesystem clock epoch
+
+  auto operator==(const AlignmentFileStamp& other) const -> bool {
+    return path == other.path && size == other.size && mtime == other.mtime;
+  }
+
+  auto operator!=(const AlignmentFileStamp& other) const -> bool { return !(*this == other); }
+};
+
+[[nodiscard]] auto StampAlignmentFile(const std::string& aln_path) -> AlignmentFileStamp;
+
+/// Active positions and coverage of one sample, found by streaming its BAM/CRAM once with `ScanSample`
+struct SampleScan {
+  std::vector<std::vector<ActiveInterval>> intervals;  // NOLINT per reference contig, sorted and non-overlapping
+  std::vector<std::vector<std::uint64_t>> binBases;    // NOLINT per reference contig, bases of reads starting in bin
+  std::int64_t maxReadSpan = 0;                        // NOLINT max. reference span of a scanned alignment
+  AlignmentFileStamp source;                           // NOLINT BAM/CRAM the sample was scanned from
+};
+
+/// Find genome positions where evidence of mutation from all reads of the sample reaches `params.minTmrAltCnt`,
+/// counting evidence the same way `ReadExtractor` does for a window. Coverage is summed in bins of `bin_length`.
+/// Results are indexed by contig in `ref_contigs`, alignments on other contigs are skipped.
+[[nodiscard]] auto ScanSample(const std::filesystem::path& aln_path, const CliParams& params,
+                              absl::Span<const ContigInfo> ref_contigs,
+                              std::uint32_t bin_length = DEFAULT_ACTIVE_INDEX_BIN_LENGTH) -> SampleScan;
+
+/// Genome-wide index of active positions and binned coverage of tumor and normal samples, written by
+/// `lancet scan` and read by `lancet pipeline --active-regions`. Windows that cannot be active according to
+/// the index are skipped without reading any alignments.
+///
+/// Evidence of a window in `ReadExtractor` is counted from a subset of the reads counted by the scan, so a
+/// window is never active unless some position within one read span of it is active in the index.
+class ActiveRegionIndex {
+ public:
+  ActiveRegionIndex(std::vector<ContigInfo> contigs, std::uint32_t min_alt_cnt, std::uint32_t min_bq,
+                    std::uint32_t bin_length = DEFAULT_ACTIVE_INDEX_BIN_LENGTH);
+  ActiveRegionIndex() = delete;
+
+  /// Add active positions, read span, coverage and source BAM/CRAM of one sample.
+  /// NOTE: `scan` must be from the same contigs and bin length as the index
+  void AddSample(const SampleScan& scan, SampleLabel label);
+
+  [[nodiscard]] auto Write(const std::filesystem::path& out_path) const -> absl::Status;
+  [[nodiscard]] static auto Load(const std::filesystem::path& in_path) -> absl::StatusOr<ActiveRegionIndex>;
+
+  /// Non-OK status if windows skipped by the index could be active with `params`, or the reference contigs or
+  /// tumor/normal BAM/CRAMs differ from the ones the index was built with
+  [[nodiscard]] auto CheckCompatible(const CliParams& params, absl::Span<const ContigInfo> ref_contigs) const
+      -> absl::Status;
+
+  /// False only if no active position is within one read span of `region`
+  [[nodiscard]] auto MayBeActive(const GenomicRegion& region) const -> bool;
+
+  /// Mean of tumor and normal depth in bins overlapping `region`, comparable to `ReadExtractor::AverageCoverage`
+  [[nodiscard]] auto AverageCoverage(const GenomicRegion& region) const -> double;
+
+  [[nodiscard]] auto NumActiveBases() const -> std::uint64_t;
+  [[nodiscard]] auto NumActiveIntervals() const -> std::size_t;
+
+ private:
+  struct ContigIndex {
+    ContigInfo info;
+    std::vector<ActiveInterval> intervals;
+    std::vector<std::uint16_t> tmrBinCov;
+    std::vector<std::uint16_t> nmlBinCov;
+  };
+
+  std::vector<ContigIndex> contigs;
+  absl::flat_hash_map<std::string, std::size_t> contigIdxs;
+  std::uint32_t minAltCnt = 0;
+  std::uint32_t minBaseQual = 0;
+  std::uint32_t binLength = DEFAULT_ACTIVE_INDEX_BIN_LENGTH;
+  std::int64_t maxReadSpan = 0;
+  AlignmentFileStamp tmrSource;
+  AlignmentFileStamp nmlSource;
+
+  [[nodiscard]] auto FindContig(const std::string& contig) const -> const ContigIndex*;
+};
+}  // namespace lancet
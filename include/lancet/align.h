@@ -4,6 +4,8 @@
 #include <string>
 #include <string_view>
 
+#include "lancet/cancel_token.h"
+
 namespace lancet {
 #if defined(__clang__)
 #pragma clang diagnostic push
@@ -24,7 +26,9 @@ struct AlignedSequencesView {
   std::string_view qry{};
 };
 
-[[nodiscard]] auto Align(std::string_view ref, std::string_view qry) -> AlignedSequences;
+/// Global alignment of `qry` to `ref`. Throws `WindowTimeoutError` if `token` expires during alignment
+[[nodiscard]] auto Align(std::string_view ref, std::string_view qry, const CancelToken* token = nullptr)
+    -> AlignedSequences;
 
 [[nodiscard]] auto TrimEndGaps(AlignedSequencesView* aln) -> std::size_t;
 }  // namespace lancet
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "lancet/hts_alignment.h"
+
+namespace lancet {
+/// Kinds of evidence of mutation that make a window an active region
+enum class EvidenceKind : std::uint8_t { MISMATCH = 0, INSERTION = 1, DELETION = 2, SOFTCLIP = 3 };
+constexpr std::size_t NUM_EVIDENCE_KINDS = 4;
+
+struct AlignmentEvidence {
+  std::uint32_t genomePos = 0;                // NOLINT
+  EvidenceKind kind = EvidenceKind::MISMATCH;  // NOLINT
+};
+
+/// Append genome positions of MD tag mismatches with base quality >= `min_bq`, followed by positions of
+/// CIGAR insertions, deletions, mismatches and softclips in alignment `aln` to `result`.
+/// Positions are never before the alignment start. Only start position and CIGAR of `aln` are used.
+void CollectAlignmentEvidence(const HtsAlignment& aln, std::string_view md_tag, std::string_view quals,
+                              std::uint32_t min_bq, std::vector<AlignmentEvidence>* result);
+}  // namespace lancet
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lancet {
+/// Kernels to decode 4-bit packed BAM bases, ordered from slowest to fastest
+enum class DecodeKernel : std::uint8_t { SCALAR = 0, SSSE3 = 1, AVX2 = 2 };
+
+/// Fastest kernel supported by the CPU running the process, detected once on first use
+[[nodiscard]] auto BestDecodeKernel() -> DecodeKernel;
+[[nodiscard]] auto ToString(DecodeKernel kernel) -> const char*;
+
+/// Decode `count` bases starting at base `start` of the 4-bit packed BAM sequence `packed` into ASCII
+/// IUPAC codes in `out`, which must have space for `count` chars. Same output as a `seq_nt16_str` lookup per base.
+/// NOTE: `kernel` must not be faster than `BestDecodeKernel()`
+void DecodeBases(DecodeKernel kernel, const std::uint8_t* packed, std::size_t start, std::size_t count, char* out);
+
+/// Decode bases with `BestDecodeKernel()`
+void DecodeBases(const std::uint8_t* packed, std::size_t start, std::size_t count, char* out);
+}  // namespace lancet
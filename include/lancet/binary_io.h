@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+namespace lancet {
+// Fixed width integers are written in host byte order. Binary files written by lancet are meant to be
+// read back on the same kind of machine that wrote them
+template <typename T>
+inline void WriteInt(std::ostream& out, T value) {
+  static_assert(std::is_integral_v<T>, "only fixed width integers are written to binary files");
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));  // NOLINT
+}
+
+template <typename T>
+[[nodiscard]] inline auto ReadInt(std::istream& inp, T* value) -> bool {
+  static_assert(std::is_integral_v<T>, "only fixed width integers are read from binary files");
+  return static_cast<bool>(inp.read(reinterpret_cast<char*>(value), sizeof(T)));  // NOLINT
+}
+
+/// Strings are written as a 32-bit length followed by the characters
+inline void WriteString(std::ostream& out, const std::string& value) {
+  WriteInt(out, static_cast<std::uint32_t>(value.length()));
+  out.write(value.data(), static_cast<std::streamsize>(value.length()));
+}
+
+[[nodiscard]] inline auto ReadString(std::istream& inp, std::string* value) -> bool {
+  std::uint32_t length = 0;
+  if (!ReadInt(inp, &length)) return false;
+  value->resize(length);
+  return length == 0 || static_cast<bool>(inp.read(value->data(), static_cast<std::streamsize>(length)));
+}
+}  // namespace lancet
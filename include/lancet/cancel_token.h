@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace lancet {
+/// Thrown from long running loops once the deadline of the `CancelToken` being checked has passed
+class WindowTimeoutError : public std::runtime_error {
+ public:
+  explicit WindowTimeoutError(const std::string& what) : std::runtime_error(what) {}
+};
+
+/// Cooperative cancellation with a wall clock deadline. Long running loops call `ThrowIfExpired`,
+/// so work for a window can be abandoned without killing the thread processing it.
+class CancelToken {
+ public:
+  /// Token that never expires
+  CancelToken() = default;
+
+  /// Token that expires `budget` after it is created. Zero or negative budget never expires.
+  explicit CancelToken(absl::Duration budget)
+      : deadline(budget > absl::ZeroDuration() ? absl::Now() + budget : absl::InfiniteFuture()), timeBudget(budget) {}
+
+  [[nodiscard]] auto IsExpired() const -> bool { return deadline != absl::InfiniteFuture() && absl::Now() > deadline; }
+
+  /// Throw `WindowTimeoutError` if the token has expired. `stage` is used in the error message
+  void ThrowIfExpired(const char* stage) const {
+    if (!IsExpired()) return;
+    const auto budgetStr = absl::FormatDuration(timeBudget);
+    throw WindowTimeoutError(absl::StrFormat("exceeded time budget of %s in %s", budgetStr, stage));
+  }
+
+ private:
+  absl::Time deadline = absl::InfiniteFuture();
+  absl::Duration timeBudget = absl::InfiniteDuration();
+};
+
+/// Convenience check for optional tokens passed as pointers
+inline void ThrowIfExpired(const CancelToken* token, const char* stage) {
+  if (token != nullptr) token->ThrowIfExpired(stage);
+}
+}  // namespace lancet
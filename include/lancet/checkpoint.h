@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "lancet/cli_params.h"
+
+namespace lancet {
+struct Checkpoint {
+  std::size_t numFlushedWindows = 0;  // NOLINT windows [0, numFlushedWindows) are flushed to output VCF
+  std::size_t numDoneWindows = 0;     // NOLINT windows [0, numDoneWindows) are done processing
+  std::uint64_t vcfOffset = 0;        // NOLINT byte offset in output VCF upto which output is complete
+  std::string lastFlushedChrom;       // NOLINT chromosome of the last flushed window
+  std::int64_t lastFlushedEnd0 = -1;  // NOLINT 0-based end of the last flushed window
+};
+
+/// Append-only journal of pipeline checkpoints, written next to the output VCF.
+/// Checkpoints are recorded after the output VCF is flushed, so the last complete
+/// record in the journal always points to a consistent prefix of the output VCF.
+class CheckpointJournal {
+ public:
+  CheckpointJournal(const std::filesystem::path& out_vcf, const CliParams& params);
+  CheckpointJournal() = delete;
+
+  /// Read the last complete checkpoint from an existing journal. Non-OK status is returned if the journal
+  /// is missing or was written by a run with different inputs or any parameter that changes the output.
+  [[nodiscard]] auto LoadLast() const -> absl::StatusOr<Checkpoint>;
+
+  /// Open journal for recording checkpoints. Existing journal is truncated unless `append` is true.
+  [[nodiscard]] auto Open(bool append) -> absl::Status;
+
+  void Record(const Checkpoint& ckpt);
+
+  /// Remove journal after the run completes successfully
+  void Remove();
+
+  [[nodiscard]] auto Path() const -> std::filesystem::path { return journalPath; }
+
+ private:
+  std::filesystem::path journalPath;
+  std::string fingerprint;
+  std::ofstream journal;
+
+  // All parameters that change the output are part of the fingerprint. Thread counts, store memory cap,
+  // logging and the command line are left out, so that interrupted runs can be resumed with other resources.
+  [[nodiscard]] static auto Fingerprint(const CliParams& params) -> std::string;
+};
+}  // namespace lancet
@@ -13,6 +13,11 @@ constexpr double DEFAULT_MIN_PHRED_FISHER = 5.0F;
 constexpr double DEFAULT_MIN_PHRED_FISHER_STRS = 25.0F;
 
 constexpr std::uint32_t DEFAULT_NUM_WORKER_THREADS = 1;
+constexpr std::uint32_t DEFAULT_NUM_HTS_THREADS = 0;
+constexpr std::uint32_t DEFAULT_NUM_PREFETCH_THREADS = 0;
+constexpr std::uint32_t DEFAULT_MAX_STORE_MEM_MB = 0;
+constexpr std::uint32_t MIN_STORE_MEM_MB = 16;
+constexpr std::uint32_t MAX_STORE_MEM_MB = 1U << 20U;
 constexpr std::uint32_t DEFAULT_REGION_PAD_LENGTH = 250;
 constexpr std::uint32_t DEFAULT_WINDOW_LENGTH = 600;
 constexpr std::uint32_t DEFAULT_PCT_WINDOW_OVERLAP = 84;
@@ -46,6 +51,10 @@ class CliParams {
 
   [[nodiscard]] auto ValidateParams() -> bool;
 
+  /// False if `outVcfPath` does not match `outputFormat`. BCF output must end with `.bcf` and VCF output must not,
+  /// since the format is not derived from the path and filter profile outputs inherit the extension
+  [[nodiscard]] auto ValidateOutputFormat() const -> bool;
+
   std::vector<std::string> inRegions;  // NOLINT
   std::string bedFilePath;             // NOLINT
   std::string outGraphsDir;            // NOLINT
@@ -54,6 +63,14 @@ class CliParams {
   std::string normalPath;              // NOLINT
   std::string outVcfPath;              // NOLINT
   std::string commandLine;             // NOLINT
+  std::string shardSpec;               // NOLINT
+  std::string timedOutBedPath;         // NOLINT
+  std::string outputFormat = "vcf";    // NOLINT vcf or bcf
+  std::string evidencePath;            // NOLINT binary evidence file written by pipeline, read by refilter
+  std::string activeRegionsPath;       // NOLINT active region index written by scan, read by pipeline
+
+  // NAME:KEY=VALUE,... specs of extra outputs with other filter thresholds, parsed by `ParseFilterProfiles`
+  std::vector<std::string> filterProfiles;  // NOLINT
 
   double minCovRatio = DEFAULT_MIN_NODE_COV_RATIO;      // NOLINT
   double maxWindowCov = DEFAULT_MAX_WINDOW_COV;         // NOLINT
@@ -61,8 +78,11 @@ class CliParams {
   double maxNmlVAF = DEFAULT_MAX_NORMAL_VAF;            // NOLINT
   double minFisher = DEFAULT_MIN_PHRED_FISHER;          // NOLINT
   double minSTRFisher = DEFAULT_MIN_PHRED_FISHER_STRS;  // NOLINT
+  double windowTimeBudget = 0.0;                        // NOLINT seconds to assemble a window, 0 for no limit
 
   std::uint32_t numWorkerThreads = DEFAULT_NUM_WORKER_THREADS;        // NOLINT
+  std::uint32_t numHtsThreads = DEFAULT_NUM_HTS_THREADS;              // NOLINT
+  std::uint32_t numPrefetchThreads = DEFAULT_NUM_PREFETCH_THREADS;    // NOLINT
   std::uint32_t regionPadLength = DEFAULT_REGION_PAD_LENGTH;          // NOLINT
   std::uint32_t windowLength = DEFAULT_WINDOW_LENGTH;                 // NOLINT
   std::uint32_t pctOverlap = DEFAULT_PCT_WINDOW_OVERLAP;              // NOLINT
@@ -89,6 +109,9 @@ class CliParams {
   std::uint32_t minSTRLen = DEFAULT_MIN_STR_LENGTH_TO_REPORT;         // NOLINT
   std::uint32_t maxSTRDist = DEFAULT_MAX_DIST_FROM_STR;               // NOLINT
   std::uint32_t minReadAsXsDiff = DEFAULT_MIN_READ_AS_XS_DIFF;        // NOLINT
+  std::uint32_t shardIdx = 1;                                         // NOLINT parsed from `shardSpec`, 1-based
+  std::uint32_t numShards = 1;                                        // NOLINT parsed from `shardSpec`
+  std::uint32_t maxStoreMemMb = DEFAULT_MAX_STORE_MEM_MB;             // NOLINT 0 means variants are never spilled
 
   bool verboseLogging = false;    // NOLINT
   bool activeRegionOff = false;   // NOLINT
@@ -99,5 +122,6 @@ class CliParams {
   bool extractReadPairs = false;  // NOLINT
   bool noCtgCheck = false;        // NOLINT
   bool useOverlapReads = false;   // NOLINT
+  bool resumeRun = false;         // NOLINT
 };
 }  // namespace lancet
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+namespace lancet {
+/// Tracks windows completed out of order and maintains a watermark, such that all windows with
+/// index less than the watermark are done. Updates are amortized O(1) and memory used is bounded
+/// by the spread of window indices that are done beyond the watermark.
+class CompletionTracker {
+ public:
+  explicit CompletionTracker(std::size_t first_idx = 0) : watermark(first_idx) {}
+
+  /// Mark window `idx` as done and advance the watermark past all contiguously done windows.
+  /// Returns false if window `idx` was already marked as done.
+  auto MarkDone(std::size_t idx) -> bool {
+    if (idx < watermark) return false;
+
+    const auto offset = idx - watermark;
+    if (offset >= doneAfterMark.size()) doneAfterMark.resize(offset + 1, false);
+    if (doneAfterMark[offset]) return false;
+
+    doneAfterMark[offset] = true;
+    numDone++;
+
+    while (!doneAfterMark.empty() && doneAfterMark.front()) {
+      doneAfterMark.pop_front();
+      watermark++;
+    }
+
+    return true;
+  }
+
+  [[nodiscard]] auto IsDone(std::size_t idx) const -> bool {
+    if (idx < watermark) return true;
+    const auto offset = idx - watermark;
+    return offset < doneAfterMark.size() && doneAfterMark[offset];
+  }
+
+  /// All windows with index less than the watermark are done
+  [[nodiscard]] auto Watermark() const -> std::size_t { return watermark; }
+
+  /// Number of windows marked as done using this tracker
+  [[nodiscard]] auto NumDone() const -> std::size_t { return numDone; }
+
+ private:
+  std::size_t watermark = 0;
+  std::size_t numDone = 0;
+  std::deque<bool> doneAfterMark;
+};
+}  // namespace lancet
@@ -5,6 +5,7 @@
 #include <limits>
 
 #include "absl/container/flat_hash_set.h"
+#include "lancet/cancel_token.h"
 #include "lancet/edge.h"
 #include "lancet/graph.h"
 #include "lancet/node.h"
@@ -14,7 +15,8 @@ namespace lancet {
 class EdmondKarpMaxFlow {
  public:
   explicit EdmondKarpMaxFlow(const Graph::NodeContainer* nc, std::size_t kmer_size, std::size_t max_path_len,
-                             std::uint32_t bfs_limit, bool is_tenx_mode = false);
+                             std::uint32_t bfs_limit, bool is_tenx_mode = false,
+                             const CancelToken* token = nullptr);
 
   EdmondKarpMaxFlow() = delete;
 
@@ -27,6 +29,7 @@ class EdmondKarpMaxFlow {
   std::size_t maxPathLen = std::numeric_limits<std::size_t>::max();
   std::uint32_t bfsLimit = 0;
   bool isTenxMode = false;
+  const CancelToken* cancelToken = nullptr;
 
   // to identify edges already returned in the previous call to `next_path`.
   absl::flat_hash_set<const Edge*> markedEdges;
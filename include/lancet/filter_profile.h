@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "lancet/cli_params.h"
+
+namespace lancet {
+/// Named set of filter thresholds written to its own output along with the main output of the pipeline
+struct FilterProfile {
+  std::string name;               // NOLINT
+  std::filesystem::path outPath;  // NOLINT
+  CliParams params;               // NOLINT copy of pipeline params with the filters of this profile
+};
+
+/// Parse `params.filterProfiles` specs of the form `NAME:KEY=VALUE[,KEY=VALUE...]`, where keys are
+/// filter option names without leading dashes (e.g. `strict:min-fisher=10,min-tmr-vaf=0.1`).
+/// Filters not set in a spec keep their values from `params`. Output of each profile is written
+/// next to `params.outVcfPath` with the profile name added before the extension (`out.strict.vcf`).
+/// Profiles can not lower `min-tmr-alt-cnt` below `params.minTmrAltCnt`, which gates active region detection.
+[[nodiscard]] auto ParseFilterProfiles(const CliParams& params) -> absl::StatusOr<std::vector<FilterProfile>>;
+
+/// Path of the output with `name` added before the `.vcf`, `.vcf.gz` or `.bcf` extension of `out_path`
+[[nodiscard]] auto ProfileOutputPath(const std::string& out_path, const std::string& name) -> std::string;
+}  // namespace lancet
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstddef>
+
+#include "absl/types/span.h"
+
 namespace lancet {
 struct FisherExactResult {
   double leftp = 0.0;
@@ -8,10 +12,26 @@ struct FisherExactResult {
   double probability = 0.0;
 };
 
+/// Counts of a 2x2 contingency table, in the same order as the arguments of `FisherTest`
+struct FisherCounts {
+  int n11 = 0;  // NOLINT
+  int n12 = 0;  // NOLINT
+  int n21 = 0;  // NOLINT
+  int n22 = 0;  // NOLINT
+};
+
 [[nodiscard]] auto FisherTest(int n_11, int n_12, int n_21, int n_22) -> FisherExactResult;
 [[nodiscard]] auto PhredScaled(const FisherExactResult& result) -> double;
 
-[[nodiscard]] inline auto PhredFisherScore(int n_11, int n_12, int n_21, int n_22) -> double {
-  return PhredScaled(FisherTest(n_11, n_12, n_21, n_22));
-}
+/// Size the process-wide log-factorial table used by `PhredFisherScore` to tables with upto `max_total` counts.
+/// Larger tables compute log-factorials directly, so scores are the same irrespective of the table size.
+/// NOTE: must be called before worker threads start scoring variants
+void InitLogFactorialTable(std::size_t max_total);
+
+/// Phred scaled probability of the table, same as `PhredScaled(FisherTest(...))` without the tail sums.
+/// Scores of recently seen tables are cached per thread.
+[[nodiscard]] auto PhredFisherScore(int n_11, int n_12, int n_21, int n_22) -> double;
+
+/// Score all `tables` into `scores`, which must have the same size as `tables`
+void PhredFisherScores(absl::Span<const FisherCounts> tables, absl::Span<double> scores);
 }  // namespace lancet
@@ -13,6 +13,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "lancet/base_hpcov.h"
+#include "lancet/cancel_token.h"
 #include "lancet/cli_params.h"
 #include "lancet/core_enums.h"
 #include "lancet/node.h"
@@ -30,7 +31,7 @@ class Graph {
   using ConstNodeIterator = NodeContainer::const_iterator;
 
   Graph(std::shared_ptr<const RefWindow> w, NodeContainer&& data, double avg_cov, std::size_t k,
-        std::shared_ptr<const CliParams> p);
+        std::shared_ptr<const CliParams> p, const CancelToken* token = nullptr);
   Graph() = delete;
 
   // 0 = NORMAL, 1 = TUMOR
@@ -102,6 +103,7 @@ class Graph {
   std::shared_ptr<const CliParams> params = nullptr;
   bool shouldIncrementK = false;
   NodeContainer nodesMap;
+  const CancelToken* cancelToken = nullptr;
 
   struct RefEndResult {
     NodeIdentifier nodeId = 0;
@@ -8,6 +8,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "lancet/base_hpcov.h"
+#include "lancet/cancel_token.h"
 #include "lancet/cli_params.h"
 #include "lancet/graph.h"
 #include "lancet/node.h"
@@ -18,7 +19,7 @@ namespace lancet {
 class GraphBuilder {
  public:
   GraphBuilder(std::shared_ptr<const RefWindow> w, absl::Span<const ReadInfo> reads, double avg_cov,
-               std::shared_ptr<const CliParams> p);
+               std::shared_ptr<const CliParams> p, const CancelToken* token = nullptr);
   GraphBuilder() = delete;
 
   [[nodiscard]] auto BuildGraph(std::size_t min_k, std::size_t max_k) -> std::unique_ptr<Graph>;
@@ -36,6 +37,7 @@ class GraphBuilder {
   std::shared_ptr<const RefWindow> window;
   std::shared_ptr<const CliParams> params;
   absl::Span<const ReadInfo> sampleReads;
+  const CancelToken* cancelToken = nullptr;
   Graph::NodeContainer nodesMap;
   ReferenceData refTmrData;
   ReferenceData refNmlData;
@@ -1,34 +1,91 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <string_view>
 #include <utility>
 
-#include "absl/container/flat_hash_map.h"
-#include "absl/status/statusor.h"
 #include "lancet/cigar.h"
 #include "lancet/core_enums.h"
 #include "lancet/genomic_region.h"
 #include "lancet/read_info.h"
 
+// htslib record and header types, so that views can be passed around without including htslib headers
+struct bam1_t;
+struct sam_hdr_t;
+
 namespace lancet {
+class HtsAlignment;
+
+/// Non-owning view of the alignment last read by `HtsReader`. Fields are decoded from the htslib record
+/// only when they are accessed and tags are looked up directly in the record, so alignments that are
+/// filtered out do not pay for decoding names, sequence, qualities or CIGAR.
+/// NOTE: view is only valid until the next alignment is read by the same reader
+class HtsAlignmentView {
+ public:
+  HtsAlignmentView() = default;
+  HtsAlignmentView(const bam1_t* aln, const sam_hdr_t* hdr) : rec(aln), header(hdr) {}
+
+  [[nodiscard]] auto ReadName() const -> std::string_view;
+  [[nodiscard]] auto ContigName() const -> std::string_view;
+  [[nodiscard]] auto MateContigName() const -> std::string_view;
+
+  [[nodiscard]] auto StartPosition0() const -> std::int64_t;
+  [[nodiscard]] auto EndPosition0() const -> std::int64_t;
+  [[nodiscard]] auto MateStartPosition0() const -> std::int64_t;
+  [[nodiscard]] auto MappingQuality() const -> std::uint8_t;
+  [[nodiscard]] auto SamFlags() const -> std::uint16_t;
+  [[nodiscard]] auto Length() const -> std::size_t;
+
+  [[nodiscard]] auto IsDuplicate() const -> bool;
+  [[nodiscard]] auto IsSecondary() const -> bool;
+  [[nodiscard]] auto IsQcFailed() const -> bool;
+  [[nodiscard]] auto IsUnmapped() const -> bool;
+  [[nodiscard]] auto IsReverseStrand() const -> bool;
+  [[nodiscard]] auto ReadStrand() const -> Strand { return IsReverseStrand() ? Strand::REV : Strand::FWD; }
+
+  /// Sequence and CIGAR are decoded on every call
+  [[nodiscard]] auto ReadSequence() const -> std::string;
+  [[nodiscard]] auto CigarData() const -> AlignmentCigar;
+
+  /// Raw phred scaled base qualities stored in the record
+  [[nodiscard]] auto ReadQuality() const -> std::string_view;
+
+  /// Data of 2-char `tag` in the record, nullptr if the alignment does not have the tag
+  [[nodiscard]] auto TagData(const char (&tag)[3]) const -> const std::uint8_t*;  // NOLINT
+  [[nodiscard]] auto HasTag(const char (&tag)[3]) const -> bool { return TagData(tag) != nullptr; }  // NOLINT
+
+  /// Only the read bases kept after trimming low quality ends are decoded
+  [[nodiscard]] auto BuildReadInfo(SampleLabel label, std::uint8_t min_bq, std::uint8_t max_kmer_size) const
+      -> ReadInfo;
+
+  /// Copy positions, mapping quality, flags and length into `result`, which outlives the view
+  void CopyCoreFields(HtsAlignment* result) const;
+
+ private:
+  const bam1_t* rec = nullptr;
+  const sam_hdr_t* header = nullptr;
+};
+
+/// Alignment fields copied out of a `HtsAlignmentView`, for alignments that are kept after reading the next one.
+/// Only fields set by the reader of the alignment are filled.
 class HtsAlignment {
  public:
   HtsAlignment() = default;
 
-  [[nodiscard]] auto ReadName() const -> std::string { return readName; }
-  [[nodiscard]] auto ContigName() const -> std::string { return contig; }
-  [[nodiscard]] auto MateContigName() const -> std::string { return mateContig; }
-  [[nodiscard]] auto ReadSequence() const -> std::string { return readSequence; }
-  [[nodiscard]] auto ReadQuality() const -> std::string { return readQuality; }
+  [[nodiscard]] auto ReadName() const -> const std::string& { return readName; }
+  [[nodiscard]] auto ContigName() const -> const std::string& { return contig; }
+  [[nodiscard]] auto MateContigName() const -> const std::string& { return mateContig; }
+  [[nodiscard]] auto ReadSequence() const -> const std::string& { return readSequence; }
+  [[nodiscard]] auto ReadQuality() const -> const std::string& { return readQuality; }
 
   [[nodiscard]] auto StartPosition0() const -> std::int64_t { return startPosition0; }
   [[nodiscard]] auto EndPosition0() const -> std::int64_t { return endPosition0; }
   [[nodiscard]] auto MateStartPosition0() const -> std::int64_t { return mateStartPosition0; }
   [[nodiscard]] auto MappingQuality() const -> std::uint8_t { return mappingQuality; }
 
-  [[nodiscard]] auto CigarData() const -> AlignmentCigar { return cigar; }
+  [[nodiscard]] auto CigarData() const -> const AlignmentCigar& { return cigar; }
   [[nodiscard]] auto ReadStrand() const -> Strand;
 
   [[nodiscard]] auto MateRegion() const -> GenomicRegion {
@@ -54,20 +111,11 @@ class HtsAlignment {
     return (startPosition0 >= (region.StartPosition1() - 1)) && (endPosition0 <= (region.EndPosition1() - 1));
   }
 
-  [[nodiscard]] auto Length() const -> std::size_t { return readSequence.length(); }
-
-  // NOTE: Returned tag data only valid until HtsReader's alignment data is valid
-  [[nodiscard]] auto HasTag(std::string_view tag) const -> bool { return tagsData.contains(tag); }
-  [[nodiscard]] auto TagData(std::string_view tag) const -> absl::StatusOr<const std::uint8_t*> {
-    const auto itr = tagsData.find(tag);
-    if (itr == tagsData.end()) return absl::NotFoundError("requested tag is not present");
-    return itr->second;
-  }
-
-  [[nodiscard]] auto BuildReadInfo(SampleLabel label, std::uint8_t min_bq, std::uint8_t max_kmer_size) -> ReadInfo;
+  /// Query length of the alignment, available even if the read sequence is not copied
+  [[nodiscard]] auto Length() const -> std::size_t { return readLength; }
 
   [[nodiscard]] auto SoftClips(std::vector<std::uint32_t>* clip_sizes, std::vector<std::uint32_t>* read_positions,
-                               std::vector<std::uint32_t>* genome_positions, bool use_padded = false) -> bool;
+                               std::vector<std::uint32_t>* genome_positions, bool use_padded = false) const -> bool;
 
   void SetReadName(std::string rname) { readName = std::move(rname); }
   void SetContig(std::string ctg) { contig = std::move(ctg); }
@@ -79,10 +127,10 @@ class HtsAlignment {
   void SetEndPosition0(std::int64_t end) { endPosition0 = end; }
   void SetMateStartPosition0(std::int64_t matestart) { mateStartPosition0 = matestart; }
   void SetMappingQuality(std::uint8_t mapqual) { mappingQuality = mapqual; }
+  void SetLength(std::size_t len) { readLength = len; }
 
   void SetSamFlags(std::uint16_t flags) { samFlags = flags; }
   void SetCigar(AlignmentCigar cig) { cigar = std::move(cig); }
-  void SetTagData(std::string_view tag, const std::uint8_t* data) { tagsData[std::string(tag)] = data; }
 
   void Clear() {
     readName.erase(readName.begin(), readName.end());
@@ -94,9 +142,9 @@ class HtsAlignment {
     endPosition0 = -1;
     mateStartPosition0 = -1;
     mappingQuality = 0;
+    readLength = 0;
     samFlags = 0;
     cigar.clear();
-    tagsData.erase(tagsData.begin(), tagsData.end());
   }
 
  private:
@@ -110,9 +158,9 @@ class HtsAlignment {
   std::int64_t endPosition0 = -1;
   std::int64_t mateStartPosition0 = -1;
   std::uint8_t mappingQuality = 0;
+  std::size_t readLength = 0;
   std::uint16_t samFlags = 0;
 
   AlignmentCigar cigar;
-  absl::flat_hash_map<std::string, const std::uint8_t*> tagsData;
 };
 }  // namespace lancet
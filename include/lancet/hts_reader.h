@@ -12,6 +12,8 @@
 #include "lancet/genomic_region.h"
 #include "lancet/hts_alignment.h"
 
+struct htsFile;
+
 namespace lancet {
 class HtsReader {
  public:
@@ -31,7 +33,8 @@ class HtsReader {
   void ResetIterator();
 
   enum class IteratorState : int { INVALID = -2, DONE = -1, VALID = 0 };
-  [[nodiscard]] auto NextAlignment(HtsAlignment* result, absl::Span<const std::string> fill_tags) -> IteratorState;
+  /// Point `result` to the next alignment, which is only valid until the following call
+  [[nodiscard]] auto NextAlignment(HtsAlignmentView* result) -> IteratorState;
 
   [[nodiscard]] auto SampleNames() const -> std::vector<std::string>;
   [[nodiscard]] auto ContigsInfo() const -> std::vector<ContigInfo>;
@@ -43,6 +46,16 @@ class HtsReader {
   std::unique_ptr<Impl> pimpl;
 };
 
-[[nodiscard]] auto HasTag(const std::filesystem::path& inpath, const std::filesystem::path& ref, const char* tag,
-                          int max_alignments_to_read = 1000) -> bool;
+/// Create a process-wide htslib thread pool with `num_threads` threads to (de)compress BGZF/CRAM blocks.
+/// Pool is shared by all `HtsReader`s and `VcfWriter`s opened after this call. No pool is created if
+/// `num_threads` is 0.
+/// NOTE: must be called before any reader is opened by worker threads
+void InitSharedHtsThreadPool(int num_threads);
+
+/// Attach the shared thread pool to `fp`. Does nothing if no shared pool was created.
+/// Returns false if the pool could not be attached
+[[nodiscard]] auto AttachSharedHtsThreadPool(htsFile* fp) -> bool;
+
+[[nodiscard]] auto HasTag(const std::filesystem::path& inpath, const std::filesystem::path& ref,
+                          const char (&tag)[3], int max_alignments_to_read = 1000) -> bool;  // NOLINT
 }  // namespace lancet
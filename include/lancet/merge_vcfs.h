@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+
+namespace lancet {
+struct MergeParams {
+  std::string referencePath;            // NOLINT
+  std::string outVcfPath;               // NOLINT
+  std::vector<std::string> inVcfPaths;  // NOLINT
+  std::string commandLine;              // NOLINT
+};
+
+/// Merge shard VCFs in `params.inVcfPaths` into `params.outVcfPath`. Shards can be plain text or BGZF compressed.
+/// Output ending with `.gz` is BGZF compressed and indexed. Returns non-OK status if any shard could not be merged
+[[nodiscard]] auto MergeShardVcfs(const MergeParams& params) -> absl::Status;
+
+/// Stream-merge sorted VCFs from `lancet pipeline --shard` runs into one VCF sorted in reference contig order.
+/// Variants called by more than one shard near shard borders are written once, keeping the record with the
+/// highest total depth across samples, same as de-duplication of variants in `VariantStore`.
+[[noreturn]] void RunMerge(std::shared_ptr<MergeParams> params);
+}  // namespace lancet
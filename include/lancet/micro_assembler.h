@@ -9,49 +9,63 @@
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "blockingconcurrentqueue.h"
-#include "concurrentqueue.h"
+#include "lancet/cancel_token.h"
 #include "lancet/cli_params.h"
 #include "lancet/read_extractor.h"
 #include "lancet/ref_window.h"
 #include "lancet/variant.h"
-#include "lancet/variant_store.h"
+#include "lancet/window_prefetcher.h"
+#include "lancet/window_scheduler.h"
 
 namespace lancet {
 struct WindowResult {
   absl::Duration runtime = absl::ZeroDuration();  // NOLINT
   std::size_t windowIdx = 0;                      // NOLINT
+  std::shared_ptr<const RefWindow> window;        // NOLINT
+  bool timedOut = false;                          // NOLINT
+  std::vector<Variant> variants;                  // NOLINT
 
   [[nodiscard]] auto IsEmpty() const -> bool { return runtime == absl::ZeroDuration() && windowIdx == 0; }
 };
 
-using InWindowQueue = moodycamel::ConcurrentQueue<std::shared_ptr<RefWindow>>;
 using OutResultQueue = moodycamel::BlockingConcurrentQueue<WindowResult>;
+/// Drained variant buffers handed back by the output thread, so workers reuse their capacity
+using VariantBufferPool = moodycamel::ConcurrentQueue<std::vector<Variant>>;
 
 class MicroAssembler {
  public:
-  explicit MicroAssembler(std::shared_ptr<InWindowQueue> winq, std::shared_ptr<OutResultQueue> resq,
-                          std::shared_ptr<const CliParams> p)
-      : windowQPtr(std::move(winq)), resultQPtr(std::move(resq)), params(std::move(p)) {}
+  /// Windows are pulled from `prefetch` when it is not null, otherwise windows are pulled from `sched`
+  /// and their reference sequence and reads are fetched in the worker thread before assembly.
+  /// Variants of each window are collected in a buffer taken from `pool` when one is available.
+  explicit MicroAssembler(std::shared_ptr<WindowScheduler> sched, std::size_t worker_idx,
+                          std::shared_ptr<OutResultQueue> resq, std::shared_ptr<VariantBufferPool> pool,
+                          std::shared_ptr<const CliParams> p, std::shared_ptr<WindowPrefetcher> prefetch = nullptr)
+      : schedulerPtr(std::move(sched)),
+        prefetcherPtr(std::move(prefetch)),
+        workerIdx(worker_idx),
+        resultQPtr(std::move(resq)),
+        bufferPoolPtr(std::move(pool)),
+        params(std::move(p)) {}
 
   MicroAssembler() = default;
 
-  void Process(const std::shared_ptr<VariantStore>& store);
+  /// Process windows until all windows are done. Variants found in each window are published to the
+  /// output thread along with the window result, so workers never wait on the output thread.
+  void Process();
 
  private:
-  std::shared_ptr<InWindowQueue> windowQPtr;
+  std::shared_ptr<WindowScheduler> schedulerPtr;
+  std::shared_ptr<WindowPrefetcher> prefetcherPtr;
+  std::size_t workerIdx = 0;
   std::shared_ptr<OutResultQueue> resultQPtr;
+  std::shared_ptr<VariantBufferPool> bufferPoolPtr;
   std::shared_ptr<const CliParams> params;
 
   std::vector<Variant> variants;
-  std::vector<WindowResult> results;
 
-  [[nodiscard]] auto ProcessWindow(ReadExtractor* re, const std::shared_ptr<const RefWindow>& w) -> absl::Status;
-  [[nodiscard]] auto ShouldSkipWindow(const std::shared_ptr<const RefWindow>& w) const -> bool;
+  // Next prepared window to assemble. Returns false once all windows are processed
+  [[nodiscard]] auto NextPayload(FastaReader* ref, ReadExtractor* re, WindowPayload* result) -> bool;
 
-  // Try to flush variants to store if its possible to write to store without waiting for other threads
-  void TryFlush(const std::shared_ptr<VariantStore>& store, const moodycamel::ProducerToken& token);
-
-  // Force flush variants to store blocking current thread if any other threads are writing to store.
-  void ForceFlush(const std::shared_ptr<VariantStore>& store, const moodycamel::ProducerToken& token);
+  void AssembleWindow(const WindowPayload& payload, const CancelToken* token);
 };
 }  // namespace lancet
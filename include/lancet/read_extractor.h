@@ -1,9 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <map>
+#include <deque>
 #include <memory>
-#include <string_view>
+#include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -16,6 +17,9 @@
 namespace lancet {
 using ReadInfoList = std::vector<ReadInfo>;
 
+/// Extracts reads for windows from tumor and normal BAM/CRAMs. Decoded reads are cached per sample in a
+/// sliding cache, so that reads shared by overlapping windows processed in genome order are decoded once.
+/// Reads to extract are collected in the same pass over the cache that evaluates the window for activity.
 class ReadExtractor {
  public:
   explicit ReadExtractor(std::shared_ptr<const CliParams> p);
@@ -26,6 +30,18 @@ class ReadExtractor {
   [[nodiscard]] auto IsActiveRegion() const -> bool { return isActiveRegion; }
   [[nodiscard]] auto AverageCoverage() const -> double { return avgCoverage; }
 
+  /// Sliding cache of one sample after the last target region, to check which reads are reused between windows
+  struct CacheState {
+    std::string chrom;
+    std::int64_t start1 = -1;
+    std::int64_t end1 = -1;
+    std::size_t numReads = 0;         // reads currently in the cache
+    std::int64_t firstReadEnd0 = -1;  // exclusive end of the first cached read, -1 if the cache is empty
+    std::uint64_t numDecoded = 0;     // reads decoded into the cache since construction
+  };
+
+  [[nodiscard]] auto CachedState(SampleLabel label) const -> CacheState;
+
   [[nodiscard]] auto Extract() -> ReadInfoList;
 
  private:
@@ -36,24 +52,59 @@ class ReadExtractor {
   double avgCoverage = 0.0F;
   std::shared_ptr<const CliParams> params;
 
-  [[nodiscard]] auto ExtractReads(HtsReader* rdr, ReadInfoList* result, SampleLabel label)
+  struct CachedRead {
+    HtsAlignment aln;               // NOTE: only core fields are copied for reads that fail filters
+    ReadInfo info;                  // built once, empty if read doesn't pass filters or is too short after trimming
+    std::string mdTag;              // empty if alignment has no MD tag
+    bool passesFilters = false;     // QC fail, duplicate and secondary filters
+    bool passesTmrFilters = false;  // tumor specific filters using XT, XA, AS and XS tags
+
+    [[nodiscard]] auto Overlaps(const GenomicRegion& region) const -> bool {
+      // GenomicRegion is 1-based, Alignment is 0-based with exclusive end
+      return aln.StartPosition0() < region.EndPosition1() && aln.EndPosition0() >= region.StartPosition1();
+    }
+  };
+
+  // Reads overlapping region [start1, end1] in position order. Reads ending before start1 are evicted
+  struct SampleCache {
+    std::string chrom;
+    std::int64_t start1 = -1;
+    std::int64_t end1 = -1;
+    std::deque<CachedRead> reads;
+    std::uint64_t numDecoded = 0;
+  };
+
+  SampleCache tmrCache;
+  SampleCache nmlCache;
+
+  // Cached reads in the target region that pass all read filters, in position order. Collected while
+  // evaluating the region and dropped with the next target region if the region is not extracted
+  using CandidateList = std::vector<const CachedRead*>;
+  CandidateList tmrCandidates;
+  CandidateList nmlCandidates;
+
+  // Slide `cache` to `region`, decoding only reads in `region` that are not already in the cache
+  void SlideCache(HtsReader* rdr, SampleCache* cache, const GenomicRegion& region, SampleLabel label);
+  void FetchReads(HtsReader* rdr, const GenomicRegion& region, std::int64_t min_start0, SampleLabel label,
+                  std::deque<CachedRead>* result) const;
+
+  [[nodiscard]] auto ExtractReads(const CandidateList& candidates, ReadInfoList* result)
       -> absl::flat_hash_map<std::string, GenomicRegion>;
 
   void ExtractPairs(HtsReader* rdr, const absl::flat_hash_map<std::string, GenomicRegion>& mate_info,
                     ReadInfoList* result, SampleLabel label);
 
-  [[nodiscard]] static auto PassesFilters(const HtsAlignment& aln, const CliParams& params) -> bool;
-  [[nodiscard]] static auto PassesTmrFilters(const HtsAlignment& aln, const CliParams& params) -> bool;
+  [[nodiscard]] static auto PassesFilters(const HtsAlignmentView& aln, const CliParams& params) -> bool;
+  [[nodiscard]] static auto PassesTmrFilters(const HtsAlignmentView& aln, const CliParams& params) -> bool;
 
   struct EvalResult {
     double coverage = 0.0F;
     bool isActiveRegion = false;
   };
 
-  [[nodiscard]] static auto EvaluateRegion(HtsReader* rdr, const GenomicRegion& region, const CliParams& params)
+  // Evidence is not counted if `skip_evidence` is set, e.g. if the other sample already made the region active
+  [[nodiscard]] static auto EvaluateRegion(const SampleCache& cache, const GenomicRegion& region,
+                                           const CliParams& params, bool skip_evidence, CandidateList* candidates)
       -> EvalResult;
-
-  static void FillMDMismatches(std::string_view md, std::string_view quals, std::int64_t aln_start,
-                               std::uint32_t min_bq, std::map<std::uint32_t, std::uint32_t>* result);
 };
 }  // namespace lancet
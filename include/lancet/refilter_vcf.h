@@ -0,0 +1,12 @@
+#pragma once
+
+#include <memory>
+
+#include "lancet/cli_params.h"
+
+namespace lancet {
+/// Re-apply filters in `params` to variants from the evidence file written by `lancet pipeline --evidence`
+/// and write them to `params->outVcfPath`, without re-assembling any windows. Sample names, contigs and
+/// 10X mode of the output header are taken from the evidence file.
+[[noreturn]] void RunRefilter(std::shared_ptr<CliParams> params);
+}  // namespace lancet
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <memory>
+
+#include "lancet/cli_params.h"
+
+namespace lancet {
+/// Stream tumor and normal BAM/CRAMs once and write the genome-wide `ActiveRegionIndex` of both samples to
+/// `params->activeRegionsPath`, for use with `lancet pipeline --active-regions`. The index can be re-used by
+/// pipeline runs with the same reference and min. tumor alt count and base quality, or stricter ones.
+[[noreturn]] void RunScan(std::shared_ptr<CliParams> params);
+}  // namespace lancet
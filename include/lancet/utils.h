@@ -53,6 +53,12 @@ void PushSeq(std::string_view sequence, std::string* result);
 
 void PushRevCompSeq(std::string_view sequence, std::string* result);
 
+/// Append decimal text of `value` without allocating temporary strings
+void PushUnsigned(std::uint64_t value, std::string* result);
+
+/// Append `value` with 6 digits after the decimal point, same as printf `%f`
+void PushFixed(double value, std::string* result);
+
 void PushSeq(std::string* result, std::string::iterator position, std::string_view sequence, std::size_t start_offset,
              std::size_t end_offset);
 
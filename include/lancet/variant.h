@@ -1,9 +1,13 @@
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <utility>
 
 #include "lancet/cli_params.h"
@@ -13,16 +17,72 @@
 namespace lancet {
 using VariantID = std::uint64_t;
 
+/// FILTER tags of output records, in the order they are written
+enum class VcfFilter : std::uint8_t {
+  LOW_FISHER_STR,
+  LOW_FISHER_SCORE,
+  LOW_COV_NORMAL,
+  HIGH_COV_NORMAL,
+  LOW_COV_TUMOR,
+  HIGH_COV_TUMOR,
+  LOW_VAF_TUMOR,
+  HIGH_VAF_NORMAL,
+  LOW_ALT_CNT_TUMOR,
+  HIGH_ALT_CNT_NORMAL,
+  STRAND_BIAS,
+  MULTI_HP
+};
+
+constexpr std::size_t NUM_VCF_FILTERS = 12;
+constexpr std::array<const char*, NUM_VCF_FILTERS> VCF_FILTER_NAMES = {
+    "LowFisherSTR",  "LowFisherScore", "LowCovNormal",   "HighCovNormal",    "LowCovTumor", "HighCovTumor",
+    "LowVafTumor",   "HighVafNormal",  "LowAltCntTumor", "HighAltCntNormal", "StrandBias",  "MultiHP"};
+
+/// Scores and FILTER tags of a variant, shared by the VCF and BCF record encoders
+struct VariantAnnotation {
+  VariantState state = VariantState::NONE;  // NOLINT
+  double somaticScore = 0.0;                // NOLINT
+  double strandBiasScore = 0.0;             // NOLINT
+  double pairHpScore = 0.0;                 // NOLINT only computed in tenx mode
+  double nmlHpScore = 0.0;                  // NOLINT only computed in tenx mode
+  double tmrHpScore = 0.0;                  // NOLINT only computed in tenx mode
+  std::bitset<NUM_VCF_FILTERS> filters;     // NOLINT indexed by VcfFilter, none set for variants that PASS
+
+  void AddFilter(VcfFilter flt) { filters.set(static_cast<std::size_t>(flt)); }
+};
+
 class Variant {
  public:
   Variant(const Transcript& transcript, std::size_t kmer_size);
+
+  /// Rebuild variant from alleles already normalized for VCF output, used to read back evidence files
+  Variant(std::string chrom, std::size_t pos, std::string ref, std::string alt, TranscriptCode kind, std::size_t length,
+          std::size_t kmer_size, VariantHpCov tmr_cov, VariantHpCov nml_cov);
   Variant() = delete;
 
   [[nodiscard]] auto MakeVcfLine(const CliParams& params) const -> std::string;
-  [[nodiscard]] auto ID() const -> VariantID;
+
+  /// Append VCF record with the trailing newline to `out`, so that callers can reuse one buffer for all records
+  void AppendVcfLine(const CliParams& params, std::string* out) const;
+
+  /// Render VCF record into `Record` once, so that the output thread only has to write it
+  void RenderRecord(const CliParams& params);
+
+  [[nodiscard]] auto Annotate(const CliParams& params) const -> VariantAnnotation;
+
+  /// Hash of ref and alt alleles, computed once on construction. Along with contig and position it identifies
+  /// the variant, so alleles of two variants are only compared when their hashes are equal
+  [[nodiscard]] auto ID() const -> VariantID { return identity; }
+
+  /// Same hash as `ID` of a variant with alleles `ref` and `alt`
+  [[nodiscard]] static auto AlleleHash(std::string_view ref, std::string_view alt) -> VariantID;
+
+  /// Output order of variants. Variants at the same position are ordered by their alleles
+  [[nodiscard]] auto SortKey() const { return std::tie(ContigIdx, Position, RefAllele, AltAllele); }
   [[nodiscard]] auto ComputeState() const -> VariantState;
 
   std::string ChromName;   // NOLINT
+  std::int64_t ContigIdx;  // NOLINT index of `ChromName` in reference FASTA, -1 until set by VariantStore
   std::size_t Position;    // NOLINT
   std::string RefAllele;   // NOLINT
   std::string AltAllele;   // NOLINT
@@ -32,12 +92,19 @@ class Variant {
   std::size_t KmerSize;    // NOLINT
   VariantHpCov TumorCov;   // NOLINT
   VariantHpCov NormalCov;  // NOLINT
+  std::string Record;      // NOLINT pre-rendered VCF record, empty until `RenderRecord` is called
+
+  auto operator==(const Variant& other) const -> bool {
+    return identity == other.identity && Position == other.Position && ChromName == other.ChromName &&
+           RefAllele == other.RefAllele && AltAllele == other.AltAllele;
+  }
 
-  auto operator==(const Variant& other) const -> bool { return this->ID() == other.ID(); }
-  auto operator!=(const Variant& other) const -> bool { return this->ID() != other.ID(); }
+  auto operator!=(const Variant& other) const -> bool { return !(*this == other); }
 
  private:
-  static auto Genotype(int ref, int alt) -> std::string;
-  static auto BuildSampleFormat(const VariantHpCov& v, bool is_tenx_mode) -> std::string;
+  VariantID identity = 0;
+
+  static auto Genotype(int ref, int alt) -> const char*;
+  static void AppendSampleFormat(const VariantHpCov& v, bool is_tenx_mode, std::string* out);
 };
 }  // namespace lancet
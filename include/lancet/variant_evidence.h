@@ -0,0 +1,62 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "lancet/contig_info.h"
+#include "lancet/variant.h"
+
+namespace lancet {
+/// Run level information needed to write a VCF header for variants in an evidence file
+struct EvidenceHeader {
+  std::vector<std::string> sampleNames;  // NOLINT normal followed by tumor, same as output VCF
+  std::vector<ContigInfo> contigs;       // NOLINT reference contigs, indexed by `Variant::ContigIdx`
+  std::string referencePath;             // NOLINT
+  bool tenxMode = false;                 // NOLINT
+};
+
+/// Writes every variant written to the output VCF, with its raw allele counts, kmer size and STR result
+/// to a compact binary evidence file. Filters can then be re-applied with `lancet refilter` without
+/// re-assembling windows. Records are written in output VCF order.
+class EvidenceWriter {
+ public:
+  explicit EvidenceWriter(std::filesystem::path out_path) : outPath(std::move(out_path)) {}
+  EvidenceWriter() = delete;
+
+  [[nodiscard]] auto Open(const EvidenceHeader& hdr) -> absl::Status;
+
+  /// NOTE: `ContigIdx` of variant must be set, which `VariantStore` does for all variants it writes
+  void Write(const Variant& var);
+
+  [[nodiscard]] auto Close() -> absl::Status;
+
+ private:
+  std::filesystem::path outPath;
+  std::ofstream outFh;
+};
+
+class EvidenceReader {
+ public:
+  explicit EvidenceReader(std::filesystem::path in_path) : inPath(std::move(in_path)) {}
+  EvidenceReader() = delete;
+
+  /// Read header of evidence file. Returns non-OK status if file is missing or not an evidence file
+  [[nodiscard]] auto Open() -> absl::Status;
+
+  /// Read next variant into `result`, which is reset once all variants are read.
+  /// Returns non-OK status if the file is truncated or corrupt
+  [[nodiscard]] auto Next(std::optional<Variant>* result) -> absl::Status;
+
+  [[nodiscard]] auto Header() const -> const EvidenceHeader& { return header; }
+
+ private:
+  std::filesystem::path inPath;
+  std::ifstream inFh;
+  EvidenceHeader header;
+};
+}  // namespace lancet
@@ -2,51 +2,121 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <iosfwd>
+#include <filesystem>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
-#include "absl/base/thread_annotations.h"
+#include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/types/span.h"
 #include "lancet/cli_params.h"
+#include "lancet/contig_info.h"
 #include "lancet/ref_window.h"
-#include "lancet/spinlock.h"
 #include "lancet/variant.h"
+#include "lancet/variant_evidence.h"
+#include "lancet/vcf_writer.h"
 
 namespace lancet {
+/// Outputs written along with the main output for every variant flushed from the store
+struct ExtraOutputs {
+  EvidenceWriter* evidence = nullptr;                                   // NOLINT
+  std::vector<std::pair<VcfWriter*, const CliParams*>> profileOutputs;  // NOLINT output and filters of each profile
+};
+
+/// De-duplicates variants from overlapping windows and writes them to output in sorted order.
+/// Variants are kept ordered by contig index and position, so flushing a window only visits the variants it writes.
+/// Variants are ordered by their own `SortKey`, so insertion does not copy alleles into separate keys.
+/// Duplicates are looked up among the variants at the same position by allele hash before alleles are compared.
+/// Past `maxStoreMemMb` of variants, the store is spilled to a sorted run in the temp directory and
+/// runs are merged with the variants in memory when flushing, so a window that holds flushes back
+/// does not grow memory without limit. Runs are compacted into one once there are `MAX_SPILL_RUNS` of them,
+/// so the number of open run files stays bounded as well.
+/// NOTE: not thread safe. Store is owned by the output thread, which receives variants from workers
+/// along with the results of each window.
 class VariantStore {
  public:
   // ChromosomeName -> ChromosomeIndex in reference FASTA
   using ContigIDs = absl::flat_hash_map<std::string, std::int64_t>;
 
-  explicit VariantStore(std::shared_ptr<const CliParams> p);
+  static constexpr std::size_t MAX_SPILL_RUNS = 16;
+
+  VariantStore(std::shared_ptr<const CliParams> p, ContigIDs ctg_ids);
   VariantStore() = delete;
+  ~VariantStore();
+  VariantStore(const VariantStore&) = delete;
+  auto operator=(const VariantStore&) -> VariantStore& = delete;
 
-  [[nodiscard]] static auto GetHeader(const std::vector<std::string>& sample_names, const CliParams& p) -> std::string;
+  [[nodiscard]] static auto GetHeader(const std::vector<std::string>& sample_names,
+                                      absl::Span<const ContigInfo> ref_contigs, const CliParams& p) -> std::string;
 
-  /// Tries to add variants to store if no other thread is writing to it and
-  /// returns `true` iff variants were added and `false` otherwise
-  [[nodiscard]] auto TryAddVariants(absl::Span<const Variant> variants) -> bool;
+  /// Move variants into store. Variant already in store is replaced only if the new variant has higher coverage
+  void AddVariants(absl::Span<Variant> variants);
 
-  /// Blocks if any other thread is writing to store and waits to write variants to store
-  void ForceAddVariants(absl::Span<const Variant> variants);
+  /// Variants in or before `end0` of chromosome `chrom` are already written to output in a previous run,
+  /// so any such variants added to the store from here on are dropped. Used when resuming a run.
+  void SetFlushedUpto(const std::string& chrom, std::int64_t end0);
 
-  auto FlushWindow(const RefWindow& w, std::ostream& out, const ContigIDs& ctg_ids) -> bool;
-  auto FlushAll(std::ostream& out, const ContigIDs& ctg_ids) -> bool;
+  /// Write all variants in or before window `w` to `out` and `extra` outputs. Returns true if any variants were written
+  auto FlushWindow(const RefWindow& w, VcfWriter& out, const ExtraOutputs& extra = {}) -> bool;
+  auto FlushAll(VcfWriter& out, const ExtraOutputs& extra = {}) -> bool;
+
+  [[nodiscard]] auto IsEmpty() const -> bool { return data.empty() && spillRuns.empty(); }
+  [[nodiscard]] auto Size() const -> std::size_t { return data.size(); }
+  [[nodiscard]] auto NumSpillRuns() const -> std::size_t { return spillRuns.size(); }
 
  private:
-  // https://nathanpetersen.com/2019/02/17/optimizing-for-workloads-linux-spinlocks-vs-mutexes/
-  mutable utils::SpinLock spinLock = utils::SpinLock();
-  absl::flat_hash_map<VariantID, Variant> data;
+  // Position in genome used to find the first variant at or after it
+  struct GenomePos {
+    std::int64_t contigIdx = -1;
+    std::size_t position = 0;
+  };
+
+  // sort order of variants in output VCF. A `GenomePos` sorts before all variants at the same position
+  struct VariantOrder {
+    using is_transparent = void;
+
+    auto operator()(const Variant& lhs, const Variant& rhs) const -> bool { return lhs.SortKey() < rhs.SortKey(); }
+
+    auto operator()(const Variant& lhs, const GenomePos& rhs) const -> bool {
+      return std::tie(lhs.ContigIdx, lhs.Position) < std::tie(rhs.contigIdx, rhs.position);
+    }
+
+    auto operator()(const GenomePos& lhs, const Variant& rhs) const -> bool {
+      return std::tie(lhs.contigIdx, lhs.position) <= std::tie(rhs.ContigIdx, rhs.Position);
+    }
+  };
+
+  // Sorted variants spilled from memory, read back one variant at a time while flushing
+  class SpillRun;
+
+  using Container = absl::btree_set<Variant, VariantOrder>;
+  Container data;
   std::shared_ptr<const CliParams> params = nullptr;
+  ContigIDs contigIDs;
+  std::string flushedChrom;
+  std::int64_t flushedEnd0 = -1;
 
-  [[nodiscard]] auto Flush(absl::Span<const VariantID> ids, std::ostream& out, const ContigIDs& ctg_ids) -> bool;
+  std::size_t memBytes = 0;                         // approx. bytes used by variants in `data`
+  std::size_t maxMemBytes = 0;                      // 0 means variants are never spilled
+  std::vector<std::unique_ptr<SpillRun>> spillRuns;  // oldest first
+  std::size_t numSpilled = 0;
+  EvidenceHeader spillHeader;
 
-  [[nodiscard]] static auto IsVariant1LessThan2(const Variant& v1, const Variant& v2, const ContigIDs& ctg_ids) -> bool;
-  [[nodiscard]] static auto IsVariantInOrBefore(const Variant& v, const RefWindow& w, const ContigIDs& ctg_ids) -> bool;
+  // Write variants before `bound` (all variants if null) in sorted order to `out` and remove them from store
+  auto FlushUpto(const GenomePos* bound, VcfWriter& out, const ExtraOutputs& extra) -> bool;
+  // Merge variants before `bound` (all variants if null) from spilled runs, and from memory if `with_memory`
+  // is true, passing each de-duplicated variant to `emit` in sorted order. Returns true if any variants were merged
+  auto MergeUpto(const GenomePos* bound, bool with_memory, absl::FunctionRef<void(const Variant&)> emit) -> bool;
+  void SpillToDisk();
+  void CompactSpillRuns();
+  // Variant in `data` with the same contig, position and alleles as `var`, or end if there is none
+  [[nodiscard]] auto FindDuplicate(const Variant& var) const -> Container::const_iterator;
 
-  void UnsafeAddVariantBatch(absl::Span<const Variant> variants);
+  [[nodiscard]] static auto ApproxBytes(const Variant& var) -> std::size_t;
+  [[nodiscard]] static auto TotalCov(const Variant& var) -> int;
 };
 }  // namespace lancet
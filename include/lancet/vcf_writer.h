@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "lancet/cli_params.h"
+#include "lancet/variant.h"
+
+namespace lancet {
+/// Writes VCF records as plain text or, for output paths ending with `.gz`, as BGZF compressed VCF.
+/// In BCF mode, variants are encoded straight into binary records without formatting VCF text.
+/// Compressed and BCF output is indexed while records are written, so the `.tbi` index (or `.csi`
+/// index for BCF and contigs longer than the tabix limit) is ready next to the output once `Close` returns.
+class VcfWriter {
+ public:
+  /// Open `out_path` for writing. Compressed and BCF output is compressed with the shared thread pool
+  /// from `InitSharedHtsThreadPool`, if one was created. Plain VCF output is truncated unless `resume_offset`
+  /// is not 0, in which case output after `resume_offset` bytes is dropped and new records are appended.
+  VcfWriter(const std::filesystem::path& out_path, std::uint64_t resume_offset, bool as_bcf = false);
+  ~VcfWriter();
+  VcfWriter(VcfWriter&&) noexcept;
+  auto operator=(VcfWriter&&) noexcept -> VcfWriter&;
+
+  VcfWriter() = delete;
+  VcfWriter(const VcfWriter&) = delete;
+  auto operator=(const VcfWriter&) -> VcfWriter& = delete;
+
+  /// Header must have `##contig` lines for all contigs in records, so that compressed output can be indexed
+  void WriteHeader(const std::string& header);
+
+  /// Write one VCF record including the trailing newline. For compressed output, the record is parsed
+  /// to index it, so this is meant for records that were not rendered from a `Variant`, like merged shards
+  void WriteRecord(std::string_view record);
+
+  /// Write pre-rendered record of `var` (formatted here if not rendered), or encode it into a BCF record in BCF mode
+  void WriteVariant(const Variant& var, const CliParams& params);
+
+  /// Same as `WriteVariant`, but always formats `var` with `params` instead of using its pre-rendered record.
+  /// Used for filter profile outputs, whose thresholds differ from the ones records were rendered with
+  void WriteVariantWith(const Variant& var, const CliParams& params);
+
+  void Flush();
+
+  /// Bytes of plain VCF written upto the last flush. Always 0 for compressed and BCF output
+  [[nodiscard]] auto Offset() -> std::uint64_t;
+
+  /// Flush pending records, save index for compressed output and close the output file.
+  /// NOTE: index of compressed output is not saved if the writer is destroyed without closing it
+  void Close();
+
+  [[nodiscard]] auto IsCompressed() const -> bool;
+
+  [[nodiscard]] static auto IsCompressedPath(const std::filesystem::path& out_path) -> bool;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> pimpl;
+};
+}  // namespace lancet
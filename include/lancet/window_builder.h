@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
@@ -15,6 +17,39 @@
 namespace lancet {
 using WindowPtr = std::shared_ptr<RefWindow>;
 
+/// Lazily builds windows in genome order from sorted, non-overlapping input regions.
+/// Only the current input region is expanded into windows, so memory used does not
+/// depend on the total number of windows to be processed.
+class WindowGenerator {
+ public:
+  WindowGenerator(std::vector<RefWindow> sorted_regions, std::uint32_t window_length, std::int64_t step_size);
+  WindowGenerator() = delete;
+
+  /// Next window in genome order, or nullptr once all windows have been generated
+  [[nodiscard]] auto Next() -> WindowPtr;
+
+  /// Skip the next `count` windows without building them
+  void SkipWindows(std::size_t count);
+
+  /// Stop generating windows once window index `end_idx` is reached
+  void LimitWindows(std::size_t end_idx) { endWindowIdx = std::min(end_idx, numTotalWindows); }
+
+  [[nodiscard]] auto TotalWindows() const noexcept -> std::size_t { return numTotalWindows; }
+  [[nodiscard]] auto NumGenerated() const noexcept -> std::size_t { return nextWindowIdx; }
+
+ private:
+  std::vector<RefWindow> regions;
+  std::size_t currRegionIdx = 0;
+  std::int64_t currWindowStart = -1;
+  std::size_t nextWindowIdx = 0;
+  std::size_t numTotalWindows = 0;
+  std::size_t endWindowIdx = 0;
+  std::uint32_t windowLength = DEFAULT_WINDOW_LENGTH;
+  std::int64_t stepSize = 0;
+
+  [[nodiscard]] auto NumWindowsInRegion(const RefWindow& region) const -> std::size_t;
+};
+
 class WindowBuilder {
  public:
   WindowBuilder(const std::filesystem::path& ref, std::uint32_t region_padding, std::uint32_t window_length,
@@ -32,10 +67,11 @@ class WindowBuilder {
   /// 1. Combine the input regions from bed file & samtools-style regions.
   ///    Non-OK status is returned if no input regions have been added.
   /// 2. Add `regionPadding` to each input region from the previous step
-  /// 3. Build result windows each `windowLength` in length and
+  /// 3. Sort padded regions in genome order and merge overlapping regions
+  /// 4. Build generator for windows each `windowLength` in length and
   ///    overlap of `pctWindowOverlap`% between consecutive windows
-  [[nodiscard]] auto BuildWindows(const absl::flat_hash_map<std::string, std::int64_t>& contig_ids) const
-      -> absl::StatusOr<std::vector<WindowPtr>>;
+  [[nodiscard]] auto BuildGenerator(const absl::flat_hash_map<std::string, std::int64_t>& contig_ids) const
+      -> absl::StatusOr<std::unique_ptr<WindowGenerator>>;
 
   [[nodiscard]] static auto StepSize(std::uint32_t pct_overlap, std::uint32_t window_length) -> std::int64_t;
 
@@ -59,9 +95,10 @@ class WindowBuilder {
 /// 1. Combine the input regions from bed file & samtools-style regions.
 ///    Non-OK status is returned if no input regions have been added.
 /// 2. Add `regionPadding` to each input region from the previous step
-/// 3. Build result windows each `windowLength` in length and
+/// 3. Sort padded regions in genome order and merge overlapping regions
+/// 4. Build generator for windows each `windowLength` in length and
 ///    overlap of `pctWindowOverlap`% between consecutive windows
 /// NOTE: calls std::exit on failure
-[[nodiscard]] auto BuildWindows(const absl::flat_hash_map<std::string, std::int64_t>& contig_ids,
-                                const CliParams& params) -> std::vector<WindowPtr>;
+[[nodiscard]] auto BuildWindowGenerator(const absl::flat_hash_map<std::string, std::int64_t>& contig_ids,
+                                        const CliParams& params) -> std::unique_ptr<WindowGenerator>;
 }  // namespace lancet
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "lancet/cli_params.h"
+#include "lancet/fasta_reader.h"
+#include "lancet/read_extractor.h"
+#include "lancet/ref_window.h"
+#include "lancet/window_builder.h"
+#include "lancet/window_scheduler.h"
+
+namespace lancet {
+constexpr std::size_t DEFAULT_PREFETCH_WINDOWS_PER_WORKER = 2;
+
+/// Reference sequence and reads of a window, ready to be assembled by a `MicroAssembler` worker
+struct WindowPayload {
+  WindowPtr window;                                    // NOLINT
+  absl::Status status;                                 // NOLINT
+  ReadInfoList reads;                                  // NOLINT
+  double avgCoverage = 0.0;                            // NOLINT
+  bool shouldAssemble = false;                         // NOLINT
+  absl::Duration fetchRuntime = absl::ZeroDuration();  // NOLINT
+};
+
+/// Fetch reference sequence of window `w`, evaluate whether it is an active region and extract its reads.
+/// Windows that need not be assembled are returned with `shouldAssemble` set to false.
+[[nodiscard]] auto PrepareWindow(WindowPtr w, FastaReader* ref, ReadExtractor* re, WindowScheduler* sched,
+                                 const CliParams& params) -> WindowPayload;
+
+/// I/O stage of the pipeline. Prefetch threads pull windows from the `WindowScheduler` and fill a bounded
+/// queue with prepared window payloads, so that `MicroAssembler` workers only do graph work.
+class WindowPrefetcher {
+ public:
+  WindowPrefetcher(std::shared_ptr<WindowScheduler> sched, std::size_t max_queued, std::shared_ptr<const CliParams> p);
+  WindowPrefetcher() = delete;
+
+  /// Start `num_threads` prefetch threads. Thread `i` pulls windows from the scheduler as worker `i`
+  void Start(std::size_t num_threads);
+
+  /// Block until the next payload is ready. Returns false once all windows are prefetched and consumed.
+  [[nodiscard]] auto Next(WindowPayload* result) -> bool;
+
+  /// Wait for prefetch threads to finish
+  void Join();
+
+ private:
+  std::shared_ptr<WindowScheduler> schedulerPtr;
+  std::size_t maxQueued = 0;
+  std::shared_ptr<const CliParams> params;
+
+  std::mutex queueMutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::deque<WindowPayload> payloads;
+  std::size_t numActiveThreads = 0;
+  std::vector<std::future<void>> prefetchers;
+
+  using Readers = std::pair<std::unique_ptr<FastaReader>, std::unique_ptr<ReadExtractor>>;
+
+  void Prefetch(std::size_t thread_idx);
+  void Push(WindowPayload&& payload);
+  [[nodiscard]] auto OpenReaders() const -> absl::StatusOr<Readers>;
+};
+}  // namespace lancet
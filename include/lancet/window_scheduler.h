@@ -0,0 +1,126 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "absl/container/fixed_array.h"
+#include "absl/time/time.h"
+#include "lancet/active_region_index.h"
+#include "lancet/cli_params.h"
+#include "lancet/fasta_reader.h"
+#include "lancet/online_stats.h"
+#include "lancet/spinlock.h"
+#include "lancet/window_builder.h"
+
+namespace lancet {
+constexpr std::size_t DEFAULT_WINDOWS_PER_RUN = 8;
+constexpr std::size_t DEFAULT_PENDING_RUNS_PER_WORKER = 4;
+
+/// Hands out windows to MicroAssembler workers ordered by an estimated processing cost.
+///
+/// Windows are pulled lazily from a `WindowGenerator` and grouped into runs of adjacent windows from the
+/// same contig, so at most `maxPendingRuns` runs of windows are held in memory. Idle workers claim the
+/// most expensive run from a bounded lookahead of pending runs and process it in genome order.
+/// Once no runs are pending, idle workers steal windows from the back of the busiest worker's run,
+/// so that the expensive windows start early and the tail of the run stays short.
+///
+/// Reference sequences of windows are fetched and costed by the worker that pulled their run from the
+/// generator, outside the pool lock, so that workers do this in parallel with each other.
+///
+/// Cost of a run is estimated from the reference repeat content of its windows, and refined with the
+/// coverage and runtimes reported by workers for neighboring windows. Windows that cannot be active according
+/// to the optional `ActiveRegionIndex` are estimated to cost nothing.
+class WindowScheduler {
+ public:
+  WindowScheduler(std::unique_ptr<WindowGenerator> gen, std::size_t num_workers, std::shared_ptr<const CliParams> p,
+                  std::shared_ptr<const ActiveRegionIndex> active_idx = nullptr);
+  WindowScheduler() = delete;
+
+  /// Next window to be processed by worker `worker_idx`. Returns nullptr once all windows are handed out.
+  [[nodiscard]] auto Next(std::size_t worker_idx) -> WindowPtr;
+
+  /// Index of active regions from `lancet scan`. Returns nullptr if the pipeline was run without an index
+  [[nodiscard]] auto ActiveIndex() const -> const ActiveRegionIndex* { return activeIndex.get(); }
+
+  /// Average coverage computed by `ReadExtractor` for window `win_idx`, used to refine pending run estimates
+  void ReportCoverage(std::size_t win_idx, double avg_cov);
+
+  /// Total runtime taken for processing window `win_idx`, used to refine pending run estimates
+  void ReportRuntime(std::size_t win_idx, absl::Duration runtime);
+
+  /// Relative cost of assembling the reference sequence of a window. Returns 0 for windows that will be
+  /// skipped without assembly and grows with the fraction of repeated `k`-mers in the sequence.
+  [[nodiscard]] static auto ReferenceCostFactor(std::string_view seq, std::size_t k) -> double;
+
+ private:
+  struct WindowRun {
+    std::deque<WindowPtr> windows;
+    std::size_t firstIdx = 0;
+    std::size_t lastIdx = 0;
+    std::size_t numTimesSkipped = 0;
+    double refCostFactor = 1.0;
+    double neighbourSecs = -1.0;
+    double neighbourCov = -1.0;
+  };
+
+  struct WorkerRun {
+    utils::SpinLock spinLock = utils::SpinLock();
+    std::deque<WindowPtr> windows;
+    std::unique_ptr<FastaReader> refRdr;  // only used by the worker owning the run
+  };
+
+  struct NeighbourStat {
+    std::size_t windowIdx = 0;
+    double value = 0.0;
+  };
+
+  std::shared_ptr<const CliParams> params;
+  std::shared_ptr<const ActiveRegionIndex> activeIndex;
+
+  std::mutex poolMutex;
+  std::condition_variable runsReady;
+  std::unique_ptr<WindowGenerator> windowGen;
+  WindowPtr nextWindow;
+  bool isGenExhausted = false;
+  std::size_t maxPendingRuns = 0;
+  std::size_t numRunsCosting = 0;
+  std::deque<WindowRun> pendingRuns;
+  absl::FixedArray<WorkerRun> workerRuns;
+
+  OnlineStats runtimeStats;
+  OnlineStats coverageStats;
+  std::deque<NeighbourStat> recentRuntimes;
+  std::deque<NeighbourStat> recentCoverages;
+
+  // Pull and cost upto `DEFAULT_PENDING_RUNS_PER_WORKER` new runs, then claim the run with highest estimated
+  // cost from pending runs. Returns empty deque if no runs are pending
+  [[nodiscard]] auto ClaimCostliestRun(std::size_t worker_idx) -> std::deque<WindowPtr>;
+
+  // Steal a window from the back of the busiest worker's run. Returns nullptr if all workers are out of windows
+  [[nodiscard]] auto StealWindow(std::size_t thief_idx) -> WindowPtr;
+
+  // Next `max_runs` runs of adjacent windows in genome order, without reference sequences.
+  // NOTE: must be called while holding `poolMutex`
+  [[nodiscard]] auto PullRuns(std::size_t max_runs) -> std::vector<WindowRun>;
+
+  // Fetch reference sequences of windows in `run` with `ref` and estimate the reference cost factor of the run
+  void CostRun(WindowRun* run, FastaReader* ref) const;
+
+  // Seed neighbour estimates of `run` and add it to pending runs.
+  // NOTE: must be called while holding `poolMutex`
+  void AddPendingRun(WindowRun&& run);
+
+  // NOTE: must be called while holding `poolMutex`
+  [[nodiscard]] auto EstimatedCost(const WindowRun& run) const -> double;
+
+  // NOTE: must be called while holding `poolMutex`
+  void RecordNeighbourStat(std::size_t win_idx, double value, bool is_runtime);
+
+  [[nodiscard]] static auto IsNeighbour(const WindowRun& run, std::size_t win_idx) -> bool;
+};
+}  // namespace lancet
@@ -0,0 +1,413 @@
+#include "lancet/active_region_index.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "absl/strings/str_format.h"
+#include "lancet/alignment_evidence.h"
+#include "lancet/binary_io.h"
+#include "lancet/hts_alignment.h"
+#include "lancet/hts_reader.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#pragma clang diagnostic ignored "-Wcast-qual"
+#elif defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+
+#include "htslib/sam.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace lancet {
+static constexpr std::array<char, 8> ACTIVE_INDEX_MAGIC = {'L', 'N', 'C', 'T', 'A', 'C', 'T', 'V'};
+static constexpr std::uint32_t ACTIVE_INDEX_VERSION = 2;
+
+static inline auto NumBins(std::int64_t contig_len, std::uint32_t bin_length) -> std::size_t {
+  return static_cast<std::size_t>((contig_len + bin_length - 1) / bin_length);
+}
+
+// Append position `pos` to sorted intervals in `result`, extending the last interval if `pos` is adjacent to it
+static inline void AppendPosition(std::int64_t pos, std::vector<ActiveInterval>* result) {
+  if (!result->empty() && result->back().end0 == pos) {
+    result->back().end0++;
+    return;
+  }
+
+  result->push_back({pos, pos + 1});
+}
+
+// Evidence counts per genome position from alignments in coordinate order. Positions before the start of
+// the current alignment cannot get more evidence, so they are finalized and dropped from the counter.
+class SlidingEvidenceCounter {
+ public:
+  explicit SlidingEvidenceCounter(std::uint32_t min_count) : minCount(min_count) {}
+
+  // NOTE: evidence is never before the start of the alignment it came from
+  void Add(const AlignmentEvidence& evidence) {
+    const auto offset = static_cast<std::size_t>(static_cast<std::int64_t>(evidence.genomePos) - firstPos);
+    if (offset >= counts.size()) counts.resize(offset + 1);
+    counts[offset][static_cast<std::size_t>(evidence.kind)]++;
+  }
+
+  // Finalize positions before `pos`, appending active positions to `result`
+  void FinalizeBefore(std::int64_t pos, std::vector<ActiveInterval>* result) {
+    while (!counts.empty() && firstPos < pos) {
+      const auto& posCounts = counts.front();
+      const auto isActive = std::any_of(posCounts.cbegin(), posCounts.cend(),
+                                        [this](std::uint32_t cnt) { return cnt > 0 && cnt >= minCount; });
+      if (isActive) AppendPosition(firstPos, result);
+      counts.pop_front();
+      firstPos++;
+    }
+
+    if (counts.empty()) firstPos = pos;
+  }
+
+  void FinalizeAll(std::vector<ActiveInterval>* result) {
+    FinalizeBefore(firstPos + static_cast<std::int64_t>(counts.size()), result);
+  }
+
+ private:
+  using PositionCounts = std::array<std::uint32_t, NUM_EVIDENCE_KINDS>;
+  std::uint32_t minCount = 0;
+  std::int64_t firstPos = 0;
+  std::deque<PositionCounts> counts;
+};
+
+auto StampAlignmentFile(const std::string& aln_path) -> AlignmentFileStamp {
+  // remote paths like s3:// or https:// URLs are not local files, so only their path is compared
+  std::error_code err;
+  const auto canonical = std::filesystem::canonical(aln_path, err);
+  if (err) return AlignmentFileStamp{aln_path};
+
+  const auto size = std::filesystem::file_size(canonical, err);
+  if (err) return AlignmentFileStamp{canonical.string()};
+  const auto mtime = std::filesystem::last_write_time(canonical, err);
+  if (err) return AlignmentFileStamp{canonical.string(), size};
+  return AlignmentFileStamp{canonical.string(), size, mtime.time_since_epoch().count()};
+}
+
+static inline void WriteStamp(std::ostream& out, const AlignmentFileStamp& stamp) {
+  WriteString(out, stamp.path);
+  WriteInt(out, stamp.size);
+  WriteInt(out, stamp.mtime);
+}
+
+[[nodiscard]] static inline auto ReadStamp(std::istream& inp, AlignmentFileStamp* stamp) -> bool {
+  return ReadString(inp, &stamp->path) && ReadInt(inp, &stamp->size) && ReadInt(inp, &stamp->mtime);
+}
+
+auto ScanSample(const std::filesystem::path& aln_path, const CliParams& params,
+                absl::Span<const ContigInfo> ref_contigs, std::uint32_t bin_length) -> SampleScan {
+  SampleScan result;
+  result.source = StampAlignmentFile(aln_path.string());
+  result.intervals.resize(ref_contigs.size());
+  result.binBases.resize(ref_contigs.size());
+
+  absl::flat_hash_map<std::string, std::size_t> ctgIdxs;
+  for (std::size_t idx = 0; idx < ref_contigs.size(); ++idx) {
+    ctgIdxs.emplace(ref_contigs[idx].contigName, idx);
+    result.binBases[idx].resize(NumBins(ref_contigs[idx].contigLen, bin_length));
+  }
+
+  HtsReader rdr(aln_path, params.referencePath);
+  HtsAlignmentView view;
+  HtsAlignment aln;
+  std::vector<AlignmentEvidence> evidence;
+  SlidingEvidenceCounter counter(params.minTmrAltCnt);
+
+  const auto noContig = ref_contigs.size();
+  auto currIdx = noContig;
+  std::string currContig;
+  std::int64_t prevStart0 = -1;
+
+  auto state = rdr.NextAlignment(&view);
+  for (; state == HtsReader::IteratorState::VALID; state = rdr.NextAlignment(&view)) {
+    if (view.IsUnmapped()) continue;
+
+    if (view.ContigName() != currContig) {
+      if (currIdx != noContig) counter.FinalizeAll(&result.intervals[currIdx]);
+      currContig = std::string(view.ContigName());
+      const auto itr = ctgIdxs.find(currContig);
+      currIdx = itr == ctgIdxs.end() ? noContig : itr->second;
+      prevStart0 = -1;
+    }
+
+    // alignments on contigs missing from the reference are never part of a window
+    if (currIdx == noContig) continue;
+
+    const auto start0 = view.StartPosition0();
+    if (start0 < prevStart0) {
+      throw std::runtime_error(absl::StrFormat("alignments in %s are not coordinate sorted", aln_path.string()));
+    }
+
+    prevStart0 = start0;
+    counter.FinalizeBefore(start0, &result.intervals[currIdx]);
+    result.maxReadSpan = std::max(result.maxReadSpan, view.EndPosition0() - start0);
+
+    auto& bins = result.binBases[currIdx];
+    const auto binIdx = static_cast<std::size_t>(start0) / bin_length;
+    if (binIdx < bins.size()) bins[binIdx] += view.Length();
+
+    view.CopyCoreFields(&aln);
+    aln.SetCigar(view.CigarData());
+    const auto* mdData = view.TagData("MD");
+    const char* mdTag = mdData != nullptr ? bam_aux2Z(mdData) : nullptr;
+
+    evidence.clear();
+    CollectAlignmentEvidence(aln, mdTag != nullptr ? mdTag : "", view.ReadQuality(), params.minBaseQual, &evidence);
+    for (const auto& evd : evidence) counter.Add(evd);
+  }
+
+  if (state == HtsReader::IteratorState::INVALID) {
+    throw std::runtime_error(absl::StrFormat("could not read alignments from %s", aln_path.string()));
+  }
+
+  if (currIdx != noContig) counter.FinalizeAll(&result.intervals[currIdx]);
+  return result;
+}
+
+ActiveRegionIndex::ActiveRegionIndex(std::vector<ContigInfo> ctgs, std::uint32_t min_alt_cnt, std::uint32_t min_bq,
+                                     std::uint32_t bin_length)
+    : minAltCnt(min_alt_cnt), minBaseQual(min_bq), binLength(bin_length) {
+  contigs.reserve(ctgs.size());
+  for (auto& ctg : ctgs) {
+    const auto numBins = NumBins(ctg.contigLen, binLength);
+    contigIdxs.emplace(ctg.contigName, contigs.size());
+    contigs.push_back({std::move(ctg), {}, std::vector<std::uint16_t>(numBins), std::vector<std::uint16_t>(numBins)});
+  }
+}
+
+void ActiveRegionIndex::AddSample(const SampleScan& scan, SampleLabel label) {
+  maxReadSpan = std::max(maxReadSpan, scan.maxReadSpan);
+  (label == SampleLabel::TUMOR ? tmrSource : nmlSource) = scan.source;
+
+  for (std::size_t idx = 0; idx < contigs.size() && idx < scan.intervals.size(); ++idx) {
+    auto& ctg = contigs[idx];
+
+    // union of sorted intervals from both samples, merging overlapping and adjacent intervals
+    std::vector<ActiveInterval> merged;
+    merged.reserve(ctg.intervals.size() + scan.intervals[idx].size());
+    std::merge(ctg.intervals.cbegin(), ctg.intervals.cend(), scan.intervals[idx].cbegin(), scan.intervals[idx].cend(),
+               std::back_inserter(merged),
+               [](const ActiveInterval& lhs, const ActiveInterval& rhs) { return lhs.start0 < rhs.start0; });
+
+    ctg.intervals.clear();
+    for (const auto& ivl : merged) {
+      if (!ctg.intervals.empty() && ivl.start0 <= ctg.intervals.back().end0) {
+        ctg.intervals.back().end0 = std::max(ctg.intervals.back().end0, ivl.end0);
+        continue;
+      }
+      ctg.intervals.push_back(ivl);
+    }
+
+    auto& binCov = label == SampleLabel::TUMOR ? ctg.tmrBinCov : ctg.nmlBinCov;
+    const auto& binBases = scan.binBases[idx];
+    for (std::size_t binIdx = 0; binIdx < binCov.size() && binIdx < binBases.size(); ++binIdx) {
+      // last bin of a contig is usually shorter than the bin length
+      const auto binStart = static_cast<std::int64_t>(binIdx) * binLength;
+      const auto binLen = std::min(static_cast<std::int64_t>(binLength), ctg.info.contigLen - binStart);
+      const auto depth = std::round(static_cast<double>(binBases[binIdx]) / static_cast<double>(binLen));
+      binCov[binIdx] = static_cast<std::uint16_t>(std::min(depth, double(std::numeric_limits<std::uint16_t>::max())));
+    }
+  }
+}
+
+auto ActiveRegionIndex::Write(const std::filesystem::path& out_path) const -> absl::Status {
+  std::ofstream outFh(out_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (!outFh.is_open()) {
+    return absl::PermissionDeniedError(absl::StrFormat("could not open active region index %s", out_path.string()));
+  }
+
+  outFh.write(ACTIVE_INDEX_MAGIC.data(), ACTIVE_INDEX_MAGIC.size());
+  WriteInt(outFh, ACTIVE_INDEX_VERSION);
+  WriteInt(outFh, minAltCnt);
+  WriteInt(outFh, minBaseQual);
+  WriteInt(outFh, binLength);
+  WriteInt(outFh, maxReadSpan);
+  WriteStamp(outFh, tmrSource);
+  WriteStamp(outFh, nmlSource);
+
+  WriteInt(outFh, static_cast<std::uint32_t>(contigs.size()));
+  for (const auto& ctg : contigs) {
+    WriteString(outFh, ctg.info.contigName);
+    WriteInt(outFh, ctg.info.contigLen);
+
+    WriteInt(outFh, static_cast<std::uint64_t>(ctg.intervals.size()));
+    for (const auto& ivl : ctg.intervals) {
+      WriteInt(outFh, ivl.start0);
+      WriteInt(outFh, ivl.end0);
+    }
+
+    for (const auto cov : ctg.tmrBinCov) WriteInt(outFh, cov);
+    for (const auto cov : ctg.nmlBinCov) WriteInt(outFh, cov);
+  }
+
+  outFh.close();
+  return outFh.fail()
+             ? absl::DataLossError(absl::StrFormat("could not write active region index %s", out_path.string()))
+             : absl::OkStatus();
+}
+
+auto ActiveRegionIndex::Load(const std::filesystem::path& in_path) -> absl::StatusOr<ActiveRegionIndex> {
+  std::ifstream inFh(in_path, std::ios_base::in | std::ios_base::binary);
+  if (!inFh.is_open()) {
+    return absl::NotFoundError(absl::StrFormat("could not open active region index %s", in_path.string()));
+  }
+
+  std::array<char, ACTIVE_INDEX_MAGIC.size()> magic{};
+  std::uint32_t version = 0;
+  if (!inFh.read(magic.data(), magic.size()) || magic != ACTIVE_INDEX_MAGIC || !ReadInt(inFh, &version) ||
+      version != ACTIVE_INDEX_VERSION) {
+    return absl::InvalidArgumentError(absl::StrFormat("%s is not a lancet active region index", in_path.string()));
+  }
+
+  const auto corrupt = absl::DataLossError(absl::StrFormat("corrupt active region index %s", in_path.string()));
+  std::uint32_t minAltCount = 0;
+  std::uint32_t minBq = 0;
+  std::uint32_t binLen = 0;
+  std::int64_t readSpan = 0;
+  AlignmentFileStamp tmrStamp;
+  AlignmentFileStamp nmlStamp;
+  std::uint32_t numContigs = 0;
+  if (!ReadInt(inFh, &minAltCount) || !ReadInt(inFh, &minBq) || !ReadInt(inFh, &binLen) ||
+      !ReadInt(inFh, &readSpan) || !ReadStamp(inFh, &tmrStamp) || !ReadStamp(inFh, &nmlStamp) ||
+      !ReadInt(inFh, &numContigs) || binLen == 0) {
+    return corrupt;
+  }
+
+  std::vector<ContigInfo> ctgs(numContigs);
+  std::vector<std::vector<ActiveInterval>> intervals(numContigs);
+  std::vector<std::vector<std::uint16_t>> tmrBinCovs(numContigs);
+  std::vector<std::vector<std::uint16_t>> nmlBinCovs(numContigs);
+  for (std::size_t idx = 0; idx < numContigs; ++idx) {
+    std::uint64_t numIntervals = 0;
+    if (!ReadString(inFh, &ctgs[idx].contigName) || !ReadInt(inFh, &ctgs[idx].contigLen) ||
+        !ReadInt(inFh, &numIntervals) || ctgs[idx].contigLen < 0) {
+      return corrupt;
+    }
+
+    intervals[idx].resize(numIntervals);
+    for (auto& ivl : intervals[idx]) {
+      if (!ReadInt(inFh, &ivl.start0) || !ReadInt(inFh, &ivl.end0)) return corrupt;
+    }
+
+    tmrBinCovs[idx].resize(NumBins(ctgs[idx].contigLen, binLen));
+    nmlBinCovs[idx].resize(tmrBinCovs[idx].size());
+    for (auto& cov : tmrBinCovs[idx]) {
+      if (!ReadInt(inFh, &cov)) return corrupt;
+    }
+    for (auto& cov : nmlBinCovs[idx]) {
+      if (!ReadInt(inFh, &cov)) return corrupt;
+    }
+  }
+
+  ActiveRegionIndex result(std::move(ctgs), minAltCount, minBq, binLen);
+  result.maxReadSpan = readSpan;
+  result.tmrSource = std::move(tmrStamp);
+  result.nmlSource = std::move(nmlStamp);
+  for (std::size_t idx = 0; idx < numContigs; ++idx) {
+    result.contigs[idx].intervals = std::move(intervals[idx]);
+    result.contigs[idx].tmrBinCov = std::move(tmrBinCovs[idx]);
+    result.contigs[idx].nmlBinCov = std::move(nmlBinCovs[idx]);
+  }
+
+  return result;
+}
+
+auto ActiveRegionIndex::CheckCompatible(const CliParams& params, absl::Span<const ContigInfo> ref_contigs) const
+    -> absl::Status {
+  // fewer positions can be active with a higher alt count or base quality than the scan used
+  if (params.minTmrAltCnt < minAltCnt || params.minBaseQual < minBaseQual) {
+    const auto errMsg = absl::StrFormat(
+        "active region index was built with min. tumor alt count %d and min. base quality %d, which must not be "
+        "higher than the pipeline's %d and %d",
+        minAltCnt, minBaseQual, params.minTmrAltCnt, params.minBaseQual);
+    return absl::FailedPreconditionError(errMsg);
+  }
+
+  std::vector<ContigInfo> indexContigs;
+  indexContigs.reserve(contigs.size());
+  for (const auto& ctg : contigs) indexContigs.push_back(ctg.info);
+  if (indexContigs.size() != ref_contigs.size() || !CheckContigsMatch(ref_contigs, indexContigs)) {
+    return absl::FailedPreconditionError("active region index was built with a different reference");
+  }
+
+  // an index from other alignments, or from the same files before they were rewritten, would skip active windows
+  const auto tmrStamp = StampAlignmentFile(params.tumorPath);
+  const auto nmlStamp = StampAlignmentFile(params.normalPath);
+  if (tmrStamp != tmrSource || nmlStamp != nmlSource) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "active region index was built from tumor %s and normal %s, which differ from tumor %s and normal %s or "
+        "were modified since the index was built",
+        tmrSource.path, nmlSource.path, tmrStamp.path, nmlStamp.path));
+  }
+
+  return absl::OkStatus();
+}
+
+auto ActiveRegionIndex::MayBeActive(const GenomicRegion& region) const -> bool {
+  const auto* ctg = FindContig(region.Chromosome());
+  if (ctg == nullptr) return true;
+
+  // evidence of a window comes from reads overlapping it, which end within one read span of the window
+  const auto qryStart0 = region.StartPosition1() - 1 - maxReadSpan - 1;
+  const auto qryEnd0 = region.EndPosition1() + maxReadSpan + 1;
+  const auto itr = std::upper_bound(ctg->intervals.cbegin(), ctg->intervals.cend(), qryStart0,
+                                    [](std::int64_t pos, const ActiveInterval& ivl) { return pos < ivl.end0; });
+  return itr != ctg->intervals.cend() && itr->start0 < qryEnd0;
+}
+
+auto ActiveRegionIndex::AverageCoverage(const GenomicRegion& region) const -> double {
+  const auto* ctg = FindContig(region.Chromosome());
+  if (ctg == nullptr || ctg->tmrBinCov.empty() || region.EndPosition1() < region.StartPosition1()) return 0.0;
+
+  const auto lastBin = ctg->tmrBinCov.size() - 1;
+  const auto firstIdx = std::min(static_cast<std::size_t>(std::max(region.StartPosition1() - 1, std::int64_t(0))) /
+                                     binLength, lastBin);
+  const auto lastIdx = std::min(static_cast<std::size_t>(std::max(region.EndPosition1() - 1, std::int64_t(0))) /
+                                    binLength, lastBin);
+
+  double sumCov = 0.0;
+  for (auto idx = firstIdx; idx <= lastIdx; ++idx) {
+    sumCov += (static_cast<double>(ctg->tmrBinCov[idx]) + static_cast<double>(ctg->nmlBinCov[idx])) / 2.0;
+  }
+
+  return sumCov / static_cast<double>(lastIdx - firstIdx + 1);
+}
+
+auto ActiveRegionIndex::NumActiveBases() const -> std::uint64_t {
+  std::uint64_t result = 0;
+  for (const auto& ctg : contigs) {
+    for (const auto& ivl : ctg.intervals) result += static_cast<std::uint64_t>(ivl.end0 - ivl.start0);
+  }
+  return result;
+}
+
+auto ActiveRegionIndex::NumActiveIntervals() const -> std::size_t {
+  std::size_t result = 0;
+  for (const auto& ctg : contigs) result += ctg.intervals.size();
+  return result;
+}
+
+auto ActiveRegionIndex::FindContig(const std::string& contig) const -> const ContigIndex* {
+  const auto itr = contigIdxs.find(contig);
+  return itr == contigIdxs.end() ? nullptr : &contigs[itr->second];
+}
+}  // namespace lancet
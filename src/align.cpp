@@ -61,7 +61,7 @@ static inline auto MaxScoreXY(const Cell& scorex, const Cell& scorey, int scorez
 static constexpr inline auto IsValidBase(const char& b) -> bool { return b == 'A' || b == 'C' || b == 'G' || b == 'T'; }
 
 using AlignedBases = std::pair<char, char>;
-auto Align(std::string_view ref, std::string_view qry) -> AlignedSequences {
+auto Align(std::string_view ref, std::string_view qry, const CancelToken* token) -> AlignedSequences {
   const auto refLen = ref.length();
   const auto qryLen = qry.length();
 
@@ -84,6 +84,7 @@ auto Align(std::string_view ref, std::string_view qry) -> AlignedSequences {
   // qi -> query sequence index
   // ri -> reference sequence index
   for (std::size_t qi = 1; qi <= qryLen; qi++) {
+    ThrowIfExpired(token, "path alignment");
     for (std::size_t ri = 1; ri <= refLen; ri++) {
       const auto cmpScore = Compare(ref[ri - 1], qry[qi - 1]);
       x.at(ri, qi) = MaxScoreX(x.at(ri - 1, qi).score + GAP_EXTEND_SCORE, m.at(ri - 1, qi).score + GAP_OPEN_SCORE);
@@ -0,0 +1,71 @@
+#include "lancet/alignment_evidence.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "absl/strings/ascii.h"
+
+namespace lancet {
+static void FillMDMismatches(std::string_view md, std::string_view quals, std::int64_t aln_start,
+                             std::uint32_t min_bq, std::vector<AlignmentEvidence>* result) {
+  if (aln_start < 0) return;
+  auto genomePos = static_cast<std::uint32_t>(aln_start);
+  std::string token;
+
+  for (const auto& c : md) {
+    if (absl::ascii_isdigit(static_cast<unsigned char>(c))) {
+      token += c;
+      continue;
+    }
+
+    const auto step = token.empty() ? 0 : std::strtol(token.c_str(), nullptr, 10);
+    genomePos += static_cast<std::uint32_t>(step);
+    token.clear();
+
+    const auto basePos = static_cast<std::size_t>(genomePos - aln_start);
+    if (basePos >= quals.size() || static_cast<int>(quals[basePos]) < static_cast<int>(min_bq)) continue;
+
+    const auto base = absl::ascii_toupper(static_cast<unsigned char>(c));
+    if (base == 'A' || base == 'C' || base == 'T' || base == 'G') {
+      result->push_back({genomePos, EvidenceKind::MISMATCH});
+    }
+  }
+}
+
+void CollectAlignmentEvidence(const HtsAlignment& aln, std::string_view md_tag, std::string_view quals,
+                              std::uint32_t min_bq, std::vector<AlignmentEvidence>* result) {
+  if (!md_tag.empty()) FillMDMismatches(md_tag, quals, aln.StartPosition0(), min_bq, result);
+
+  auto currGPos = static_cast<std::uint32_t>(aln.StartPosition0());
+  bool hasSoftClip = false;
+
+  for (const auto& cigUnit : aln.CigarData()) {
+    if (cigUnit.ConsumesReference()) currGPos += cigUnit.Length;
+    switch (cigUnit.Operation) {
+      case CigarOp::INSERTION:
+        result->push_back({currGPos, EvidenceKind::INSERTION});
+        break;
+      case CigarOp::DELETION:
+        result->push_back({currGPos, EvidenceKind::DELETION});
+        break;
+      case CigarOp::SEQUENCE_MISMATCH:
+        result->push_back({currGPos, EvidenceKind::MISMATCH});
+        break;
+      case CigarOp::SOFT_CLIP:
+        hasSoftClip = true;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (!hasSoftClip) return;
+
+  // softclip genome positions of the alignment, re-used across alignments
+  static thread_local std::vector<std::uint32_t> genomePositions;
+  genomePositions.clear();
+  if (aln.SoftClips(nullptr, nullptr, &genomePositions, false)) {
+    for (const auto gpos : genomePositions) result->push_back({gpos, EvidenceKind::SOFTCLIP});
+  }
+}
+}  // namespace lancet
@@ -0,0 +1,131 @@
+#include "lancet/base_decode.h"
+
+#include <array>
+
+#include "lancet/assert_macro.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LANCET_X86_DECODE_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace lancet {
+// Same IUPAC table as htslib's `seq_nt16_str`, indexed by the 4-bit base code
+static constexpr std::array<char, 16> NT16_ASCII = {'=', 'A', 'C', 'M', 'G', 'R', 'S', 'V',
+                                                    'T', 'W', 'Y', 'H', 'K', 'D', 'B', 'N'};
+
+// Even bases are stored in the high nibble of each byte, odd bases in the low nibble
+static inline auto NibbleAt(const std::uint8_t* packed, std::size_t idx) -> std::uint8_t {
+  return (packed[idx >> 1U] >> ((~idx & 1U) << 2U)) & 0xFU;  // NOLINT
+}
+
+static void DecodeScalar(const std::uint8_t* packed, std::size_t start, std::size_t count, char* out) {
+  for (std::size_t i = 0; i < count; ++i) out[i] = NT16_ASCII[NibbleAt(packed, start + i)];  // NOLINT
+}
+
+#ifdef LANCET_X86_DECODE_KERNELS
+// 8 packed bytes -> 16 bases per iteration. Nibbles are split and interleaved as byte indices for a table shuffle
+__attribute__((target("ssse3"))) static void DecodeSsse3(const std::uint8_t* packed, std::size_t count, char* out) {
+  const auto table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(NT16_ASCII.data()));  // NOLINT
+  const auto loMask = _mm_set1_epi8(0x0F);                                                    // NOLINT
+
+  std::size_t idx = 0;
+  for (; idx + 16 <= count; idx += 16) {  // NOLINT
+    const auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(packed + idx / 2));  // NOLINT
+    const auto hiNibbles = _mm_and_si128(_mm_srli_epi16(bytes, 4), loMask);                  // NOLINT
+    const auto loNibbles = _mm_and_si128(bytes, loMask);
+    const auto codes = _mm_unpacklo_epi8(hiNibbles, loNibbles);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + idx), _mm_shuffle_epi8(table, codes));  // NOLINT
+  }
+
+  DecodeScalar(packed, idx, count - idx, out + idx);
+}
+
+// 16 packed bytes -> 32 bases per iteration. Each byte is widened to a 16-bit lane holding its two nibbles in order
+__attribute__((target("avx2"))) static void DecodeAvx2(const std::uint8_t* packed, std::size_t count, char* out) {
+  const auto table128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(NT16_ASCII.data()));  // NOLINT
+  const auto table = _mm256_broadcastsi128_si256(table128);
+  const auto loMask = _mm256_set1_epi16(0x0F);  // NOLINT
+
+  std::size_t idx = 0;
+  for (; idx + 32 <= count; idx += 32) {  // NOLINT
+    const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + idx / 2));  // NOLINT
+    const auto lanes = _mm256_cvtepu8_epi16(bytes);
+    const auto hiNibbles = _mm256_and_si256(_mm256_srli_epi16(lanes, 4), loMask);  // NOLINT
+    const auto loNibbles = _mm256_slli_epi16(_mm256_and_si256(lanes, loMask), 8);  // NOLINT
+    const auto codes = _mm256_or_si256(hiNibbles, loNibbles);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + idx), _mm256_shuffle_epi8(table, codes));  // NOLINT
+  }
+
+  // calling the SSSE3 kernel for the tail would mix legacy SSE with AVX code, so the tail is decoded here
+  const auto loMask128 = _mm_set1_epi8(0x0F);  // NOLINT
+  for (; idx + 16 <= count; idx += 16) {       // NOLINT
+    const auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(packed + idx / 2));  // NOLINT
+    const auto hiNibbles = _mm_and_si128(_mm_srli_epi16(bytes, 4), loMask128);               // NOLINT
+    const auto codes = _mm_unpacklo_epi8(hiNibbles, _mm_and_si128(bytes, loMask128));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + idx), _mm_shuffle_epi8(table128, codes));  // NOLINT
+  }
+
+  DecodeScalar(packed, idx, count - idx, out + idx);
+}
+#endif
+
+static auto DetectDecodeKernel() -> DecodeKernel {
+#ifdef LANCET_X86_DECODE_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return DecodeKernel::AVX2;
+  if (__builtin_cpu_supports("ssse3")) return DecodeKernel::SSSE3;
+#endif
+  return DecodeKernel::SCALAR;
+}
+
+auto BestDecodeKernel() -> DecodeKernel {
+  static const auto kernel = DetectDecodeKernel();
+  return kernel;
+}
+
+auto ToString(DecodeKernel kernel) -> const char* {
+  switch (kernel) {
+    case DecodeKernel::AVX2:
+      return "avx2";
+    case DecodeKernel::SSSE3:
+      return "ssse3";
+    case DecodeKernel::SCALAR:
+    default:
+      return "scalar";
+  }
+}
+
+void DecodeBases(DecodeKernel kernel, const std::uint8_t* packed, std::size_t start, std::size_t count, char* out) {
+  LANCET_ASSERT(static_cast<int>(kernel) <= static_cast<int>(BestDecodeKernel()));  // NOLINT
+  if (count == 0) return;
+
+  // vector kernels start at a byte boundary, so an odd leading base is decoded separately
+  if ((start & 1U) != 0) {
+    *out = NT16_ASCII[NibbleAt(packed, start)];  // NOLINT
+    ++start;
+    --count;
+    ++out;  // NOLINT
+  }
+
+#ifdef LANCET_X86_DECODE_KERNELS
+  switch (kernel) {
+    case DecodeKernel::AVX2:
+      DecodeAvx2(packed + start / 2, count, out);  // NOLINT
+      return;
+    case DecodeKernel::SSSE3:
+      DecodeSsse3(packed + start / 2, count, out);  // NOLINT
+      return;
+    case DecodeKernel::SCALAR:
+    default:
+      break;
+  }
+#endif
+
+  DecodeScalar(packed, start, count, out);
+}
+
+void DecodeBases(const std::uint8_t* packed, std::size_t start, std::size_t count, char* out) {
+  DecodeBases(BestDecodeKernel(), packed, start, count, out);
+}
+}  // namespace lancet
@@ -0,0 +1,128 @@
+#include "lancet/checkpoint.h"
+
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include "absl/hash/internal/city.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "lancet/utils.h"
+
+namespace lancet {
+static constexpr auto JOURNAL_HEADER_TAG = "##lancet-checkpoint";
+static constexpr auto JOURNAL_EXTENSION = ".ckpt";
+static constexpr auto EMPTY_CHROM = ".";
+
+CheckpointJournal::CheckpointJournal(const std::filesystem::path& out_vcf, const CliParams& params)
+    : journalPath(out_vcf.string() + JOURNAL_EXTENSION), fingerprint(Fingerprint(params)) {}
+
+auto CheckpointJournal::LoadLast() const -> absl::StatusOr<Checkpoint> {
+  std::ifstream inFh(journalPath, std::ios_base::in);
+  if (!inFh.is_open()) {
+    return absl::NotFoundError(absl::StrFormat("could not open checkpoint journal %s", journalPath.string()));
+  }
+
+  const std::string contents((std::istreambuf_iterator<char>(inFh)), std::istreambuf_iterator<char>());
+  // ignore trailing partial record written when the previous run got killed
+  const auto lastNewline = contents.rfind('\n');
+  const auto complete =
+      lastNewline == std::string::npos ? std::string_view() : std::string_view(contents).substr(0, lastNewline);
+
+  Checkpoint result;
+  bool hasHeader = false;
+  for (const auto line : absl::StrSplit(complete, '\n', absl::SkipEmpty())) {
+    const std::vector<std::string_view> tokens = absl::StrSplit(line, '\t');
+
+    if (!hasHeader) {
+      if (tokens.size() != 2 || tokens[0] != JOURNAL_HEADER_TAG) {
+        return absl::DataLossError(absl::StrFormat("invalid header in checkpoint journal %s", journalPath.string()));
+      }
+
+      if (tokens[1] != fingerprint) {
+        return absl::FailedPreconditionError(
+            absl::StrFormat("checkpoint journal %s was written by a run with different inputs or parameters",
+                            journalPath.string()));
+      }
+
+      hasHeader = true;
+      continue;
+    }
+
+    Checkpoint ckpt;
+    if (tokens.size() != 5 || !absl::SimpleAtoi(tokens[0], &ckpt.numFlushedWindows) ||
+        !absl::SimpleAtoi(tokens[1], &ckpt.numDoneWindows) || !absl::SimpleAtoi(tokens[2], &ckpt.vcfOffset) ||
+        !absl::SimpleAtoi(tokens[4], &ckpt.lastFlushedEnd0)) {
+      return absl::DataLossError(absl::StrFormat("invalid record in checkpoint journal %s", journalPath.string()));
+    }
+
+    ckpt.lastFlushedChrom = tokens[3] == EMPTY_CHROM ? std::string() : std::string(tokens[3]);
+    result = std::move(ckpt);
+  }
+
+  if (!hasHeader) {
+    return absl::DataLossError(absl::StrFormat("empty checkpoint journal %s", journalPath.string()));
+  }
+
+  return result;
+}
+
+auto CheckpointJournal::Open(bool append) -> absl::Status {
+  journal.open(journalPath, std::ios_base::out | (append ? std::ios_base::app : std::ios_base::trunc));
+  if (!journal.is_open()) {
+    return absl::PermissionDeniedError(absl::StrFormat("could not open checkpoint journal %s", journalPath.string()));
+  }
+
+  if (!append) journal << JOURNAL_HEADER_TAG << '\t' << fingerprint << '\n' << std::flush;
+  return absl::OkStatus();
+}
+
+void CheckpointJournal::Record(const Checkpoint& ckpt) {
+  const auto chrom = ckpt.lastFlushedChrom.empty() ? std::string(EMPTY_CHROM) : ckpt.lastFlushedChrom;
+  journal << absl::StreamFormat("%d\t%d\t%d\t%s\t%d\n", ckpt.numFlushedWindows, ckpt.numDoneWindows, ckpt.vcfOffset,
+                                chrom, ckpt.lastFlushedEnd0)
+          << std::flush;
+}
+
+void CheckpointJournal::Remove() {
+  journal.close();
+  std::filesystem::remove(journalPath);
+}
+
+auto CheckpointJournal::Fingerprint(const CliParams& params) -> std::string {
+  // inputs and outputs
+  auto fields = absl::StrFormat("%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|%s|", params.referencePath, params.tumorPath,
+                                params.normalPath, absl::StrJoin(params.inRegions, ","), params.bedFilePath,
+                                params.activeRegionsPath, params.outputFormat, params.evidencePath,
+                                params.timedOutBedPath, params.outGraphsDir,
+                                absl::StrJoin(params.filterProfiles, ";"), params.shardSpec);
+
+  // window layout
+  absl::StrAppendFormat(&fields, "%d|%d|%d|%d|%d/%d|", params.regionPadLength, params.windowLength,
+                        params.pctOverlap, params.maxIndelLength, params.shardIdx, params.numShards);
+
+  // read filters and assembly
+  absl::StrAppendFormat(&fields, "%.17g|%.17g|%.17g|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|", params.minCovRatio,
+                        params.maxWindowCov, params.windowTimeBudget, params.minKmerSize, params.maxKmerSize,
+                        params.trimBelowQual, params.minGraphTipLength, params.minAnchorCov, params.minNodeCov,
+                        params.graphTraversalLimit, params.minBaseQual, params.minReadMappingQual,
+                        params.minReadAsXsDiff);
+
+  // variant filters and STR annotation
+  absl::StrAppendFormat(&fields, "%.17g|%.17g|%.17g|%.17g|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|", params.minTmrVAF,
+                        params.maxNmlVAF, params.minFisher, params.minSTRFisher, params.maxRptMismatch,
+                        params.minStrandCnt, params.minTmrAltCnt, params.maxNmlAltCnt, params.minTmrCov,
+                        params.minNmlCov, params.maxTmrCov, params.maxNmlCov, params.maxSTRUnitLength,
+                        params.minSTRUnits, params.minSTRLen, params.maxSTRDist);
+
+  absl::StrAppendFormat(&fields, "%d%d%d%d%d%d%d%d", params.activeRegionOff, params.kmerRecoveryOn,
+                        params.skipMultipleHits, params.skipSecondary, params.tenxMode, params.extractReadPairs,
+                        params.noCtgCheck, params.useOverlapReads);
+
+  const auto hash = absl::hash_internal::CityHash64WithSeeds(fields.c_str(), fields.length(), utils::PRIME_0,
+                                                             utils::PRIME_1);
+  return absl::StrFormat("%016x", hash);
+}
+}  // namespace lancet
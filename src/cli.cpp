@@ -17,12 +17,19 @@
 #include "generated/lancet_version.h"
 #include "lancet/cli_params.h"
 #include "lancet/log_macros.h"
+#include "lancet/merge_vcfs.h"
+#include "lancet/refilter_vcf.h"
 #include "lancet/run_pipeline.h"
+#include "lancet/scan_active_regions.h"
 #include "spdlog/sinks/stdout_color_sinks-inl.h"
 #include "spdlog/spdlog.h"
 
 namespace lancet {
 auto PipelineSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void;
+auto MergeSubcmd(CLI::App* app, std::shared_ptr<MergeParams> params) -> void;
+auto RefilterSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void;
+auto ScanSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void;
+auto AddFilterOptions(CLI::App* subcmd, CliParams* params) -> void;
 
 auto RunCli(int argc, char** argv) noexcept -> int {
   absl::InitializeSymbolizer(argv[0]);  // NOLINT
@@ -42,6 +49,15 @@ auto RunCli(int argc, char** argv) noexcept -> int {
   const auto pipelineParams = std::make_shared<CliParams>();
   PipelineSubcmd(&app, pipelineParams);
 
+  const auto mergeParams = std::make_shared<MergeParams>();
+  MergeSubcmd(&app, mergeParams);
+
+  const auto refilterParams = std::make_shared<CliParams>();
+  RefilterSubcmd(&app, refilterParams);
+
+  const auto scanParams = std::make_shared<CliParams>();
+  ScanSubcmd(&app, scanParams);
+
   static const auto printVersion = [](std::size_t count) -> void {
     if (count <= 0) return;
     std::cout << absl::StreamFormat("Lancet %s\n", lancet::LONG_VERSION);
@@ -58,6 +74,8 @@ auto RunCli(int argc, char** argv) noexcept -> int {
   for (auto idx = 1; idx < argc; idx++) {
     absl::StrAppend(&pipelineParams->commandLine, " ", argv[idx]);  // NOLINT
   }
+  refilterParams->commandLine = pipelineParams->commandLine;
+  mergeParams->commandLine = pipelineParams->commandLine;
 
   app.set_help_flag();
   app.failure_message(CLI::FailureMessage::help);
@@ -77,6 +95,42 @@ auto RunCli(int argc, char** argv) noexcept -> int {
   return EXIT_SUCCESS;
 }
 
+// Filters are applied when variants are written, so pipeline and refilter share the same options
+auto AddFilterOptions(CLI::App* subcmd, CliParams* params) -> void {  // NOLINT
+  subcmd->add_option("-c,--max-nml-alt-cnt", params->maxNmlAltCnt, "Max. ALT allele count in normal sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("-C,--min-tmr-alt-cnt", params->minTmrAltCnt, "Min. ALT allele count in tumor sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("-v,--max-nml-vaf", params->maxNmlVAF, "Max. variant allele frequency in normal sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("-V,--min-tmr-vaf", params->minTmrVAF, "Min. variant allele frequency in tumor sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("--min-nml-cov", params->minNmlCov, "Min. variant coverage in the normal sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("--min-tmr-cov", params->minTmrCov, "Min. variant coverage in the tumor sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("--max-nml-cov", params->maxNmlCov, "Max. variant coverage in the normal sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("--max-tmr-cov", params->maxTmrCov, "Max. variant coverage in the tumor sample", true)
+      ->group("Filters");
+
+  subcmd->add_option("--min-fisher", params->minFisher, "Min. phred scaled score for somatic variants", true)
+      ->group("Filters");
+
+  subcmd->add_option("--min-str-fisher", params->minSTRFisher, "Min. phred scaled score for STR variants", true)
+      ->group("Filters");
+
+  subcmd->add_option("--min-strand-cnt", params->minStrandCnt, "Min. per strand contribution for a variant", true)
+      ->group("Filters");
+}
+
 auto PipelineSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void {  // NOLINT
   auto* subcmd = app->add_subcommand("pipeline", "Run Lancet variant calling pipeline");
 
@@ -120,12 +174,26 @@ auto PipelineSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void {
       ->group("Regions")
       ->check(CLI::Range(std::uint32_t(5), std::uint32_t(95)));
 
+  subcmd->add_option("--shard", params->shardSpec, "Process only one of N equal slices of windows (use lancet merge)")
+      ->group("Regions")
+      ->type_name("SHARD/TOTAL");
+
   // Parameters
   const auto maxNumThreads = static_cast<std::uint32_t>(std::thread::hardware_concurrency());
   subcmd->add_option("-T,--num-threads", params->numWorkerThreads, "Number of additional worker threads", true)
       ->group("Parameters")
       ->check(CLI::Range(std::uint32_t(1), maxNumThreads));
 
+  subcmd
+      ->add_option("--num-hts-threads", params->numHtsThreads,
+                   "Shared threads for BAM/CRAM decompression and VCF compression", true)
+      ->group("Parameters")
+      ->check(CLI::Range(std::uint32_t(0), maxNumThreads));
+
+  subcmd->add_option("--num-prefetch-threads", params->numPrefetchThreads, "Threads to prefetch window reads", true)
+      ->group("Parameters")
+      ->check(CLI::Range(std::uint32_t(0), maxNumThreads));
+
   subcmd->add_option("-k,--min-kmer-length", params->minKmerSize, "Min. kmer length for graph nodes", true)
       ->group("Parameters")
       ->check(CLI::Range(std::uint32_t(11), std::uint32_t(99)));
@@ -185,39 +253,7 @@ auto PipelineSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void {
   subcmd->add_option("--max-str-dist", params->maxSTRDist, "Max. distance (in bp) of variant from the STR motif", true)
       ->group("STR parameters");
 
-  // Filters
-  subcmd->add_option("-c,--max-nml-alt-cnt", params->maxNmlAltCnt, "Max. ALT allele count in normal sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("-C,--min-tmr-alt-cnt", params->minTmrAltCnt, "Min. ALT allele count in tumor sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("-v,--max-nml-vaf", params->maxNmlVAF, "Max. variant allele frequency in normal sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("-V,--min-tmr-vaf", params->minTmrVAF, "Min. variant allele frequency in tumor sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("--min-nml-cov", params->minNmlCov, "Min. variant coverage in the normal sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("--min-tmr-cov", params->minTmrCov, "Min. variant coverage in the tumor sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("--max-nml-cov", params->maxNmlCov, "Max. variant coverage in the normal sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("--max-tmr-cov", params->maxTmrCov, "Max. variant coverage in the tumor sample", true)
-      ->group("Filters");
-
-  subcmd->add_option("--min-fisher", params->minFisher, "Min. phred scaled score for somatic variants", true)
-      ->group("Filters");
-
-  subcmd->add_option("--min-str-fisher", params->minSTRFisher, "Min. phred scaled score for STR variants", true)
-      ->group("Filters");
-
-  subcmd->add_option("--min-strand-cnt", params->minStrandCnt, "Min. per strand contribution for a variant", true)
-      ->group("Filters");
+  AddFilterOptions(subcmd, params.get());
 
   // Feature flags
   subcmd->add_flag("--verbose", params->verboseLogging, "Turn on verbose logging")->group("Flags");
@@ -231,12 +267,43 @@ auto PipelineSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void {
       ->group("Flags");
   subcmd->add_flag("--use-overlap-reads", params->useOverlapReads, "Use reads overlapping windows to build graph")
       ->group("Flags");
+  subcmd->add_flag("--resume", params->resumeRun, "Resume interrupted run using checkpoint journal of output VCF")
+      ->group("Flags");
 
   // Optional
   subcmd->add_option("--graphs-dir", params->outGraphsDir, "Output path to dump serialized graphs for the run", true)
       ->check(CLI::NonexistentPath | CLI::ExistingDirectory)
       ->group("Optional");
 
+  subcmd->add_option("--window-time-budget", params->windowTimeBudget, "Max. seconds to assemble a window", true)
+      ->group("Optional")
+      ->check(CLI::NonNegativeNumber);
+
+  subcmd->add_option("--timed-out-bed", params->timedOutBedPath, "Output BED with windows that exceeded time budget")
+      ->group("Optional");
+
+  subcmd->add_option("--output-format", params->outputFormat, "Format of output variants, vcf or bcf", true)
+      ->group("Optional")
+      ->check(CLI::IsMember({"vcf", "bcf"}));
+
+  subcmd->add_option("--max-store-mem", params->maxStoreMemMb, "Max. MB of variants in memory before spilling", true)
+      ->group("Optional")
+      ->check(CLI::Range(std::uint32_t(0), MAX_STORE_MEM_MB));
+
+  subcmd
+      ->add_option("--filter-profile", params->filterProfiles,
+                    "One or more extra outputs with other filters, written next to output VCF as <out>.NAME.vcf")
+      ->group("Optional")
+      ->type_name("NAME:KEY=VALUE[,KEY=VALUE...]");
+
+  subcmd->add_option("--evidence", params->evidencePath, "Output binary evidence file for use with lancet refilter")
+      ->group("Optional")
+      ->check(CLI::NonexistentPath);
+
+  subcmd->add_option("--active-regions", params->activeRegionsPath, "Active region index from lancet scan")
+      ->group("Optional")
+      ->check(CLI::ExistingFile);
+
   // clang-format off
   // http://patorjk.com/software/taag/#p=display&f=Big%20Money-nw&t=Lancet
   static constexpr auto logo = R"raw(
@@ -260,4 +327,110 @@ auto PipelineSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void {
     RunPipeline(params);
   });
 }
+
+auto MergeSubcmd(CLI::App* app, std::shared_ptr<MergeParams> params) -> void {  // NOLINT
+  auto* subcmd = app->add_subcommand("merge", "Merge sorted VCFs from lancet pipeline runs with --shard");
+
+  // Required
+  subcmd->add_option("-r,--reference", params->referencePath, "Path to reference FASTA file")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile);
+
+  subcmd->add_option("-o,--out-vcf", params->outVcfPath, "Path to output merged VCF file")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile | CLI::NonexistentPath);
+
+  subcmd->add_option("in-vcfs", params->inVcfPaths, "Paths to sorted shard VCF files to merge")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile);
+
+  subcmd->callback([params]() -> void {
+    LOG_INFO("Initializing Lancet, {}", lancet::LONG_VERSION);
+    RunMerge(params);
+  });
+}
+
+auto RefilterSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void {  // NOLINT
+  auto* subcmd = app->add_subcommand("refilter", "Re-apply filters to variants from lancet pipeline --evidence file");
+
+  // Required
+  subcmd->add_option("-e,--evidence", params->evidencePath, "Path to evidence file from lancet pipeline")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile);
+
+  subcmd->add_option("-o,--out-vcf", params->outVcfPath, "Path to output VCF file")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile | CLI::NonexistentPath);
+
+  // Parameters
+  const auto maxNumThreads = static_cast<std::uint32_t>(std::thread::hardware_concurrency());
+  subcmd->add_option("--num-hts-threads", params->numHtsThreads, "Shared threads for VCF compression", true)
+      ->group("Parameters")
+      ->check(CLI::Range(std::uint32_t(0), maxNumThreads));
+
+  AddFilterOptions(subcmd, params.get());
+
+  // Optional
+  subcmd->add_option("--output-format", params->outputFormat, "Format of output variants, vcf or bcf", true)
+      ->group("Optional")
+      ->check(CLI::IsMember({"vcf", "bcf"}));
+
+  subcmd->callback([params]() -> void {
+    LOG_INFO("Initializing Lancet, {}", lancet::LONG_VERSION);
+    RunRefilter(params);
+  });
+}
+
+auto ScanSubcmd(CLI::App* app, std::shared_ptr<CliParams> params) -> void {  // NOLINT
+  auto* subcmd = app->add_subcommand("scan", "Build active region index of BAM/CRAMs for lancet pipeline");
+
+  // Required
+  subcmd->add_option("-t,--tumor", params->tumorPath, "Path to tumor BAM/CRAM file")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile);
+
+  subcmd->add_option("-n,--normal", params->normalPath, "Path to normal BAM/CRAM file")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile);
+
+  subcmd->add_option("-r,--reference", params->referencePath, "Path to reference FASTA file")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::ExistingFile);
+
+  subcmd->add_option("-o,--out-regions", params->activeRegionsPath, "Path to output active region index")
+      ->required(true)
+      ->group("Required")
+      ->check(CLI::NonexistentPath);
+
+  // Parameters
+  const auto maxNumThreads = static_cast<std::uint32_t>(std::thread::hardware_concurrency());
+  subcmd->add_option("--num-hts-threads", params->numHtsThreads, "Shared threads for BAM/CRAM decompression", true)
+      ->group("Parameters")
+      ->check(CLI::Range(std::uint32_t(0), maxNumThreads));
+
+  subcmd->add_option("-q,--min-base-qual", params->minBaseQual, "Min. base quality to consider for SNV calling", true)
+      ->group("Parameters")
+      ->check(CLI::Range(std::uint32_t(0), std::uint32_t(30)));
+
+  subcmd->add_option("-C,--min-tmr-alt-cnt", params->minTmrAltCnt, "Min. ALT allele count in tumor sample", true)
+      ->group("Parameters");
+
+  // Feature flags
+  subcmd->add_flag("--verbose", params->verboseLogging, "Turn on verbose logging")->group("Flags");
+  subcmd->add_flag("--no-contig-check", params->noCtgCheck, "Skip checking for same contigs in BAM/CRAMs and reference")
+      ->group("Flags");
+
+  subcmd->callback([params]() -> void {
+    LOG_INFO("Initializing Lancet, {}", lancet::LONG_VERSION);
+    RunScan(params);
+  });
+}
 }  // namespace lancet
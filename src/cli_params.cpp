@@ -1,13 +1,20 @@
 #include "lancet/cli_params.h"
 
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "lancet/contig_info.h"
 #include "lancet/fasta_reader.h"
+#include "lancet/filter_profile.h"
 #include "lancet/hts_reader.h"
 #include "lancet/log_macros.h"
+#include "lancet/vcf_writer.h"
 #include "spdlog/spdlog.h"
 
 namespace lancet {
-static const auto TagPresent = [](const CliParams& p, const char* tag) -> bool {
+static const auto TagPresent = [](const CliParams& p, const char (&tag)[3]) -> bool {  // NOLINT
   return HasTag(p.tumorPath, p.referencePath, tag) || HasTag(p.normalPath, p.referencePath, tag);
 };
 
@@ -20,13 +27,58 @@ static const auto RefContigsMatch = [](const CliParams& p) -> bool {
          CheckContigsMatch(rdrN.ContigsInfo(), refFa.ContigsInfo());
 };
 
+static const auto ParseShardSpec = [](const std::string& spec, std::uint32_t* shard, std::uint32_t* total) -> bool {
+  const std::vector<std::string> tokens = absl::StrSplit(spec, '/');
+  if (tokens.size() != 2 || !absl::SimpleAtoi(tokens[0], shard) || !absl::SimpleAtoi(tokens[1], total)) return false;
+  return *total >= 1 && *shard >= 1 && *shard <= *total;
+};
+
 auto CliParams::ValidateParams() -> bool {
+  if (!shardSpec.empty() && !ParseShardSpec(shardSpec, &shardIdx, &numShards)) {
+    LOG_ERROR("Invalid shard {}. Expected shard in the format SHARD/TOTAL with 1 <= SHARD <= TOTAL", shardSpec);
+    return false;
+  }
+
+  if (maxStoreMemMb != 0 && maxStoreMemMb < MIN_STORE_MEM_MB) {
+    LOG_ERROR("Invalid max. store memory {} MB. Expected 0 to never spill or at least {} MB", maxStoreMemMb,
+              MIN_STORE_MEM_MB);
+    return false;
+  }
+
+  if (!ValidateOutputFormat()) return false;
+
+  if (resumeRun && (outputFormat == "bcf" || VcfWriter::IsCompressedPath(outVcfPath))) {
+    LOG_ERROR("Resuming interrupted runs is only supported for uncompressed VCF output {}", outVcfPath);
+    return false;
+  }
+
+  if (resumeRun && !evidencePath.empty()) {
+    LOG_ERROR("Resuming interrupted runs is not supported when writing evidence file {}", evidencePath);
+    return false;
+  }
+
+  if (resumeRun && !filterProfiles.empty()) {
+    LOG_ERROR("Resuming interrupted runs is not supported with filter profiles");
+    return false;
+  }
+
+  if (const auto profiles = ParseFilterProfiles(*this); !profiles.ok()) {
+    LOG_ERROR(profiles.status().message());
+    return false;
+  }
+
   // ensure MD tag is present when active region is not turned off
   if (!activeRegionOff && !TagPresent(*this, "MD")) {
     LOG_WARN("MD tag is missing from tumor and normal BAMs/CRAMs. Turning off active region detection.");
     activeRegionOff = true;
   }
 
+  // windows are skipped with the index only when they would be skipped by active region detection
+  if (activeRegionOff && !activeRegionsPath.empty()) {
+    LOG_WARN("Active region detection is turned off. Ignoring active region index {}", activeRegionsPath);
+    activeRegionsPath.clear();
+  }
+
   // ensure HP and BX tags are present when tenxMode is turned on
   if (tenxMode) {
     if (!TagPresent(*this, "BX")) {
@@ -47,4 +99,15 @@ auto CliParams::ValidateParams() -> bool {
 
   return true;
 }
+
+auto CliParams::ValidateOutputFormat() const -> bool {
+  const auto isBcf = outputFormat == "bcf";
+  if (isBcf != absl::EndsWith(outVcfPath, ".bcf")) {
+    LOG_ERROR("Output {} does not match output format {}. Expected .bcf extension only for bcf output", outVcfPath,
+              outputFormat);
+    return false;
+  }
+
+  return true;
+}
 }  // namespace lancet
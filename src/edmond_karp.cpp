@@ -10,9 +10,17 @@
 #include "spdlog/spdlog.h"
 
 namespace lancet {
+// Number of BFS visits between consecutive checks of the cancellation token
+static constexpr std::uint32_t VISITS_PER_CANCEL_CHECK = 1024;
+
 EdmondKarpMaxFlow::EdmondKarpMaxFlow(const Graph::NodeContainer *nc, std::size_t kmer_size, std::size_t max_path_len,
-                                     std::uint32_t bfs_limit, bool is_tenx_mode)
-    : nodesMap(nc), kmerSize(kmer_size), maxPathLen(max_path_len), bfsLimit(bfs_limit), isTenxMode(is_tenx_mode) {
+                                     std::uint32_t bfs_limit, bool is_tenx_mode, const CancelToken *token)
+    : nodesMap(nc),
+      kmerSize(kmer_size),
+      maxPathLen(max_path_len),
+      bfsLimit(bfs_limit),
+      isTenxMode(is_tenx_mode),
+      cancelToken(token) {
   LANCET_ASSERT(nodesMap != nullptr);  // NOLINT
 
   const auto srcItr = nodesMap->find(MOCK_SOURCE_ID);
@@ -37,6 +45,7 @@ auto EdmondKarpMaxFlow::NextPath() -> std::unique_ptr<Path> {
   while (!candidateBuilders.empty()) {
     numVisits++;
     if (numVisits > bfsLimit) break;
+    if (numVisits % VISITS_PER_CANCEL_CHECK == 0) ThrowIfExpired(cancelToken, "graph path traversal");
 
     auto &currBuilder = candidateBuilders.front();
     const auto *lastNode = (currBuilder.NumNodes() == 0 && numVisits == 1) ? sourcePtr : currBuilder.LastNode();
@@ -0,0 +1,96 @@
+#include "lancet/filter_profile.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+
+namespace lancet {
+// Only thresholds applied when variants are written can differ between profiles, assembly is shared by all of them
+static auto SetFilter(CliParams* p, std::string_view key, std::string_view value) -> bool {
+  const std::array<std::pair<std::string_view, std::uint32_t*>, 7> countFilters{
+      std::pair{"max-nml-alt-cnt", &p->maxNmlAltCnt}, std::pair{"min-tmr-alt-cnt", &p->minTmrAltCnt},
+      std::pair{"min-nml-cov", &p->minNmlCov},         std::pair{"min-tmr-cov", &p->minTmrCov},
+      std::pair{"max-nml-cov", &p->maxNmlCov},         std::pair{"max-tmr-cov", &p->maxTmrCov},
+      std::pair{"min-strand-cnt", &p->minStrandCnt}};
+
+  const std::array<std::pair<std::string_view, double*>, 4> scoreFilters{
+      std::pair{"max-nml-vaf", &p->maxNmlVAF}, std::pair{"min-tmr-vaf", &p->minTmrVAF},
+      std::pair{"min-fisher", &p->minFisher}, std::pair{"min-str-fisher", &p->minSTRFisher}};
+
+  for (const auto& [name, field] : countFilters) {
+    if (name == key) return absl::SimpleAtoi(value, field);
+  }
+
+  for (const auto& [name, field] : scoreFilters) {
+    if (name == key) return absl::SimpleAtod(value, field);
+  }
+
+  return false;
+}
+
+static inline auto IsValidName(std::string_view name) -> bool {
+  if (name.empty()) return false;
+  for (const auto base : name) {
+    if (!absl::ascii_isalnum(static_cast<unsigned char>(base)) && base != '_' && base != '-') return false;
+  }
+  return true;
+}
+
+auto ParseFilterProfiles(const CliParams& params) -> absl::StatusOr<std::vector<FilterProfile>> {
+  std::vector<FilterProfile> result;
+  result.reserve(params.filterProfiles.size());
+  absl::flat_hash_set<std::string> seenNames;
+
+  for (const auto& spec : params.filterProfiles) {
+    const std::pair<std::string, std::string> nameAndFilters = absl::StrSplit(spec, absl::MaxSplits(':', 1));
+    const auto& [name, filters] = nameAndFilters;
+    if (!IsValidName(name)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "invalid filter profile %s, expected NAME:KEY=VALUE[,KEY=VALUE...] with NAME of letters, digits, _ or -",
+          spec));
+    }
+
+    if (!seenNames.insert(name).second) {
+      return absl::InvalidArgumentError(absl::StrFormat("filter profile %s is specified more than once", name));
+    }
+
+    FilterProfile profile{name, ProfileOutputPath(params.outVcfPath, name), params};
+    for (const std::string_view item : absl::StrSplit(filters, ',', absl::SkipEmpty())) {
+      const std::pair<std::string_view, std::string_view> keyValue = absl::StrSplit(item, absl::MaxSplits('=', 1));
+      if (!SetFilter(&profile.params, keyValue.first, keyValue.second)) {
+        return absl::InvalidArgumentError(absl::StrFormat("invalid filter %s in filter profile %s", item, name));
+      }
+    }
+
+    // active regions are detected once for all outputs with the pipeline min-tmr-alt-cnt, so regions with fewer
+    // tumor ALT reads are never assembled and a lower profile value would silently have no effect
+    if (profile.params.minTmrAltCnt < params.minTmrAltCnt) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("min-tmr-alt-cnt=%d in filter profile %s is below the pipeline --min-tmr-alt-cnt %d",
+                          profile.params.minTmrAltCnt, name, params.minTmrAltCnt));
+    }
+
+    result.emplace_back(std::move(profile));
+  }
+
+  return result;
+}
+
+auto ProfileOutputPath(const std::string& out_path, const std::string& name) -> std::string {
+  for (const std::string_view ext : {".vcf.gz", ".vcf", ".bcf"}) {
+    if (!absl::EndsWith(out_path, ext)) continue;
+    const auto stem = std::string_view(out_path).substr(0, out_path.length() - ext.length());
+    return absl::StrFormat("%s.%s%s", stem, name, ext);
+  }
+
+  return absl::StrFormat("%s.%s", out_path, name);
+}
+}  // namespace lancet
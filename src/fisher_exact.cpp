@@ -1,11 +1,66 @@
 #include "lancet/fisher_exact.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <limits>
+#include <vector>
 
 #include "htslib/kfunc.h"
+#include "lancet/assert_macro.h"
 
 namespace lancet {
+// Direct mapped cache of recent scores per thread. Sized to cover distinct tables seen across a few windows
+static constexpr std::size_t SCORE_CACHE_BITS = 12;
+static constexpr std::size_t SCORE_CACHE_SIZE = std::size_t(1) << SCORE_CACHE_BITS;
+static constexpr std::uint64_t EMPTY_CACHE_KEY = std::numeric_limits<std::uint64_t>::max();
+static constexpr int MAX_CACHED_COUNT = std::numeric_limits<std::uint16_t>::max() - 1;
+
+// log(k!) for k in [0, size). Written once by `InitLogFactorialTable` before workers start, read-only after that
+static std::vector<double> logFactorials;  // NOLINT
+
+struct CachedScore {
+  std::uint64_t key = EMPTY_CACHE_KEY;
+  double score = 0.0;
+};
+
+static inline auto LogFactorial(int k) -> double {
+  const auto idx = static_cast<std::size_t>(k);
+  // same lgamma(k + 1) that kt_fisher_exact computes, so that table lookups are bit-identical to it
+  return idx < logFactorials.size() ? logFactorials[idx] : std::lgamma(k + 1);
+}
+
+static inline auto LogBinomial(int n, int k) -> double {
+  if (k == 0 || n == k) return 0;
+  return LogFactorial(n) - LogFactorial(k) - LogFactorial(n - k);
+}
+
+static inline auto PhredScaledProbability(double prob) -> double {
+  if (prob == 1.0) return 0.0;
+  if (prob == 0.0) return -10.0 * std::log10(1 / std::numeric_limits<double>::max());  // NOLINT
+  return -10.0 * std::log10(prob);                                                     // NOLINT
+}
+
+// Probability of the table computed exactly as `kt_fisher_exact` computes its return value
+static auto TableProbability(int n_11, int n_12, int n_21, int n_22) -> double {
+  const auto n1_ = n_11 + n_12;
+  const auto n_1 = n_11 + n_21;
+  const auto n = n_11 + n_12 + n_21 + n_22;
+
+  const auto maxN11 = n_1 < n1_ ? n_1 : n1_;
+  const auto minN11 = std::max(n1_ + n_1 - n, 0);
+  if (minN11 == maxN11) return 1.0;
+
+  return std::exp(LogBinomial(n1_, n_11) + LogBinomial(n - n1_, n_1 - n_11) - LogBinomial(n, n_1));
+}
+
+static inline auto CacheKey(int n_11, int n_12, int n_21, int n_22) -> std::uint64_t {
+  const auto cacheable = [](int cnt) { return cnt >= 0 && cnt <= MAX_CACHED_COUNT; };
+  if (!cacheable(n_11) || !cacheable(n_12) || !cacheable(n_21) || !cacheable(n_22)) return EMPTY_CACHE_KEY;
+  return (static_cast<std::uint64_t>(n_11) << 48U) | (static_cast<std::uint64_t>(n_12) << 32U) |  // NOLINT
+         (static_cast<std::uint64_t>(n_21) << 16U) | static_cast<std::uint64_t>(n_22);            // NOLINT
+}
 
 auto FisherTest(int n_11, int n_12, int n_21, int n_22) -> FisherExactResult {
   FisherExactResult result;
@@ -13,9 +68,35 @@ auto FisherTest(int n_11, int n_12, int n_21, int n_22) -> FisherExactResult {
   return result;
 }
 
-auto PhredScaled(const FisherExactResult &result) -> double {
-  if (result.probability == 1.0) return 0.0;
-  if (result.probability == 0.0) return -10.0 * std::log10(1 / std::numeric_limits<double>::max());  // NOLINT
-  return -10.0 * std::log10(result.probability);                                                     // NOLINT
+auto PhredScaled(const FisherExactResult &result) -> double { return PhredScaledProbability(result.probability); }
+
+void InitLogFactorialTable(std::size_t max_total) {
+  logFactorials.resize(max_total + 1);
+  for (std::size_t k = 0; k <= max_total; ++k) logFactorials[k] = std::lgamma(static_cast<int>(k) + 1);
+}
+
+auto PhredFisherScore(int n_11, int n_12, int n_21, int n_22) -> double {
+  static thread_local std::array<CachedScore, SCORE_CACHE_SIZE> cache;
+
+  const auto key = CacheKey(n_11, n_12, n_21, n_22);
+  if (key == EMPTY_CACHE_KEY) return PhredScaledProbability(TableProbability(n_11, n_12, n_21, n_22));
+
+  // fibonacci hashing spreads nearby count tuples across the cache
+  const auto slot = (key * 0x9E3779B97F4A7C15ULL) >> (64U - SCORE_CACHE_BITS);  // NOLINT
+  auto& entry = cache[slot];
+  if (entry.key != key) {
+    entry.key = key;
+    entry.score = PhredScaledProbability(TableProbability(n_11, n_12, n_21, n_22));
+  }
+
+  return entry.score;
+}
+
+void PhredFisherScores(absl::Span<const FisherCounts> tables, absl::Span<double> scores) {
+  LANCET_ASSERT(tables.size() == scores.size());  // NOLINT
+  for (std::size_t idx = 0; idx < tables.size(); ++idx) {
+    const auto& tbl = tables[idx];
+    scores[idx] = PhredFisherScore(tbl.n11, tbl.n12, tbl.n21, tbl.n22);
+  }
 }
 }  // namespace lancet
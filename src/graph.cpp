@@ -22,8 +22,13 @@
 
 namespace lancet {
 Graph::Graph(std::shared_ptr<const RefWindow> w, Graph::NodeContainer&& data, double avg_cov, std::size_t k,
-             std::shared_ptr<const CliParams> p)
-    : window(std::move(w)), avgSampleCov(avg_cov), kmerSize(k), params(std::move(p)), nodesMap(std::move(data)) {}
+             std::shared_ptr<const CliParams> p, const CancelToken* token)
+    : window(std::move(w)),
+      avgSampleCov(avg_cov),
+      kmerSize(k),
+      params(std::move(p)),
+      nodesMap(std::move(data)),
+      cancelToken(token) {}
 
 void Graph::ProcessGraph(RefInfos&& ref_infos, std::vector<Variant>* results) {
   Timer timer;
@@ -35,6 +40,7 @@ void Graph::ProcessGraph(RefInfos&& ref_infos, std::vector<Variant>* results) {
   const auto componentsInfo = MarkConnectedComponents();
 
   for (const auto& comp : componentsInfo) {
+    ThrowIfExpired(cancelToken, "graph processing");
     const auto markResult = MarkSourceSink(comp.ID);
     if (!markResult.foundSrcAndSnk) continue;
     LOG_DEBUG("Marked source and sink in component{} ({} nodes) for {}", comp.ID, comp.numNodes, windowId);
@@ -64,7 +70,8 @@ void Graph::ProcessGraph(RefInfos&& ref_infos, std::vector<Variant>* results) {
     const auto clampedRefInfos = ClampToSourceSink(ref_infos, markResult);
     const auto maxPathLength = RefAnchorLen(markResult) + static_cast<std::size_t>(params->maxIndelLength);
 
-    EdmondKarpMaxFlow flow(&nodesMap, kmerSize, maxPathLength, params->graphTraversalLimit, params->tenxMode);
+    EdmondKarpMaxFlow flow(&nodesMap, kmerSize, maxPathLength, params->graphTraversalLimit, params->tenxMode,
+                           cancelToken);
     std::vector<PathNodeIds> perPathTouches;
     auto pathPtr = flow.NextPath();
 
@@ -216,6 +223,7 @@ auto Graph::RemoveLowCovNodes(std::size_t comp_id) -> bool {
 }
 
 auto Graph::CompressGraph(std::size_t comp_id) -> bool {
+  ThrowIfExpired(cancelToken, "graph compression");
   absl::flat_hash_set<NodeIdentifier> nodesToRemove;
   for (NodeContainer::const_reference p : nodesMap) {
     if (p.second->ComponentID != comp_id || p.second->IsMockNode()) continue;
@@ -241,6 +249,7 @@ auto Graph::RemoveTips(std::size_t comp_id) -> bool {
   // remove tips and compress at least once. compression after tip removal
   // can produce new tips in the graph, so continue until there are no tips
   do {
+    ThrowIfExpired(cancelToken, "graph tip removal");
     std::vector<NodeIdentifier> nodesToRemove;
     std::for_each(nodesMap.cbegin(), nodesMap.cend(),
                   [&nodesToRemove, &comp_id, &currK, &minTipLen](NodeContainer::const_reference p) {
@@ -314,7 +323,10 @@ void Graph::ProcessPath(const Path& path, const RefInfos& ref_infos, const SrcSn
   if (utils::HammingDistWithin(refAnchorSeq, pathSeq, 5)) goto SkipLocalAlignment;  // NOLINT
 
   try {
-    rawAlignedSeqs = Align(refAnchorSeq, pathSeq);
+    rawAlignedSeqs = Align(refAnchorSeq, pathSeq, cancelToken);
+  } catch (const WindowTimeoutError&) {
+    // timeouts are handled per window by `MicroAssembler`, so they must not be turned into alignment errors
+    throw;
   } catch (...) {
     const auto errMsg = absl::StrFormat("error aligning ref: %s, qry: %s in window: %s", refAnchorSeq, pathSeq,
                                         window->ToRegionString());
@@ -18,8 +18,8 @@
 
 namespace lancet {
 GraphBuilder::GraphBuilder(std::shared_ptr<const RefWindow> w, absl::Span<const ReadInfo> reads, double avg_cov,
-                           std::shared_ptr<const CliParams> p)
-    : avgCov(avg_cov), window(std::move(w)), params(std::move(p)), sampleReads(reads) {}
+                           std::shared_ptr<const CliParams> p, const CancelToken* token)
+    : avgCov(avg_cov), window(std::move(w)), params(std::move(p)), sampleReads(reads), cancelToken(token) {}
 
 auto GraphBuilder::BuildGraph(std::size_t min_k, std::size_t max_k) -> std::unique_ptr<Graph> {
 #ifndef NDEBUG
@@ -30,6 +30,7 @@ auto GraphBuilder::BuildGraph(std::size_t min_k, std::size_t max_k) -> std::uniq
   LOG_DEBUG("Starting to build graph for {} using minK={}", windowId, min_k);
 
   for (currentK = min_k; currentK <= max_k; currentK += 2) {
+    ThrowIfExpired(cancelToken, "graph building");
     if (utils::HasRepeatKmer(window->SeqView(), currentK)) continue;
     if (utils::HasAlmostRepeatKmer(window->SeqView(), currentK, params->maxRptMismatch)) continue;
 
@@ -46,7 +47,7 @@ auto GraphBuilder::BuildGraph(std::size_t min_k, std::size_t max_k) -> std::uniq
 #ifndef NDEBUG
   LOG_DEBUG("Built graph for {} with K={} | Runtime={}", windowId, currentK, timer.HumanRuntime());
 #endif
-  return std::make_unique<Graph>(window, std::move(nodesMap), avgCov, currentK, params);
+  return std::make_unique<Graph>(window, std::move(nodesMap), avgCov, currentK, params, cancelToken);
 }
 
 void GraphBuilder::BuildSampleNodes() {
@@ -56,6 +57,7 @@ void GraphBuilder::BuildSampleNodes() {
   LANCET_ASSERT(!sampleReads.empty());  // NOLINT
 
   for (const auto& rd : sampleReads) {
+    ThrowIfExpired(cancelToken, "graph building");
     const auto result = BuildNodes(rd.sequence);
     const auto qualMers = KMovingSubstrs(rd.quality, currentK);
     LANCET_ASSERT(result.nodeIDs.size() == qualMers.size());  // NOLINT
@@ -1,9 +1,10 @@
 #include "lancet/hts_alignment.h"
 
 #include <cstddef>
+#include <string>
 
 #include "absl/strings/ascii.h"
-#include "lancet/assert_macro.h"
+#include "lancet/base_decode.h"
 
 #if defined(__clang__)
 #pragma clang diagnostic push
@@ -22,18 +23,82 @@
 #endif
 
 namespace lancet {
-auto HtsAlignment::BuildReadInfo(SampleLabel label, std::uint8_t min_bq, std::uint8_t max_kmer_size) -> ReadInfo {
-  const auto seqLen = readSequence.length();
-  const auto qualLen = readQuality.length();
-  LANCET_ASSERT(seqLen == qualLen);  // NOLINT
+static inline auto IsUsableBase(char base, std::uint8_t qual, std::uint8_t min_bq) -> bool {
+  const auto ubase = absl::ascii_toupper(static_cast<unsigned char>(base));
+  return (ubase == 'A' || ubase == 'C' || ubase == 'G' || ubase == 'T') && qual >= min_bq;
+}
+
+auto HtsAlignmentView::ReadName() const -> std::string_view { return bam_get_qname(rec); }  // NOLINT
+
+auto HtsAlignmentView::ContigName() const -> std::string_view {
+  return rec->core.tid == -1 ? std::string_view() : std::string_view(sam_hdr_tid2name(header, rec->core.tid));
+}
+
+auto HtsAlignmentView::MateContigName() const -> std::string_view {
+  return rec->core.mtid == -1 ? std::string_view() : std::string_view(sam_hdr_tid2name(header, rec->core.mtid));
+}
+
+auto HtsAlignmentView::StartPosition0() const -> std::int64_t { return rec->core.pos; }
+auto HtsAlignmentView::EndPosition0() const -> std::int64_t { return bam_endpos(rec); }
+auto HtsAlignmentView::MateStartPosition0() const -> std::int64_t { return rec->core.mpos; }
+auto HtsAlignmentView::MappingQuality() const -> std::uint8_t { return rec->core.qual; }
+auto HtsAlignmentView::SamFlags() const -> std::uint16_t { return rec->core.flag; }
+auto HtsAlignmentView::Length() const -> std::size_t { return static_cast<std::size_t>(rec->core.l_qseq); }
+
+auto HtsAlignmentView::IsDuplicate() const -> bool { return (rec->core.flag & BAM_FDUP) != 0; }          // NOLINT
+auto HtsAlignmentView::IsSecondary() const -> bool { return (rec->core.flag & BAM_FSECONDARY) != 0; }    // NOLINT
+auto HtsAlignmentView::IsQcFailed() const -> bool { return (rec->core.flag & BAM_FQCFAIL) != 0; }        // NOLINT
+auto HtsAlignmentView::IsUnmapped() const -> bool { return (rec->core.flag & BAM_FUNMAP) != 0; }         // NOLINT
+auto HtsAlignmentView::IsReverseStrand() const -> bool { return (rec->core.flag & BAM_FREVERSE) != 0; }  // NOLINT
+
+auto HtsAlignmentView::ReadSequence() const -> std::string {
+  std::string sequence(Length(), 'N');
+  DecodeBases(bam_get_seq(rec), 0, sequence.length(), sequence.data());  // NOLINT
+  return sequence;
+}
+
+auto HtsAlignmentView::ReadQuality() const -> std::string_view {
+  const auto* seqQuals = bam_get_qual(rec);                     // NOLINT
+  return {reinterpret_cast<const char*>(seqQuals), Length()};  // NOLINT
+}
+
+auto HtsAlignmentView::CigarData() const -> AlignmentCigar {
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wold-style-cast"
+#pragma clang diagnostic ignored "-Wcast-align"
+#endif
+  const auto* rawCigarData = bam_get_cigar(rec);  // NOLINT
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+  const auto cigarLength = static_cast<std::size_t>(rec->core.n_cigar);
+  AlignmentCigar cigar;
+  cigar.reserve(cigarLength);
+  for (std::size_t i = 0; i < cigarLength; ++i) {
+    const auto op = bam_cigar_opchr(rawCigarData[i]);                     // NOLINT
+    cigar.emplace_back(CigarUnit(op, bam_cigar_oplen(rawCigarData[i])));  // NOLINT
+  }
+  return cigar;
+}
+
+auto HtsAlignmentView::TagData(const char (&tag)[3]) const -> const std::uint8_t* {  // NOLINT
+  return bam_aux_get(rec, tag);
+}
+
+auto HtsAlignmentView::BuildReadInfo(SampleLabel label, std::uint8_t min_bq, std::uint8_t max_kmer_size) const
+    -> ReadInfo {
+  const auto seqLen = Length();
+  const auto* seqBases = bam_get_seq(rec);   // NOLINT
+  const auto* seqQuals = bam_get_qual(rec);  // NOLINT
+  const auto baseAt = [&seqBases](std::size_t idx) -> char {
+    return seq_nt16_str[bam_seqi(seqBases, idx)];  // NOLINT
+  };
 
   std::size_t trim5 = 0;
   for (trim5 = 0; trim5 < seqLen; ++trim5) {
-    const auto base = absl::ascii_toupper(static_cast<unsigned char>(readSequence[trim5]));
-    if ((base == 'A' || base == 'C' || base == 'G' || base == 'T') &&
-        static_cast<std::uint8_t>(readQuality[trim5]) >= min_bq) {
-      break;
-    }
+    if (IsUsableBase(baseAt(trim5), seqQuals[trim5], min_bq)) break;  // NOLINT
   }
 
   // return empty read info
@@ -41,38 +106,44 @@ auto HtsAlignment::BuildReadInfo(SampleLabel label, std::uint8_t min_bq, std::ui
 
   std::size_t trim3 = 0;
   for (auto idx = seqLen - 1; idx == 0; --idx) {
-    const auto base = absl::ascii_toupper(static_cast<unsigned char>(readSequence[idx]));
-    if ((base == 'A' || base == 'C' || base == 'G' || base == 'T') &&
-        static_cast<std::uint8_t>(readQuality[idx]) >= min_bq) {
-      break;
-    }
+    if (IsUsableBase(baseAt(idx), seqQuals[idx], min_bq)) break;  // NOLINT
     trim3++;
   }
 
   if ((seqLen - trim5 - trim3) < static_cast<std::size_t>(max_kmer_size)) return ReadInfo{};
 
+  // decode only the bases kept after trimming
+  const auto keepLen = seqLen - trim5 - trim3;
   ReadInfo ri;
-  ri.readName = readName;
-  ri.chromName = contig;
-  ri.sequence = readSequence.substr(trim5, seqLen - trim5 - trim3);
-  ri.quality = readQuality.substr(trim5, qualLen - trim5 - trim3);
-  ri.startPos0 = startPosition0 + static_cast<std::int64_t>(trim5);
+  ri.readName = std::string(ReadName());
+  ri.chromName = std::string(ContigName());
+  ri.sequence.resize(keepLen);
+  DecodeBases(seqBases, trim5, keepLen, ri.sequence.data());
+  ri.quality = std::string(ReadQuality().substr(trim5, keepLen));
+  ri.startPos0 = StartPosition0() + static_cast<std::int64_t>(trim5);
   ri.strand = ReadStrand();
   ri.label = label;
 
-  const auto hpItr = tagsData.find("HP");
-  if (hpItr != tagsData.end()) {
-    ri.haplotypeID = static_cast<std::int8_t>(bam_aux2i(hpItr->second));
+  if (const auto* hpData = TagData("HP"); hpData != nullptr) {
+    ri.haplotypeID = static_cast<std::int8_t>(bam_aux2i(hpData));
   }
 
-  const auto bxItr = tagsData.find("BX");
-  if (bxItr != tagsData.end()) {
-    ri.tenxBarcode = bam_aux2Z(bxItr->second);
+  if (const auto* bxData = TagData("BX"); bxData != nullptr) {
+    ri.tenxBarcode = bam_aux2Z(bxData);
   }
 
   return ri;
 }
 
+void HtsAlignmentView::CopyCoreFields(HtsAlignment* result) const {
+  result->Clear();
+  result->SetStartPosition0(StartPosition0());
+  result->SetEndPosition0(EndPosition0());
+  result->SetMappingQuality(MappingQuality());
+  result->SetSamFlags(SamFlags());
+  result->SetLength(Length());
+}
+
 auto HtsAlignment::ReadStrand() const -> Strand { return IsReverseStrand() ? Strand::REV : Strand::FWD; }
 auto HtsAlignment::IsDuplicate() const -> bool { return (samFlags & BAM_FDUP) != 0; }                // NOLINT
 auto HtsAlignment::IsSupplementary() const -> bool { return (samFlags & BAM_FSUPPLEMENTARY) != 0; }  // NOLINT
@@ -89,7 +160,7 @@ auto HtsAlignment::IsRead1() const -> bool { return (samFlags & BAM_FREAD1) != 0
 auto HtsAlignment::IsRead2() const -> bool { return (samFlags & BAM_FREAD2) != 0; }                  // NOLINT
 
 auto HtsAlignment::SoftClips(std::vector<std::uint32_t> *clip_sizes, std::vector<std::uint32_t> *read_positions,
-                             std::vector<std::uint32_t> *genome_positions, bool use_padded) -> bool {
+                             std::vector<std::uint32_t> *genome_positions, bool use_padded) const -> bool {
   // initialize positions & flags
   auto refPosition = static_cast<std::uint32_t>(startPosition0);
   std::uint32_t readPosition = 0;
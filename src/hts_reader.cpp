@@ -1,7 +1,6 @@
 #include "lancet/hts_reader.h"
 
 #include <algorithm>
-#include <cerrno>
 #include <cstddef>
 #include <functional>
 #include <stdexcept>
@@ -9,7 +8,6 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
-#include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
@@ -24,6 +22,7 @@
 
 #include "htslib/hts.h"
 #include "htslib/sam.h"
+#include "htslib/thread_pool.h"
 
 #if defined(__clang__)
 #pragma clang diagnostic pop
@@ -62,17 +61,15 @@ struct Bam1Deleter {
   }
 };
 
-static inline auto GetAuxPtr(bam1_t* b, const char* tag) -> absl::StatusOr<const std::uint8_t*> {
-  const std::uint8_t* auxData = bam_aux_get(b, tag);
-  if (auxData == nullptr && errno == ENOENT) {
-    return absl::NotFoundError(absl::StrFormat("could not find tag %s in alignment", tag));
-  }
-  if (auxData == nullptr) {
-    return absl::InternalError(absl::StrFormat("could not get tag %s from alignment", tag));
+struct HtsTpoolDeleter {
+  void operator()(hts_tpool* pool) noexcept {
+    if (pool != nullptr) hts_tpool_destroy(pool);
   }
+};
 
-  return auxData;
-}
+// Shared by all readers, so that decompression of BGZF/CRAM blocks overlaps with work done by the reading thread
+static std::unique_ptr<hts_tpool, HtsTpoolDeleter> sharedTpool;  // NOLINT
+static htsThreadPool sharedHtsPool{nullptr, 0};                  // NOLINT
 
 static const inline auto ShouldSkipAlignment = [](bam1_t* b) -> bool {
   return b == nullptr || (b->core.flag & BAM_FSECONDARY) != 0 || (b->core.flag & BAM_FQCFAIL) != 0 ||  // NOLINT
@@ -116,65 +113,13 @@ class HtsReader::Impl {
     return absl::OkStatus();
   }
 
-  [[nodiscard]] auto NextAlignment(HtsAlignment* result, absl::Span<const std::string> fill_tags) -> IteratorState {
+  [[nodiscard]] auto NextAlignment(HtsAlignmentView* result) -> IteratorState {
     const auto qryResult = sam_itr_next(fp.get(), itr.get(), aln.get());
     if (qryResult == -1) return IteratorState::DONE;
     if (qryResult < -1) return IteratorState::INVALID;
-    if (ShouldSkipAlignment(aln.get())) return NextAlignment(result, fill_tags);
-
-    result->Clear();
-    result->SetReadName(bam_get_qname(aln.get()));  // NOLINT
-    result->SetStartPosition0(aln->core.pos);
-    result->SetMateStartPosition0(aln->core.mpos);
-    result->SetEndPosition0(bam_endpos(aln.get()));
-    result->SetMappingQuality(aln->core.qual);
-
-    if (aln->core.tid != -1) result->SetContig(sam_hdr_tid2name(hdr.get(), aln->core.tid));
-    if (aln->core.mtid != -1) result->SetMateContig(sam_hdr_tid2name(hdr.get(), aln->core.mtid));
-
-    const auto queryLength = static_cast<std::size_t>(aln->core.l_qseq);
-    std::string sequence(queryLength, 'N');
-    std::string quality(queryLength, static_cast<char>(0));
-
-    const auto* seqBases = bam_get_seq(aln.get());  // NOLINT
-    for (std::size_t i = 0; i < queryLength; ++i) {
-      sequence[i] = seq_nt16_str[bam_seqi(seqBases, i)];  // NOLINT
-    }
-
-    const auto* seqQuals = bam_get_qual(aln.get());  // NOLINT
-    for (std::size_t i = 0; i < queryLength; ++i) {
-      quality[i] = static_cast<char>(seqQuals[i]);  // NOLINT
-    }
-
-    result->SetReadSequence(std::move(sequence));
-    result->SetReadQuality(std::move(quality));
-    result->SetSamFlags(aln->core.flag);
-
-#if defined(__clang__)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wold-style-cast"
-#pragma clang diagnostic ignored "-Wcast-align"
-#endif
-    const auto* rawCigarData = bam_get_cigar(aln.get());  // NOLINT
-#if defined(__clang__)
-#pragma clang diagnostic pop
-#endif
-
-    const auto cigarLength = static_cast<std::size_t>(aln->core.n_cigar);
-    AlignmentCigar cigar;
-    cigar.reserve(cigarLength);
-    for (std::size_t i = 0; i < cigarLength; ++i) {
-      const auto op = bam_cigar_opchr(rawCigarData[i]);                     // NOLINT
-      cigar.emplace_back(CigarUnit(op, bam_cigar_oplen(rawCigarData[i])));  // NOLINT
-    }
-    result->SetCigar(std::move(cigar));
-
-    for (const auto& tag : fill_tags) {
-      auto auxResult = GetAuxPtr(aln.get(), tag.c_str());
-      if (!auxResult.ok()) continue;
-      result->SetTagData(tag, auxResult.value());
-    }
+    if (ShouldSkipAlignment(aln.get())) return NextAlignment(result);
 
+    *result = HtsAlignmentView(aln.get(), hdr.get());
     return IteratorState::VALID;
   }
 
@@ -251,6 +196,11 @@ class HtsReader::Impl {
       throw std::invalid_argument(errMsg);
     }
 
+    if (!AttachSharedHtsThreadPool(fp.get())) {
+      const auto errMsg = absl::StrFormat("could not attach shared thread pool to BAM/CRAM %s", inpath);
+      throw std::runtime_error(errMsg);
+    }
+
     if (fp->format.format == cram && hts_set_fai_filename(fp.get(), ref.c_str()) != 0) {
       const auto errMsg = absl::StrFormat("could not set reference path %s to read cram %s", ref, inpath);
       throw std::runtime_error(errMsg);
@@ -306,22 +256,36 @@ auto HtsReader::SetRegions(absl::Span<const GenomicRegion> regions) -> absl::Sta
   return pimpl->SetRegions(regions);
 }
 
-auto HtsReader::NextAlignment(HtsAlignment* result, absl::Span<const std::string> fill_tags) -> IteratorState {
-  return pimpl->NextAlignment(result, fill_tags);
-}
+auto HtsReader::NextAlignment(HtsAlignmentView* result) -> IteratorState { return pimpl->NextAlignment(result); }
 
 auto HtsReader::SampleNames() const -> std::vector<std::string> { return pimpl->SampleNames(); }
 auto HtsReader::ContigsInfo() const -> std::vector<ContigInfo> { return pimpl->ContigsInfo(); }
 auto HtsReader::ContigID(const std::string& contig) const -> int { return pimpl->ContigID(contig); }
 void HtsReader::ResetIterator() { return pimpl->ResetIterator(); }
 
-auto HasTag(const std::filesystem::path& inpath, const std::filesystem::path& ref, const char* tag,
+void InitSharedHtsThreadPool(int num_threads) {
+  if (num_threads <= 0 || sharedTpool != nullptr) return;
+
+  sharedTpool.reset(hts_tpool_init(num_threads));
+  if (sharedTpool == nullptr) {
+    const auto errMsg = absl::StrFormat("could not create htslib thread pool with %d threads", num_threads);
+    throw std::runtime_error(errMsg);
+  }
+
+  sharedHtsPool.pool = sharedTpool.get();
+}
+
+auto AttachSharedHtsThreadPool(htsFile* fp) -> bool {
+  return sharedHtsPool.pool == nullptr || hts_set_thread_pool(fp, &sharedHtsPool) == 0;
+}
+
+auto HasTag(const std::filesystem::path& inpath, const std::filesystem::path& ref, const char (&tag)[3],  // NOLINT
             int max_alignments_to_read) -> bool {
   HtsReader rdr(inpath, ref);
   int currentAlnCnt = 0;
 
-  HtsAlignment aln;
-  while (rdr.NextAlignment(&aln, {tag}) == HtsReader::IteratorState::VALID) {
+  HtsAlignmentView aln;
+  while (rdr.NextAlignment(&aln) == HtsReader::IteratorState::VALID) {
     if (currentAlnCnt == max_alignments_to_read) break;
 
     currentAlnCnt++;
@@ -0,0 +1,290 @@
+#include "lancet/merge_vcfs.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <queue>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "lancet/fasta_reader.h"
+#include "lancet/log_macros.h"
+#include "lancet/timer.h"
+#include "lancet/variant.h"
+#include "lancet/vcf_writer.h"
+#include "spdlog/spdlog.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#pragma clang diagnostic ignored "-Wcast-qual"
+#elif defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+
+#include "htslib/hts.h"
+#include "htslib/kseq.h"
+#include "htslib/kstring.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace lancet {
+using ContigIDs = absl::flat_hash_map<std::string, std::int64_t>;
+
+struct ShardRecord {
+  std::int64_t contigIdx = -1;
+  std::int64_t position = -1;
+  VariantID alleleHash = 0;
+  std::string ref;
+  std::string alt;
+  std::uint64_t totalDepth = 0;
+  std::string line;
+
+  // same order as `Variant::SortKey`, which shard VCFs are written in
+  [[nodiscard]] auto Key() const { return std::tie(contigIdx, position, ref, alt); }
+
+  // alleles are only compared when their hashes are equal
+  [[nodiscard]] auto IsSameVariant(const ShardRecord& other) const -> bool {
+    return alleleHash == other.alleleHash && contigIdx == other.contigIdx && position == other.position &&
+           ref == other.ref && alt == other.alt;
+  }
+};
+
+struct HtsfileDeleter {
+  void operator()(htsFile* sf) noexcept {
+    if (sf != nullptr) hts_close(sf);
+  }
+};
+
+// Reads plain text and BGZF compressed shard VCFs line by line. BCF shards are rejected, since they can not be
+// read as text lines
+class ShardVcfReader {
+ public:
+  ShardVcfReader(const std::string& path, const ContigIDs* ctg_ids)
+      : vcfPath(path), ctgIDs(ctg_ids), fp(hts_open(path.c_str(), "r")) {}
+
+  ~ShardVcfReader() { free(lineBuffer.s); }  // NOLINT
+
+  ShardVcfReader() = delete;
+  ShardVcfReader(ShardVcfReader&&) = delete;
+  auto operator=(ShardVcfReader&&) -> ShardVcfReader& = delete;
+  ShardVcfReader(const ShardVcfReader&) = delete;
+  auto operator=(const ShardVcfReader&) -> ShardVcfReader& = delete;
+
+  /// Read header lines and the first record. Returns non-OK status if the file could not be parsed
+  [[nodiscard]] auto Open() -> absl::Status {
+    if (fp == nullptr) return absl::NotFoundError(absl::StrFormat("could not open VCF %s", vcfPath));
+    if (hts_get_format(fp.get())->format == bcf) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("BCF shard %s is not supported, write shards as VCF with --output-format vcf", vcfPath));
+    }
+
+    std::string line;
+    while (true) {
+      const auto hasLine = ReadLine(&line);
+      if (!hasLine.ok()) return hasLine.status();
+      if (!*hasLine) break;
+
+      if (line.rfind('#', 0) != 0) return ParseRecord(std::move(line));
+      header += line + "\n";
+      if (line.rfind("#CHROM", 0) == 0) chromLine = line;
+    }
+
+    hasRecord = false;
+    return chromLine.empty() ? absl::DataLossError(absl::StrFormat("missing #CHROM line in VCF %s", vcfPath))
+                             : absl::OkStatus();
+  }
+
+  /// Read next record and make sure records are sorted. Returns non-OK status if the file could not be parsed
+  [[nodiscard]] auto Advance() -> absl::Status {
+    const auto prevKey = std::make_tuple(current.contigIdx, current.position, current.ref, current.alt);
+
+    std::string line;
+    const auto hasLine = ReadLine(&line);
+    if (!hasLine.ok()) return hasLine.status();
+    if (!*hasLine) {
+      hasRecord = false;
+      return absl::OkStatus();
+    }
+
+    const auto status = ParseRecord(std::move(line));
+    if (status.ok() && current.Key() < prevKey) {
+      return absl::FailedPreconditionError(absl::StrFormat("VCF %s is not sorted in reference order", vcfPath));
+    }
+
+    return status;
+  }
+
+  [[nodiscard]] auto HasRecord() const -> bool { return hasRecord; }
+  [[nodiscard]] auto Current() const -> const ShardRecord& { return current; }
+  [[nodiscard]] auto Header() const -> const std::string& { return header; }
+  [[nodiscard]] auto ChromLine() const -> const std::string& { return chromLine; }
+
+ private:
+  std::string vcfPath;
+  const ContigIDs* ctgIDs = nullptr;
+  std::unique_ptr<htsFile, HtsfileDeleter> fp;
+  kstring_t lineBuffer{0, 0, nullptr};
+  std::string header;
+  std::string chromLine;
+  ShardRecord current;
+  bool hasRecord = false;
+
+  // Read next line into `line`. Returns false once all lines are read
+  [[nodiscard]] auto ReadLine(std::string* line) -> absl::StatusOr<bool> {
+    const auto numRead = hts_getline(fp.get(), KS_SEP_LINE, &lineBuffer);
+    if (numRead < -1) return absl::DataLossError(absl::StrFormat("could not read VCF %s", vcfPath));
+    if (numRead == -1) return false;
+
+    line->assign(lineBuffer.s, lineBuffer.l);
+    return true;
+  }
+
+  [[nodiscard]] auto ParseRecord(std::string line) -> absl::Status {
+    const std::vector<std::string_view> tokens = absl::StrSplit(line, '\t');
+    static constexpr std::size_t FORMAT_IDX = 8;
+    if (tokens.size() <= FORMAT_IDX + 1) {
+      return absl::DataLossError(absl::StrFormat("invalid record in VCF %s: %s", vcfPath, line));
+    }
+
+    const auto itr = ctgIDs->find(tokens[0]);
+    if (itr == ctgIDs->end()) {
+      return absl::InvalidArgumentError(absl::StrFormat("contig %s in VCF %s is not in reference", tokens[0], vcfPath));
+    }
+
+    ShardRecord result;
+    result.contigIdx = itr->second;
+    result.ref = std::string(tokens[3]);
+    result.alt = std::string(tokens[4]);
+    result.alleleHash = Variant::AlleleHash(result.ref, result.alt);
+    if (!absl::SimpleAtoi(tokens[1], &result.position)) {
+      return absl::DataLossError(absl::StrFormat("invalid position in VCF %s: %s", vcfPath, line));
+    }
+
+    // total depth is sum of DP from all samples, same as total coverage used to de-duplicate in `VariantStore`
+    const std::vector<std::string_view> formatKeys = absl::StrSplit(tokens[FORMAT_IDX], ':');
+    const auto dpItr = std::find(formatKeys.cbegin(), formatKeys.cend(), "DP");
+    const auto dpIdx = static_cast<std::size_t>(std::distance(formatKeys.cbegin(), dpItr));
+    for (std::size_t idx = FORMAT_IDX + 1; dpItr != formatKeys.cend() && idx < tokens.size(); ++idx) {
+      const std::vector<std::string_view> values = absl::StrSplit(tokens[idx], ':');
+      std::uint64_t depth = 0;
+      if (dpIdx < values.size() && absl::SimpleAtoi(values[dpIdx], &depth)) result.totalDepth += depth;
+    }
+
+    result.line = std::move(line);
+    current = std::move(result);
+    hasRecord = true;
+    return absl::OkStatus();
+  }
+};
+
+// Header of the first shard with its `##commandLine` line, which has the shard's `--shard` option,
+// replaced by the command line of the merge
+static inline auto MergedHeader(const std::string& shard_header, const std::string& command_line) -> std::string {
+  std::string result;
+  result.reserve(shard_header.length());
+  for (const auto line : absl::StrSplit(shard_header, '\n', absl::SkipEmpty())) {
+    if (absl::StartsWith(line, "##commandLine=")) {
+      if (!command_line.empty()) absl::StrAppend(&result, "##commandLine=\"", command_line, "\"\n");
+      continue;
+    }
+
+    absl::StrAppend(&result, line, "\n");
+  }
+
+  return result;
+}
+
+auto MergeShardVcfs(const MergeParams& params) -> absl::Status {
+  const auto contigIDs = FastaReader(params.referencePath).ContigIDs();
+  std::vector<std::unique_ptr<ShardVcfReader>> readers;
+  readers.reserve(params.inVcfPaths.size());
+
+  for (const auto& path : params.inVcfPaths) {
+    readers.emplace_back(std::make_unique<ShardVcfReader>(path, &contigIDs));
+    const auto status = readers.back()->Open();
+    if (!status.ok()) return status;
+
+    if (readers.back()->ChromLine() != readers.front()->ChromLine()) {
+      return absl::FailedPreconditionError(absl::StrFormat("Samples in VCF %s do not match with samples in VCF %s",
+                                                           path, params.inVcfPaths.front()));
+    }
+  }
+
+  if (readers.empty()) return absl::InvalidArgumentError("no shard VCFs to merge");
+
+  VcfWriter outVcf(params.outVcfPath, 0);
+  outVcf.WriteHeader(MergedHeader(readers.front()->Header(), params.commandLine));
+
+  // min-heap of readers ordered by their current record, ties broken by shard order
+  const auto greaterThan = [&readers](const std::size_t lhs, const std::size_t rhs) -> bool {
+    const auto& left = readers[lhs]->Current();
+    const auto& right = readers[rhs]->Current();
+    if (left.Key() != right.Key()) return right.Key() < left.Key();
+    return lhs > rhs;
+  };
+
+  std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(greaterThan)> heap(greaterThan);
+  for (std::size_t idx = 0; idx < readers.size(); ++idx) {
+    if (readers[idx]->HasRecord()) heap.push(idx);
+  }
+
+  std::size_t numWritten = 0;
+  std::size_t numDuplicates = 0;
+  while (!heap.empty()) {
+    const auto bestIdx = heap.top();
+    heap.pop();
+    ShardRecord best = readers[bestIdx]->Current();
+
+    auto status = readers[bestIdx]->Advance();
+    if (!status.ok()) return status;
+    if (readers[bestIdx]->HasRecord()) heap.push(bestIdx);
+
+    // same variant called by windows from multiple shards, keep the one with higher total depth
+    while (!heap.empty() && readers[heap.top()]->Current().IsSameVariant(best)) {
+      const auto dupIdx = heap.top();
+      heap.pop();
+      numDuplicates++;
+
+      if (readers[dupIdx]->Current().totalDepth > best.totalDepth) best = readers[dupIdx]->Current();
+      status = readers[dupIdx]->Advance();
+      if (!status.ok()) return status;
+      if (readers[dupIdx]->HasRecord()) heap.push(dupIdx);
+    }
+
+    best.line.push_back('\n');
+    outVcf.WriteRecord(best.line);
+    numWritten++;
+  }
+
+  outVcf.Close();
+  LOG_INFO("Wrote {} variants after dropping {} duplicates at shard borders", numWritten, numDuplicates);
+  return absl::OkStatus();
+}
+
+void RunMerge(std::shared_ptr<MergeParams> params) {  // NOLINT
+  Timer T;
+  LOG_INFO("Starting to merge {} shard VCFs into {}", params->inVcfPaths.size(), params->outVcfPath);
+
+  const auto status = MergeShardVcfs(*params);
+  if (!status.ok()) {
+    LOG_ERROR(status.message());
+    std::exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("Successfully merged shard VCFs | Runtime={}", T.HumanRuntime());
+  std::exit(EXIT_SUCCESS);
+}
+}  // namespace lancet
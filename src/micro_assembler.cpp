@@ -11,77 +11,93 @@
 #include "lancet/graph_builder.h"
 #include "lancet/log_macros.h"
 #include "lancet/timer.h"
-#include "lancet/utils.h"
 #include "spdlog/spdlog.h"
 
 namespace lancet {
-void MicroAssembler::Process(const std::shared_ptr<VariantStore>& store) {
+// initial capacity of a variant buffer, when no drained buffer is available in the pool
+static constexpr std::size_t VARIANT_BUFFER_CAPACITY = 256;
+
+void MicroAssembler::Process() {
   static thread_local const auto tid = std::this_thread::get_id();
   LOG_INFO("Started MicroAssembler thread {:#x}", absl::Hash<std::thread::id>()(tid));
 
-  variants.reserve(2048);
-  results.reserve(1024);
-
   Timer T;
-  FastaReader refRdr(params->referencePath);
-  ReadExtractor readExtractor(params);
-  auto window = std::make_shared<RefWindow>();
-  moodycamel::ConsumerToken windowConsumerToken(*windowQPtr);
+  // readers are only used when windows are not prefetched by a `WindowPrefetcher`
+  std::unique_ptr<FastaReader> refRdr;
+  std::unique_ptr<ReadExtractor> readExtractor;
+  if (prefetcherPtr == nullptr) {
+    refRdr = std::make_unique<FastaReader>(params->referencePath);
+    readExtractor = std::make_unique<ReadExtractor>(params);
+  }
+
   moodycamel::ProducerToken resultProducerToken(*resultQPtr);
   std::size_t numProcessed = 0;
 
-  while (windowQPtr->try_dequeue(windowConsumerToken, window)) {
-    TryFlush(store, resultProducerToken);
+  WindowPayload payload;
+  while (NextPayload(refRdr.get(), readExtractor.get(), &payload)) {
     T.Reset();
 
+    const auto& window = payload.window;
     const auto winIdx = window->WindowIndex();
     const auto regStr = window->ToRegionString();
-    const auto regResult = refRdr.RegionSequence(window->ToGenomicRegion());
+    bool timedOut = false;
     numProcessed++;
 
-    if (!regResult.ok() && absl::IsFailedPrecondition(regResult.status())) {
-      LOG_DEBUG("Skipping window {} with truncated reference sequence in fasta", regStr);
-      results.emplace_back(WindowResult{T.Runtime(), winIdx});
-      continue;
-    }
-
-    if (!regResult.ok()) {
-      LOG_ERROR("Error processing window {}: {}", regStr, regResult.status().message());
-      results.emplace_back(WindowResult{T.Runtime(), winIdx});
-      continue;
+    // buffer moved out with the previous result is replaced by one drained by the output thread
+    if (!bufferPoolPtr->try_dequeue(variants)) variants.reserve(VARIANT_BUFFER_CAPACITY);
+
+    if (!payload.status.ok()) {
+      LOG_ERROR("Error processing window {}: {}", regStr, payload.status.message());
+    } else if (payload.shouldAssemble) {
+      try {
+        const CancelToken token(absl::Seconds(params->windowTimeBudget));
+        AssembleWindow(payload, &token);
+      } catch (const WindowTimeoutError& timeout) {
+        // drop partial results, so that variants from timed out windows are not reported
+        LOG_WARN("Skipping window {} since it {}", regStr, timeout.what());
+        variants.clear();
+        timedOut = true;
+      } catch (const std::exception& exception) {
+        LOG_ERROR("Error processing window {}: {}", regStr, exception.what());
+      } catch (...) {
+        LOG_ERROR("Error processing window {}: unknown exception caught", regStr);
+      }
     }
 
-    try {
-      window->SetSequence(regResult.value());
-      const auto windowStatus = ProcessWindow(&readExtractor, std::const_pointer_cast<const RefWindow>(window));
-      if (!windowStatus.ok()) LOG_ERROR("Error processing window {}: {}", regStr, windowStatus.message());
-    } catch (const std::exception& exception) {
-      LOG_ERROR("Error processing window {}: {}", regStr, exception.what());
-    } catch (...) {
-      LOG_ERROR("Error processing window {}: unknown exception caught", regStr);
+    // records are rendered here, so that formatting is spread across workers instead of the output thread
+    if (params->outputFormat != "bcf") {
+      for (auto& var : variants) var.RenderRecord(*params);
     }
 
-    results.emplace_back(WindowResult{T.Runtime(), winIdx});
+    // sequence and reads are not needed after processing, release them while the window waits to be flushed
+    window->SetSequence({});
+    payload.reads.clear();
+    const auto runtime = payload.fetchRuntime + T.Runtime();
+    schedulerPtr->ReportRuntime(winIdx, runtime);
+    // producer token keeps results from this worker in its own lock-free sub-queue
+    resultQPtr->enqueue(resultProducerToken, WindowResult{runtime, winIdx, window, timedOut, std::move(variants)});
+    variants.clear();
   }
 
-  ForceFlush(store, resultProducerToken);
   LOG_INFO("Done processing {} windows in MicroAssembler thread {:#x}", numProcessed,
            absl::Hash<std::thread::id>()(tid));
 }
 
-auto MicroAssembler::ProcessWindow(ReadExtractor* re, const std::shared_ptr<const RefWindow>& w) -> absl::Status {
-  const auto regionStr = w->ToRegionString();
-  LOG_DEBUG("Starting to process {} in MicroAssembler", regionStr);
-  if (ShouldSkipWindow(w)) return absl::OkStatus();
+auto MicroAssembler::NextPayload(FastaReader* ref, ReadExtractor* re, WindowPayload* result) -> bool {
+  if (prefetcherPtr != nullptr) return prefetcherPtr->Next(result);
 
-  re->SetTargetRegion(w->ToGenomicRegion());
-  if (!params->activeRegionOff && !re->IsActiveRegion()) {
-    LOG_DEBUG("Skipping {} since no evidence of mutation is found", regionStr);
-    return absl::OkStatus();
-  }
+  auto window = schedulerPtr->Next(workerIdx);
+  if (window == nullptr) return false;
+
+  *result = PrepareWindow(std::move(window), ref, re, schedulerPtr.get(), *params);
+  return true;
+}
+
+void MicroAssembler::AssembleWindow(const WindowPayload& payload, const CancelToken* token) {
+  const auto regionStr = payload.window->ToRegionString();
+  const auto w = std::const_pointer_cast<const RefWindow>(payload.window);
 
-  const auto reads = re->Extract();
-  GraphBuilder gb(w, absl::MakeConstSpan(reads), re->AverageCoverage(), params);
+  GraphBuilder gb(w, absl::MakeConstSpan(payload.reads), payload.avgCoverage, params, token);
   auto graph = gb.BuildGraph(params->minKmerSize, params->maxKmerSize);
   graph->ProcessGraph({gb.RefData(SampleLabel::NORMAL), gb.RefData(SampleLabel::TUMOR)}, &variants);
 
@@ -94,40 +110,6 @@ auto MicroAssembler::ProcessWindow(ReadExtractor* re, const std::shared_ptr<cons
     graph = gb.BuildGraph(gb.CurrentKmerSize() + 2, params->maxKmerSize);
     graph->ProcessGraph({gb.RefData(SampleLabel::NORMAL), gb.RefData(SampleLabel::TUMOR)}, &variants);
   }
-
-  return absl::OkStatus();
-}
-
-auto MicroAssembler::ShouldSkipWindow(const std::shared_ptr<const RefWindow>& w) const -> bool {
-  const auto refseq = w->SeqView();
-  const auto regionStr = w->ToRegionString();
-
-  if (static_cast<std::size_t>(std::count(refseq.begin(), refseq.end(), 'N')) == refseq.length()) {
-    LOG_DEBUG("Skipping {} since it has only N bases in reference", regionStr);
-    return true;
-  }
-
-  if (utils::HasRepeatKmer(refseq, params->maxKmerSize)) {
-    LOG_DEBUG("Skipping {} since reference has repeat {}-mers", regionStr, params->maxKmerSize);
-    return true;
-  }
-
-  return false;
-}
-
-void MicroAssembler::TryFlush(const std::shared_ptr<VariantStore>& store, const moodycamel::ProducerToken& token) {
-  const auto addedVariants = store->TryAddVariants(variants);
-  if (addedVariants) {
-    resultQPtr->enqueue_bulk(token, results.cbegin(), results.size());
-    variants.clear();
-    results.clear();
-  }
 }
 
-void MicroAssembler::ForceFlush(const std::shared_ptr<VariantStore>& store, const moodycamel::ProducerToken& token) {
-  store->ForceAddVariants(variants);
-  resultQPtr->enqueue_bulk(token, results.cbegin(), results.size());
-  variants.clear();
-  results.clear();
-}
 }  // namespace lancet
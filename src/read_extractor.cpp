@@ -1,14 +1,16 @@
 #include "lancet/read_extractor.h"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/strings/ascii.h"
 #include "absl/types/span.h"
-#include "lancet/assert_macro.h"
+#include "lancet/alignment_evidence.h"
 #include "lancet/fractional_sampler.h"
 
 #if defined(__clang__)
@@ -35,8 +37,12 @@ ReadExtractor::ReadExtractor(std::shared_ptr<const CliParams> p)
 
 void ReadExtractor::SetTargetRegion(const GenomicRegion& region) {
   targetRegion = region;
-  const auto tmrResult = EvaluateRegion(&tmrRdr, targetRegion, *params);
-  const auto nmlResult = EvaluateRegion(&nmlRdr, targetRegion, *params);
+  SlideCache(&tmrRdr, &tmrCache, targetRegion, SampleLabel::TUMOR);
+  SlideCache(&nmlRdr, &nmlCache, targetRegion, SampleLabel::NORMAL);
+
+  // normal reads are only needed for coverage and extraction if tumor reads already make the region active
+  const auto tmrResult = EvaluateRegion(tmrCache, targetRegion, *params, false, &tmrCandidates);
+  const auto nmlResult = EvaluateRegion(nmlCache, targetRegion, *params, tmrResult.isActiveRegion, &nmlCandidates);
 
   isActiveRegion = tmrResult.isActiveRegion || nmlResult.isActiveRegion;
   avgCoverage = (tmrResult.coverage + nmlResult.coverage) / 2.0F;
@@ -44,12 +50,12 @@ void ReadExtractor::SetTargetRegion(const GenomicRegion& region) {
 
 auto ReadExtractor::Extract() -> ReadInfoList {
   std::vector<ReadInfo> finalReads;
-  const auto tmrMateInfo = ExtractReads(&tmrRdr, &finalReads, SampleLabel::TUMOR);
+  const auto tmrMateInfo = ExtractReads(tmrCandidates, &finalReads);
   if (params->extractReadPairs && !tmrMateInfo.empty()) {
     ExtractPairs(&tmrRdr, tmrMateInfo, &finalReads, SampleLabel::TUMOR);
   }
 
-  const auto nmlMateInfo = ExtractReads(&nmlRdr, &finalReads, SampleLabel::NORMAL);
+  const auto nmlMateInfo = ExtractReads(nmlCandidates, &finalReads);
   if (params->extractReadPairs && !nmlMateInfo.empty()) {
     ExtractPairs(&nmlRdr, nmlMateInfo, &finalReads, SampleLabel::NORMAL);
   }
@@ -57,26 +63,89 @@ auto ReadExtractor::Extract() -> ReadInfoList {
   return finalReads;
 }
 
-auto ReadExtractor::ExtractReads(HtsReader* rdr, ReadInfoList* result, SampleLabel label)
-    -> absl::flat_hash_map<std::string, GenomicRegion> {
-  const auto jumpStatus = rdr->SetRegion(targetRegion);
+auto ReadExtractor::CachedState(SampleLabel label) const -> CacheState {
+  const auto& cache = label == SampleLabel::TUMOR ? tmrCache : nmlCache;
+  const auto firstReadEnd0 = cache.reads.empty() ? -1 : cache.reads.front().aln.EndPosition0();
+  return CacheState{cache.chrom, cache.start1, cache.end1, cache.reads.size(), firstReadEnd0, cache.numDecoded};
+}
+
+void ReadExtractor::SlideCache(HtsReader* rdr, SampleCache* cache, const GenomicRegion& region, SampleLabel label) {
+  const auto start1 = region.StartPosition1();
+  const auto end1 = region.EndPosition1();
+  const auto canSlide = cache->chrom == region.Chromosome() && start1 >= cache->start1 && start1 <= cache->end1 + 1;
+
+  if (!canSlide) {
+    cache->reads.clear();
+    FetchReads(rdr, region, -1, label, &cache->reads);
+    cache->numDecoded += cache->reads.size();
+    cache->chrom = region.Chromosome();
+    cache->start1 = start1;
+    cache->end1 = end1;
+    return;
+  }
+
+  // Reads starting at or before the cached end overlap the cached region, so they are already in the cache
+  if (end1 > cache->end1) {
+    const auto numBefore = cache->reads.size();
+    FetchReads(rdr, GenomicRegion(cache->chrom, cache->end1 + 1, end1), cache->end1, label, &cache->reads);
+    cache->numDecoded += cache->reads.size() - numBefore;
+    cache->end1 = end1;
+  }
+
+  while (!cache->reads.empty() && cache->reads.front().aln.EndPosition0() < start1) cache->reads.pop_front();
+  cache->start1 = start1;
+}
+
+void ReadExtractor::FetchReads(HtsReader* rdr, const GenomicRegion& region, std::int64_t min_start0,
+                               SampleLabel label, std::deque<CachedRead>* result) const {
+  const auto jumpStatus = rdr->SetRegion(region);
   if (!jumpStatus.ok()) throw std::runtime_error(jumpStatus.ToString());
 
+  HtsAlignmentView view;
+  while (rdr->NextAlignment(&view) == HtsReader::IteratorState::VALID) {
+    if (view.StartPosition0() < min_start0) continue;
+
+    // reads failing filters only count towards coverage, so nothing else is decoded for them
+    CachedRead item;
+    view.CopyCoreFields(&item.aln);
+    item.passesFilters = PassesFilters(view, *params);
+    if (!item.passesFilters) {
+      result->emplace_back(std::move(item));
+      continue;
+    }
+
+    if (const auto* mdData = view.TagData("MD"); mdData != nullptr) item.mdTag = bam_aux2Z(mdData);
+    item.passesTmrFilters = label == SampleLabel::TUMOR && PassesTmrFilters(view, *params);
+    if (label != SampleLabel::TUMOR || item.passesTmrFilters) {
+      item.info = view.BuildReadInfo(label, params->trimBelowQual, params->maxKmerSize);
+    }
+
+    item.aln.SetCigar(view.CigarData());
+    if (!item.mdTag.empty()) item.aln.SetReadQuality(std::string(view.ReadQuality()));
+    if (params->extractReadPairs) {
+      item.aln.SetReadName(std::string(view.ReadName()));
+      item.aln.SetMateContig(std::string(view.MateContigName()));
+      item.aln.SetMateStartPosition0(view.MateStartPosition0());
+    }
+
+    result->emplace_back(std::move(item));
+  }
+}
+
+auto ReadExtractor::ExtractReads(const CandidateList& candidates, ReadInfoList* result)
+    -> absl::flat_hash_map<std::string, GenomicRegion> {
   const auto fractionToSample = avgCoverage > params->maxWindowCov ? (avgCoverage / params->maxWindowCov) : 1.0;
   FractionalSampler sampler(fractionToSample);
 
   // readName -> mateRegion
   absl::flat_hash_map<std::string, GenomicRegion> mateName2Region;
-  HtsAlignment aln;
-
-  while (rdr->NextAlignment(&aln, {"XT", "XA", "AS", "XS"}) == HtsReader::IteratorState::VALID) {
-    if (!sampler.ShouldSample() || !PassesFilters(aln, *params)) continue;
-    if (!params->useOverlapReads && !aln.IsWithinRegion(targetRegion)) continue;
-    if (label == SampleLabel::TUMOR && !PassesTmrFilters(aln, *params)) continue;
 
-    auto rdInfo = aln.BuildReadInfo(label, params->trimBelowQual, params->maxKmerSize);
-    if (rdInfo.IsEmpty()) continue;
+  // candidates already pass all read filters, only downsampling is left
+  result->reserve(result->size() + candidates.size());
+  for (const auto* item : candidates) {
+    if (!sampler.ShouldSample()) continue;
 
+    const auto& aln = item->aln;
     if (params->extractReadPairs && !aln.IsMateUnmapped()) {
       const auto itr = mateName2Region.find(aln.ReadName());
       if (itr == mateName2Region.end()) {
@@ -86,7 +155,7 @@ auto ReadExtractor::ExtractReads(HtsReader* rdr, ReadInfoList* result, SampleLab
       }
     }
 
-    result->emplace_back(std::move(rdInfo));
+    result->emplace_back(item->info);
   }
 
   return mateName2Region;
@@ -108,19 +177,19 @@ void ReadExtractor::ExtractPairs(HtsReader* rdr, const absl::flat_hash_map<std::
   const auto jumpStatus = rdr->SetRegions(absl::MakeConstSpan(mateRegions));
   if (!jumpStatus.ok()) throw std::runtime_error(jumpStatus.ToString());
 
-  HtsAlignment aln;
-  while (rdr->NextAlignment(&aln, {}) == HtsReader::IteratorState::VALID) {
-    if (!PassesFilters(aln, *params) || !mate_info.contains(aln.ReadName())) continue;
-    result->emplace_back(aln.BuildReadInfo(label, params->trimBelowQual, params->maxKmerSize));
+  HtsAlignmentView view;
+  while (rdr->NextAlignment(&view) == HtsReader::IteratorState::VALID) {
+    if (!PassesFilters(view, *params) || !mate_info.contains(view.ReadName())) continue;
+    result->emplace_back(view.BuildReadInfo(label, params->trimBelowQual, params->maxKmerSize));
   }
 }
 
-auto ReadExtractor::PassesFilters(const HtsAlignment& aln, const CliParams& params) -> bool {
+auto ReadExtractor::PassesFilters(const HtsAlignmentView& aln, const CliParams& params) -> bool {
   if (aln.IsQcFailed() || aln.IsDuplicate()) return false;
   return !(params.skipSecondary && aln.IsSecondary());
 }
 
-auto ReadExtractor::PassesTmrFilters(const HtsAlignment& aln, const CliParams& params) -> bool {
+auto ReadExtractor::PassesTmrFilters(const HtsAlignmentView& aln, const CliParams& params) -> bool {
   // XT type: Unique/Repeat/N/Mate-sw
   // XT:A:M (one-mate recovered) means that one of the pairs is uniquely mapped and the other isn't
   // Heng Li: If the read itself is a repeat and can't be mapped without relying on its mate, you
@@ -136,130 +205,80 @@ auto ReadExtractor::PassesTmrFilters(const HtsAlignment& aln, const CliParams& p
 
   // AS: Alignment score
   // XS: Suboptimal alignment score
-  if (aln.HasTag("AS") && aln.HasTag("XS")) {
-    const auto AS = bam_aux2i(aln.TagData("AS").value());
-    const auto XS = bam_aux2i(aln.TagData("XS").value());
+  const auto* asData = aln.TagData("AS");
+  const auto* xsData = aln.TagData("XS");
+  if (asData != nullptr && xsData != nullptr) {
+    const auto AS = bam_aux2i(asData);
+    const auto XS = bam_aux2i(xsData);
     return std::abs(AS - XS) >= params.minReadAsXsDiff;
   }
 
   return true;
 }
 
-auto ReadExtractor::EvaluateRegion(HtsReader* rdr, const GenomicRegion& region, const CliParams& params) -> EvalResult {
-  const auto jumpStatus = rdr->SetRegion(region);
-  if (!jumpStatus.ok()) throw std::runtime_error(jumpStatus.ToString());
+// Number of reads with each kind of evidence per genome position, over a window span padded on both sides.
+// Span grows if evidence is found outside it, e.g. from long reads overlapping the window
+class EvidenceCounter {
+ public:
+  EvidenceCounter(const GenomicRegion& region, std::uint32_t min_count) : minCount(min_count) {
+    const auto regionLen = static_cast<std::int64_t>(region.Length());
+    spanStart = static_cast<std::uint32_t>(std::max(region.StartPosition1() - 1 - regionLen, std::int64_t(0)));
+    counts.resize(static_cast<std::size_t>(3 * regionLen));
+  }
 
-  using u32 = std::uint32_t;
-  std::vector<u32> genomePositions;  // softclip genome positions for single alignment
-  std::map<u32, u32> mismatches;     // genome position -> number of mismatches at position
-  std::map<u32, u32> insertions;     // genome position -> number of insertions at position
-  std::map<u32, u32> deletions;      // genome position -> number of deletions at position
-  std::map<u32, u32> softclips;      // genome position -> number of softclips at position
-
-  // lambda function to increment the counter for `genomePositions`
-  const auto incrementGPos = [](std::map<u32, u32>& m, u32 genome_pos) {
-    auto&& itr = m.find(genome_pos);
-    if (itr != m.end()) {
-      ++itr->second;
-      return;
+  /// Returns true if number of reads with the evidence at its genome position reaches the minimum count
+  [[nodiscard]] auto Add(const AlignmentEvidence& evidence) -> bool {
+    const auto genomePos = evidence.genomePos;
+    if (genomePos < spanStart) {
+      counts.insert(counts.begin(), spanStart - genomePos, PositionCounts{});
+      spanStart = genomePos;
     }
-    m.emplace(std::make_pair(genome_pos, 1));
-  };
 
-  // lambda function to check if map `m` has evidence of mutation >= minAltCntTumor
-  const auto hasEvidence = [](const std::map<u32, u32>& m, u32 min_alt_cnt_tmr) {
-    return std::any_of(m.cbegin(), m.cend(), [&min_alt_cnt_tmr](const auto& p) { return p.second >= min_alt_cnt_tmr; });
-  };
+    const auto offset = static_cast<std::size_t>(genomePos - spanStart);
+    if (offset >= counts.size()) counts.resize(offset + 1);
+    return ++counts[offset][static_cast<std::size_t>(evidence.kind)] >= minCount;
+  }
+
+ private:
+  using PositionCounts = std::array<std::uint32_t, NUM_EVIDENCE_KINDS>;
+  std::uint32_t minCount = 0;
+  std::uint32_t spanStart = 0;
+  std::vector<PositionCounts> counts;
+};
+
+auto ReadExtractor::EvaluateRegion(const SampleCache& cache, const GenomicRegion& region, const CliParams& params,
+                                   bool skip_evidence, CandidateList* candidates) -> EvalResult {
+  std::vector<AlignmentEvidence> evidence;  // evidence of mutation from single alignment
+  std::optional<EvidenceCounter> counter;
 
-  HtsAlignment aln;
   bool isActiveRegion = false;
   std::uint64_t numReadBases = 0;
+  candidates->clear();
+
+  for (const auto& item : cache.reads) {
+    if (!item.Overlaps(region)) continue;
 
-  while (rdr->NextAlignment(&aln, {"MD"}) == HtsReader::IteratorState::VALID) {
+    const auto& aln = item.aln;
     if (!aln.IsUnmapped() && !aln.IsDuplicate()) numReadBases += aln.Length();
 
-    // skip processing further if already an active region or if doesn't pass filters
-    if (isActiveRegion || !PassesFilters(aln, params)) continue;
+    if (!item.passesFilters) continue;
     if (!params.useOverlapReads && !aln.IsWithinRegion(region)) continue;
 
-    if (aln.HasTag("MD")) {
-      FillMDMismatches(bam_aux2Z(aln.TagData("MD").value()), aln.ReadQuality(), aln.StartPosition0(),
-                       params.minBaseQual, &mismatches);
-    }
-
-    const auto cigarUnits = aln.CigarData();
-    auto currGPos = static_cast<u32>(aln.StartPosition0());
-    bool hasSoftClip = false;
-
-    for (const auto& cigUnit : cigarUnits) {
-      if (cigUnit.ConsumesReference()) currGPos += cigUnit.Length;
-      switch (cigUnit.Operation) {
-        case CigarOp::INSERTION:
-          incrementGPos(insertions, currGPos);
-          LANCET_ASSERT(!insertions.empty());  // NOLINT
-          break;
-        case CigarOp::DELETION:
-          incrementGPos(deletions, currGPos);
-          LANCET_ASSERT(!deletions.empty());  // NOLINT
-          break;
-        case CigarOp::SEQUENCE_MISMATCH:
-          incrementGPos(mismatches, currGPos);
-          LANCET_ASSERT(!mismatches.empty());  // NOLINT
-          break;
-        case CigarOp::SOFT_CLIP:
-          hasSoftClip = true;
-          break;
-        default:
-          break;
-      }
-    }
+    // buffer reads to extract, in case the region turns out to be active
+    const auto passesSampleFilters = item.info.label != SampleLabel::TUMOR || item.passesTmrFilters;
+    if (passesSampleFilters && !item.info.IsEmpty()) candidates->push_back(&item);
 
-    genomePositions.clear();
-    if (hasSoftClip && aln.SoftClips(nullptr, nullptr, &genomePositions, false)) {
-      for (const auto gpos : genomePositions) incrementGPos(softclips, gpos);
-      LANCET_ASSERT(!softclips.empty());  // NOLINT
-    }
+    // remaining reads only add to coverage and candidates once the region is known to be active
+    if (skip_evidence || isActiveRegion) continue;
+    if (!counter) counter.emplace(region, params.minTmrAltCnt);
 
-    // if evidence of SNV/insertion/deletion/softclip is found in window, mark region as active
-    isActiveRegion = hasEvidence(mismatches, params.minTmrAltCnt) || hasEvidence(insertions, params.minTmrAltCnt) ||
-                     hasEvidence(deletions, params.minTmrAltCnt) || hasEvidence(softclips, params.minTmrAltCnt);
+    evidence.clear();
+    CollectAlignmentEvidence(aln, item.mdTag, aln.ReadQuality(), params.minBaseQual, &evidence);
+    isActiveRegion = std::any_of(evidence.cbegin(), evidence.cend(),
+                                 [&counter](const AlignmentEvidence& evd) { return counter->Add(evd); });
   }
 
-  auto avgCoverage = static_cast<double>(numReadBases) / static_cast<double>(region.Length());
-  isActiveRegion = hasEvidence(mismatches, params.minTmrAltCnt) || hasEvidence(insertions, params.minTmrAltCnt) ||
-                   hasEvidence(deletions, params.minTmrAltCnt) || hasEvidence(softclips, params.minTmrAltCnt);
-
+  const auto avgCoverage = static_cast<double>(numReadBases) / static_cast<double>(region.Length());
   return EvalResult{avgCoverage, isActiveRegion};
 }
-
-void ReadExtractor::FillMDMismatches(std::string_view md, std::string_view quals, std::int64_t aln_start,
-                                     std::uint32_t min_bq, std::map<std::uint32_t, std::uint32_t>* result) {
-  if (aln_start < 0) return;
-  auto genomePos = static_cast<std::uint32_t>(aln_start);
-  std::string token;
-
-  for (const auto& c : md) {
-    if (absl::ascii_isdigit(static_cast<unsigned char>(c))) {
-      token += c;
-      continue;
-    }
-
-    const auto step = token.empty() ? 0 : std::strtol(token.c_str(), nullptr, 10);
-    genomePos += static_cast<std::uint32_t>(step);
-    token.clear();
-
-    const auto basePos = static_cast<std::size_t>(genomePos - aln_start);
-    if (static_cast<int>(quals[basePos]) < static_cast<int>(min_bq)) continue;
-
-    const auto base = absl::ascii_toupper(static_cast<unsigned char>(c));
-    if (base == 'A' || base == 'C' || base == 'T' || base == 'G') {
-      const auto& itr = result->find(genomePos);
-      if (itr != result->end()) {
-        itr->second++;
-      } else {
-        result->emplace(genomePos, 1);
-      }
-    }
-  }
-}
 }  // namespace lancet
@@ -0,0 +1,56 @@
+#include "lancet/refilter_vcf.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "lancet/fisher_exact.h"
+#include "lancet/hts_reader.h"
+#include "lancet/log_macros.h"
+#include "lancet/timer.h"
+#include "lancet/variant_evidence.h"
+#include "lancet/variant_store.h"
+#include "lancet/vcf_writer.h"
+#include "spdlog/spdlog.h"
+
+namespace lancet {
+static inline void ExitOnError(const absl::Status& status) {
+  if (status.ok()) return;
+  LOG_ERROR(status.message());
+  std::exit(EXIT_FAILURE);
+}
+
+void RunRefilter(std::shared_ptr<CliParams> params) {  // NOLINT
+  Timer T;
+  if (!params->ValidateOutputFormat()) std::exit(EXIT_FAILURE);
+
+  EvidenceReader reader(params->evidencePath);
+  ExitOnError(reader.Open());
+
+  // header and filters depend on the mode and reference the evidence was generated with
+  const auto& hdr = reader.Header();
+  params->tenxMode = hdr.tenxMode;
+  params->referencePath = hdr.referencePath;
+  InitLogFactorialTable(static_cast<std::size_t>(params->maxTmrCov) + params->maxNmlCov);
+
+  const auto asBcf = params->outputFormat == "bcf";
+  InitSharedHtsThreadPool(static_cast<int>(params->numHtsThreads));
+  VcfWriter outVcf(params->outVcfPath, 0, asBcf);
+  outVcf.WriteHeader(VariantStore::GetHeader(hdr.sampleNames, absl::MakeConstSpan(hdr.contigs), *params));
+
+  std::size_t numVariants = 0;
+  std::optional<Variant> var;
+  while (true) {
+    ExitOnError(reader.Next(&var));
+    if (!var.has_value()) break;
+    outVcf.WriteVariant(*var, *params);
+    numVariants++;
+  }
+
+  outVcf.Close();
+  LOG_INFO("Re-filtered {} variants from {} | Runtime={}", numVariants, params->evidencePath, T.HumanRuntime());
+  std::exit(EXIT_SUCCESS);
+}
+}  // namespace lancet
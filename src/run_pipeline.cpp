@@ -6,21 +6,35 @@
 #include <filesystem>
 #include <fstream>
 #include <future>
+#include <memory>
 #include <utility>
 #include <vector>
 
-#include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "lancet/active_region_index.h"
 #include "lancet/assert_macro.h"
+#include "lancet/checkpoint.h"
+#include "lancet/completion_tracker.h"
 #include "lancet/fasta_reader.h"
+#include "lancet/filter_profile.h"
+#include "lancet/fisher_exact.h"
 #include "lancet/hts_reader.h"
 #include "lancet/log_macros.h"
 #include "lancet/micro_assembler.h"
 #include "lancet/timer.h"
+#include "lancet/variant_evidence.h"
 #include "lancet/variant_store.h"
+#include "lancet/vcf_writer.h"
 #include "lancet/window_builder.h"
+#include "lancet/window_prefetcher.h"
+#include "lancet/window_scheduler.h"
 #include "spdlog/spdlog.h"
 
 namespace lancet {
+// Min. time between consecutive checkpoints recorded in the checkpoint journal
+static const auto CHECKPOINT_INTERVAL = absl::Seconds(30);
+
 static inline auto GetSampleNames(const CliParams& p) -> std::vector<std::string> {
   HtsReader rdrN(p.normalPath, p.referencePath);
   const auto resultN = rdrN.SampleNames();
@@ -48,6 +62,66 @@ static inline auto RequiredBufferWindows(const CliParams& p) -> std::size_t {
   return static_cast<std::size_t>(4.0 * std::ceil(maxFlankLen / windowStep));
 }
 
+static inline auto ShardWindowRange(const CliParams& p, std::size_t num_total)
+    -> std::pair<std::size_t, std::size_t> {
+  // Windows are independent assembly tasks, so shards are balanced by number of windows. Variants
+  // called near shard borders by windows of both shards are de-duplicated by `lancet merge`
+  const auto shardStart = (num_total * (p.shardIdx - 1)) / p.numShards;
+  const auto shardEnd = (num_total * p.shardIdx) / p.numShards;
+  return {shardStart, shardEnd};
+}
+
+static inline void ReportTimedOutWindows(const CliParams& p, absl::Span<const std::shared_ptr<const RefWindow>> wins) {
+  if (wins.empty()) return;
+  LOG_WARN("Skipped {} window(s) that exceeded time budget of {}s", wins.size(), p.windowTimeBudget);
+  if (p.timedOutBedPath.empty()) return;
+
+  std::ofstream outBed(p.timedOutBedPath, std::ios_base::out | std::ios_base::trunc);
+  for (const auto& win : wins) {
+    outBed << win->Chromosome() << '\t' << win->StartPosition0() << '\t' << win->EndPosition0() << '\n';
+  }
+
+  outBed.close();
+  LOG_INFO("Wrote windows that exceeded time budget to {}", p.timedOutBedPath);
+}
+
+static inline auto LoadActiveRegionIndex(const CliParams& p, absl::Span<const ContigInfo> ref_contigs)
+    -> std::shared_ptr<const ActiveRegionIndex> {
+  if (p.activeRegionsPath.empty()) return nullptr;
+
+  auto result = ActiveRegionIndex::Load(p.activeRegionsPath);
+  const auto status = result.ok() ? result.value().CheckCompatible(p, ref_contigs) : result.status();
+  if (!status.ok()) {
+    LOG_ERROR("Could not use active region index: {}", status.message());
+    std::exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("Loaded {} active intervals spanning {} bases from {}", result.value().NumActiveIntervals(),
+           result.value().NumActiveBases(), p.activeRegionsPath);
+  return std::make_shared<const ActiveRegionIndex>(std::move(result).value());
+}
+
+static inline auto LoadResumeCheckpoint(const CliParams& p, const CheckpointJournal& journal) -> Checkpoint {
+  if (!p.resumeRun) return {};
+
+  const auto result = journal.LoadLast();
+  if (!result.ok()) {
+    LOG_ERROR("Could not resume run: {}", result.status().message());
+    std::exit(EXIT_FAILURE);
+  }
+
+  if (result.value().vcfOffset == 0 || !std::filesystem::exists(p.outVcfPath)) {
+    LOG_WARN("No checkpoints found in {}. Starting run from the first window", journal.Path().string());
+    return {};
+  }
+
+  // Variants of windows done after the last flushed window were only held in memory,
+  // so these windows have to be processed again along with the remaining windows
+  LOG_INFO("Resuming run after {} flushed windows ({} windows were done)", result.value().numFlushedWindows,
+           result.value().numDoneWindows);
+  return result.value();
+}
+
 void RunPipeline(std::shared_ptr<CliParams> params) {  // NOLINT
   Timer T;
   LOG_INFO("Starting main thread for processing lancet pipeline");
@@ -59,82 +133,185 @@ void RunPipeline(std::shared_ptr<CliParams> params) {  // NOLINT
     std::filesystem::create_directory(params->outGraphsDir);
   }
 
-  std::ofstream outVcf(params->outVcfPath, std::ios_base::out | std::ios_base::trunc);
-  const auto vcfHdr = VariantStore::GetHeader(GetSampleNames(*params), *params);
-  outVcf.write(vcfHdr.c_str(), vcfHdr.length());
+  if (params->numHtsThreads > 0) {
+    InitSharedHtsThreadPool(static_cast<int>(params->numHtsThreads));
+    LOG_INFO("Created shared pool of {} thread(s) to decompress BAM/CRAM and compress VCF blocks",
+             params->numHtsThreads);
+  }
+
+  // Fisher scores of variants within the coverage caps only need log-factorial table lookups
+  InitLogFactorialTable(static_cast<std::size_t>(params->maxTmrCov) + params->maxNmlCov);
+
+  CheckpointJournal journal(params->outVcfPath, *params);
+  const auto resumeFrom = LoadResumeCheckpoint(*params, journal);
+  const auto isResumed = resumeFrom.vcfOffset > 0;
 
+  // compressed output is written with the shared htslib threads, checkpoints are only supported for plain VCF
+  const auto asBcf = params->outputFormat == "bcf";
+  VcfWriter outVcf(params->outVcfPath, resumeFrom.vcfOffset, asBcf);
+  const auto useJournal = !outVcf.IsCompressed();
+  const auto refContigs = FastaReader(params->referencePath).ContigsInfo();
+  const auto sampleNames = GetSampleNames(*params);
+  if (!isResumed) outVcf.WriteHeader(VariantStore::GetHeader(sampleNames, absl::MakeConstSpan(refContigs), *params));
+
+  // evidence sidecar with raw counts of every variant written, so that filters can be re-applied with refilter
+  std::unique_ptr<EvidenceWriter> evidence;
+  if (!params->evidencePath.empty()) {
+    evidence = std::make_unique<EvidenceWriter>(params->evidencePath);
+    const auto evidenceStatus = evidence->Open({sampleNames, refContigs, params->referencePath, params->tenxMode});
+    if (!evidenceStatus.ok()) {
+      LOG_ERROR(evidenceStatus.message());
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  // one more output per filter profile, written from the same assembled variants as the main output.
+  // profiles are validated along with the other params, so parsing them again cannot fail here
+  const auto filterProfiles = ParseFilterProfiles(*params).value();
+  std::vector<VcfWriter> profileVcfs;
+  profileVcfs.reserve(filterProfiles.size());
+  ExtraOutputs extraOutputs{evidence.get(), {}};
+  for (const auto& profile : filterProfiles) {
+    auto& profileVcf = profileVcfs.emplace_back(profile.outPath, 0, asBcf);
+    profileVcf.WriteHeader(VariantStore::GetHeader(sampleNames, absl::MakeConstSpan(refContigs), profile.params));
+    extraOutputs.profileOutputs.emplace_back(&profileVcf, &profile.params);
+    LOG_INFO("Writing variants with filter profile {} to {}", profile.name, profile.outPath.string());
+  }
+
+  const auto journalStatus = useJournal ? journal.Open(isResumed) : absl::OkStatus();
+  if (!journalStatus.ok()) {
+    LOG_ERROR(journalStatus.message());
+    std::exit(EXIT_FAILURE);
+  }
+
+  Checkpoint lastCkpt = resumeFrom;
+  lastCkpt.vcfOffset = outVcf.Offset();
+  if (useJournal) journal.Record(lastCkpt);
+
+  // windows skipped with the index still flow through the scheduler, so that completion stays index based
+  const auto activeIndex = LoadActiveRegionIndex(*params, absl::MakeConstSpan(refContigs));
   const auto contigIDs = GetContigIDs(*params);
-  const auto allwindows = BuildWindows(contigIDs, *params);
+  auto windowGen = BuildWindowGenerator(contigIDs, *params);
+  const auto [shardStart, shardEnd] = ShardWindowRange(*params, windowGen->TotalWindows());
+  const auto firstWindowIdx = std::max(shardStart, resumeFrom.numFlushedWindows);
+  windowGen->SkipWindows(firstWindowIdx);
+  windowGen->LimitWindows(shardEnd);
   const auto numThreads = static_cast<std::size_t>(params->numWorkerThreads);
   const auto paramsPtr = std::make_shared<const CliParams>(*params);
   const auto numBufWindows = RequiredBufferWindows(*paramsPtr);
-  const auto vDBPtr = std::make_shared<VariantStore>(paramsPtr);
+  // store is only accessed from this thread, which also writes the output VCF
+  VariantStore variantStore(paramsPtr, contigIDs);
+  if (isResumed) variantStore.SetFlushedUpto(resumeFrom.lastFlushedChrom, resumeFrom.lastFlushedEnd0);
+
+  if (params->numShards > 1) {
+    LOG_INFO("Processing windows [{}, {}) of {} total windows in shard {}", shardStart, shardEnd,
+             windowGen->TotalWindows(), params->shardSpec);
+  }
 
-  LOG_INFO("Processing {} windows in {} microassembler thread(s)", allwindows.size(), params->numWorkerThreads);
+  LOG_INFO("Processing {} windows in {} microassembler thread(s)", shardEnd - firstWindowIdx,
+           params->numWorkerThreads);
   std::vector<std::future<void>> assemblers;
   assemblers.reserve(numThreads);
 
-  const auto resultQueuePtr = std::make_shared<OutResultQueue>(allwindows.size());
-  const auto windowQueuePtr = std::make_shared<InWindowQueue>(allwindows.size());
-  moodycamel::ProducerToken windowProducerToken(*windowQueuePtr);
-  windowQueuePtr->enqueue_bulk(windowProducerToken, allwindows.begin(), allwindows.size());
+  // scheduler hands out windows to prefetch threads when reads are fetched ahead of assembly
+  const auto numPrefetchThreads = static_cast<std::size_t>(params->numPrefetchThreads);
+  const auto numSchedWorkers = numPrefetchThreads > 0 ? numPrefetchThreads : numThreads;
+  const auto resultQueuePtr = std::make_shared<OutResultQueue>();
+  const auto bufferPoolPtr = std::make_shared<VariantBufferPool>();
+  const auto schedulerPtr = std::make_shared<WindowScheduler>(std::move(windowGen), numSchedWorkers, paramsPtr,
+                                                              activeIndex);
+
+  std::shared_ptr<WindowPrefetcher> prefetcherPtr;
+  if (numPrefetchThreads > 0) {
+    const auto maxQueued = numThreads * DEFAULT_PREFETCH_WINDOWS_PER_WORKER;
+    prefetcherPtr = std::make_shared<WindowPrefetcher>(schedulerPtr, maxQueued, paramsPtr);
+    prefetcherPtr->Start(numPrefetchThreads);
+    LOG_INFO("Prefetching reads for upto {} windows in {} prefetch thread(s)", maxQueued, numPrefetchThreads);
+  }
 
-  static absl::FixedArray<bool> doneWindows(allwindows.size());
-  doneWindows.fill(false);
   std::set_terminate([]() -> void {
     LOG_CRITICAL("Caught unexpected program termination call! Exiting abnormally...");
-    for (bool& doneWindow : doneWindows) doneWindow = true;
     std::abort();
   });
 
   for (std::size_t idx = 0; idx < numThreads; ++idx) {
     assemblers.emplace_back(std::async(
-        std::launch::async, [&vDBPtr](std::unique_ptr<MicroAssembler> m) -> void { m->Process(vDBPtr); },
-        std::make_unique<MicroAssembler>(windowQueuePtr, resultQueuePtr, paramsPtr)));
+        std::launch::async, [](std::unique_ptr<MicroAssembler> m) -> void { m->Process(); },
+        std::make_unique<MicroAssembler>(schedulerPtr, idx, resultQueuePtr, bufferPoolPtr, paramsPtr,
+                                         prefetcherPtr)));
   }
 
-  const auto anyWindowsRunning = []() -> bool {
-    return std::any_of(doneWindows.cbegin(), doneWindows.cend(), [](const bool& wdone) { return !wdone; });
-  };
-
-  const auto allWindowsUptoDone = [](const std::size_t win_idx) -> bool {
-    const auto* lastItr = win_idx >= doneWindows.size() ? doneWindows.cend() : doneWindows.cbegin() + win_idx;
-    return std::all_of(doneWindows.cbegin(), lastItr, [](const bool& wdone) { return wdone; });
-  };
-
-  std::size_t idxToFlush = 0;
-  std::size_t numDone = 0;
-  const auto numTotal = allwindows.size();
+  std::size_t idxToFlush = firstWindowIdx;
+  CompletionTracker doneWindows(firstWindowIdx);
+  auto lastCkptTime = absl::Now();
+  // windows done but not flushed yet, bounded by the spread of windows in flight
+  absl::flat_hash_map<std::size_t, std::shared_ptr<const RefWindow>> unflushedWindows;
+  std::vector<std::shared_ptr<const RefWindow>> timedOutWindows;
+  const auto numTotal = shardEnd - shardStart;
   const auto pctDone = [&numTotal](const std::size_t done) -> double {
     return 100.0 * (static_cast<double>(done) / static_cast<double>(numTotal));
   };
 
   WindowResult result;
   moodycamel::ConsumerToken resultConsumerToken(*resultQueuePtr);
-  while (anyWindowsRunning()) {
+  while (doneWindows.Watermark() < shardEnd) {
     resultQueuePtr->wait_dequeue(resultConsumerToken, result);
 
-    numDone++;
-    doneWindows[result.windowIdx] = true;
-    const auto windowID = allwindows[result.windowIdx]->ToRegionString();
-    LOG_INFO("Progress: {:>7.3f}% | {} processed in {}", pctDone(numDone), windowID, Humanized(result.runtime));
+    variantStore.AddVariants(absl::MakeSpan(result.variants));
+    // drained buffer goes back to the workers, so its capacity is reused for later windows
+    result.variants.clear();
+    bufferPoolPtr->enqueue(std::move(result.variants));
+    doneWindows.MarkDone(result.windowIdx);
+    const auto windowID = result.window->ToRegionString();
+    if (result.timedOut) timedOutWindows.emplace_back(result.window);
+    unflushedWindows.emplace(result.windowIdx, std::move(result.window));
+    LOG_INFO("Progress: {:>7.3f}% | {} processed in {}", pctDone(firstWindowIdx - shardStart + doneWindows.NumDone()),
+             windowID, Humanized(result.runtime));
 
-    if (allWindowsUptoDone(idxToFlush + numBufWindows)) {
-      const auto flushed = vDBPtr->FlushWindow(*allwindows[idxToFlush], outVcf, contigIDs);
-      if (flushed) {
-        LOG_DEBUG("Flushed variants from {} to output vcf", allwindows[idxToFlush]->ToRegionString());
-        outVcf.flush();
-      }
+    // A window is flushed once all windows upto `numBufWindows` after it are done. Completion of a
+    // long running window can move the watermark far enough to flush several windows at once
+    while (idxToFlush < shardEnd && doneWindows.Watermark() >= std::min(idxToFlush + numBufWindows, shardEnd)) {
+      const auto itr = unflushedWindows.find(idxToFlush);
+      LANCET_ASSERT(itr != unflushedWindows.end());  // NOLINT
+      const auto flushed = variantStore.FlushWindow(*itr->second, outVcf, extraOutputs);
+      if (flushed) LOG_DEBUG("Flushed variants from {} to output vcf", itr->second->ToRegionString());
 
+      lastCkpt.lastFlushedChrom = itr->second->Chromosome();
+      lastCkpt.lastFlushedEnd0 = itr->second->EndPosition0();
+      unflushedWindows.erase(itr);
       idxToFlush++;
     }
+
+    if (useJournal && idxToFlush > lastCkpt.numFlushedWindows && (absl::Now() - lastCkptTime) >= CHECKPOINT_INTERVAL) {
+      // output is flushed before recording checkpoint, so the journal never points past what is on disk
+      outVcf.Flush();
+      lastCkpt.numFlushedWindows = idxToFlush;
+      lastCkpt.numDoneWindows = doneWindows.Watermark();
+      lastCkpt.vcfOffset = outVcf.Offset();
+      journal.Record(lastCkpt);
+      lastCkptTime = absl::Now();
+    }
+  }
+
+  variantStore.FlushAll(outVcf, extraOutputs);
+  outVcf.Close();
+  for (auto& profileVcf : profileVcfs) profileVcf.Close();
+  if (evidence != nullptr) {
+    const auto evidenceStatus = evidence->Close();
+    if (!evidenceStatus.ok()) {
+      LOG_ERROR(evidenceStatus.message());
+      std::exit(EXIT_FAILURE);
+    }
   }
+  if (useJournal) journal.Remove();
 
-  vDBPtr->FlushAll(outVcf, contigIDs);
-  outVcf.close();
+  std::sort(timedOutWindows.begin(), timedOutWindows.end(),
+            [](const auto& lhs, const auto& rhs) -> bool { return lhs->WindowIndex() < rhs->WindowIndex(); });
+  ReportTimedOutWindows(*params, absl::MakeConstSpan(timedOutWindows));
 
   // just to make sure futures get collected and threads released
   std::for_each(assemblers.begin(), assemblers.end(), [](std::future<void>& fut) { return fut.get(); });
+  if (prefetcherPtr != nullptr) prefetcherPtr->Join();
   LOG_INFO("Successfully completed lancet pipeline | Runtime={}", T.HumanRuntime());
   std::exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,77 @@
+#include "lancet/scan_active_regions.h"
+
+#include <cstdlib>
+#include <exception>
+#include <future>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "lancet/active_region_index.h"
+#include "lancet/fasta_reader.h"
+#include "lancet/hts_reader.h"
+#include "lancet/log_macros.h"
+#include "lancet/timer.h"
+#include "spdlog/spdlog.h"
+
+namespace lancet {
+static inline void ExitOnError(const absl::Status& status) {
+  if (status.ok()) return;
+  LOG_ERROR(status.message());
+  std::exit(EXIT_FAILURE);
+}
+
+static inline auto ReadContigsMatch(const std::string& aln_path, const CliParams& p,
+                                    absl::Span<const ContigInfo> ref_contigs) -> bool {
+  HtsReader rdr(aln_path, p.referencePath);
+  return CheckContigsMatch(rdr.ContigsInfo(), ref_contigs);
+}
+
+void RunScan(std::shared_ptr<CliParams> params) {  // NOLINT
+  Timer T;
+  if (params->verboseLogging) spdlog::get("stderr")->set_level(spdlog::level::trace);
+
+  if (params->numHtsThreads > 0) {
+    InitSharedHtsThreadPool(static_cast<int>(params->numHtsThreads));
+    LOG_INFO("Created shared pool of {} thread(s) to decompress BAM/CRAM blocks", params->numHtsThreads);
+  }
+
+  const auto refContigs = FastaReader(params->referencePath).ContigsInfo();
+  const auto refContigsSpan = absl::MakeConstSpan(refContigs);
+  if (!params->noCtgCheck && (!ReadContigsMatch(params->tumorPath, *params, refContigsSpan) ||
+                              !ReadContigsMatch(params->normalPath, *params, refContigsSpan))) {
+    LOG_ERROR("Reference contigs in tumor/normal BAM/CRAMs do not match with reference FASTA.");
+    std::exit(EXIT_FAILURE);
+  }
+
+  // pipeline turns off active region detection without MD tags, so an index would never be used
+  if (!HasTag(params->tumorPath, params->referencePath, "MD") &&
+      !HasTag(params->normalPath, params->referencePath, "MD")) {
+    LOG_ERROR("MD tag is missing from tumor and normal BAMs/CRAMs. Active region index cannot be used without it.");
+    std::exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("Scanning tumor {} and normal {} for active regions", params->tumorPath, params->normalPath);
+  const auto scanSample = [&params, &refContigsSpan](const std::string& aln_path) -> SampleScan {
+    return ScanSample(aln_path, *params, refContigsSpan);
+  };
+
+  auto tmrScan = std::async(std::launch::async, scanSample, params->tumorPath);
+  auto nmlScan = std::async(std::launch::async, scanSample, params->normalPath);
+
+  ActiveRegionIndex index(refContigs, params->minTmrAltCnt, params->minBaseQual);
+  try {
+    index.AddSample(tmrScan.get(), SampleLabel::TUMOR);
+    index.AddSample(nmlScan.get(), SampleLabel::NORMAL);
+  } catch (const std::exception& exception) {
+    LOG_ERROR("Could not scan alignments: {}", exception.what());
+    std::exit(EXIT_FAILURE);
+  }
+
+  ExitOnError(index.Write(params->activeRegionsPath));
+  LOG_INFO("Wrote {} active intervals spanning {} bases to {} | Runtime={}", index.NumActiveIntervals(),
+           index.NumActiveBases(), params->activeRegionsPath, T.HumanRuntime());
+  std::exit(EXIT_SUCCESS);
+}
+}  // namespace lancet
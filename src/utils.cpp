@@ -1,5 +1,10 @@
 #include "lancet/utils.h"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+
 #include "absl/container/flat_hash_set.h"
 
 namespace lancet::utils {
@@ -90,6 +95,29 @@ void PushRevCompSeq(std::string_view sequence, std::string* result) {
                 [&result](const char& b) { result->push_back(utils::RevComp(b)); });
 }
 
+void PushUnsigned(std::uint64_t value, std::string* result) {
+  std::array<char, 20> buffer{};  // NOLINT max. digits in a 64-bit unsigned integer
+  const auto converted = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  result->append(buffer.data(), converted.ptr);
+}
+
+void PushFixed(double value, std::string* result) {
+#if defined(__cpp_lib_to_chars)
+  std::array<char, 64> buffer{};  // NOLINT
+  const auto converted =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), value, std::chars_format::fixed, 6);  // NOLINT
+  if (converted.ec == std::errc()) {
+    result->append(buffer.data(), converted.ptr);
+    return;
+  }
+#endif
+
+  // standard libraries without floating point to_chars, or values too large for the buffer above
+  std::array<char, 384> fallback{};  // NOLINT fits %f of the largest double
+  const auto numChars = std::snprintf(fallback.data(), fallback.size(), "%f", value);  // NOLINT
+  if (numChars > 0) result->append(fallback.data(), std::min(static_cast<std::size_t>(numChars), fallback.size() - 1));
+}
+
 void PushSeq(std::string* result, std::string::iterator position, std::string_view sequence, std::size_t start_offset,
              std::size_t end_offset) {
   result->insert(position, sequence.cbegin() + start_offset, sequence.cbegin() + end_offset);
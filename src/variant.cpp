@@ -1,11 +1,9 @@
 #include "lancet/variant.h"
 
 #include <algorithm>
-#include <vector>
+#include <array>
 
 #include "absl/hash/internal/city.h"
-#include "absl/strings/str_format.h"
-#include "absl/strings/str_join.h"
 #include "lancet/assert_macro.h"
 #include "lancet/fisher_exact.h"
 #include "lancet/utils.h"
@@ -13,6 +11,7 @@
 namespace lancet {
 Variant::Variant(const Transcript& transcript, std::size_t kmer_size)
     : ChromName(transcript.ChromName()),
+      ContigIdx(-1),
       Position(transcript.Position()),
       RefAllele(transcript.RefSeq()),
       AltAllele(transcript.AltSeq()),
@@ -52,76 +51,154 @@ Variant::Variant(const Transcript& transcript, std::size_t kmer_size)
     AltAllele.insert(AltAllele.begin(), 1, transcript.PrevAltBase());
     Position--;
   }
-}
 
-auto Variant::MakeVcfLine(const CliParams& params) const -> std::string {
-  const auto somaticScore = PhredFisherScore(NormalCov.TotalRefCov(), TumorCov.TotalRefCov(), NormalCov.TotalAltCov(),
-                                             TumorCov.TotalAltCov());
+  identity = AlleleHash(RefAllele, AltAllele);
+}
 
-  const auto strandBiasScore =
-      PhredFisherScore(TumorCov.refAl.fwdCov, TumorCov.refAl.revCov, TumorCov.altAl.fwdCov, TumorCov.altAl.revCov);
+Variant::Variant(std::string chrom, std::size_t pos, std::string ref, std::string alt, TranscriptCode kind,
+                 std::size_t length, std::size_t kmer_size, VariantHpCov tmr_cov, VariantHpCov nml_cov)
+    : ChromName(std::move(chrom)),
+      ContigIdx(-1),
+      Position(pos),
+      RefAllele(std::move(ref)),
+      AltAllele(std::move(alt)),
+      Kind(kind),
+      Length(length),
+      KmerSize(kmer_size),
+      TumorCov(tmr_cov),
+      NormalCov(nml_cov),
+      identity(AlleleHash(RefAllele, AltAllele)) {}
 
-  const auto varState = ComputeState();
-  LANCET_ASSERT(varState != VariantState::NONE);  // NOLINT
+auto Variant::MakeVcfLine(const CliParams& params) const -> std::string {
+  std::string result;
+  AppendVcfLine(params, &result);
+  return result;
+}
 
-  auto info = absl::StrFormat("%s;FETS=%f;TYPE=%s;LEN=%d;KMERSIZE=%d;SB=%f", ToString(varState), somaticScore,
-                              ToString(Kind), Length, KmerSize, strandBiasScore);
+void Variant::AppendVcfLine(const CliParams& params, std::string* out) const {
+  const auto ann = Annotate(params);
+  const auto pushTab = [out]() { out->push_back('\t'); };
+
+  out->append(ChromName);
+  pushTab();
+  utils::PushUnsigned(Position, out);
+  out->append("\t.\t");
+  out->append(RefAllele);
+  pushTab();
+  out->append(AltAllele);
+  pushTab();
+  utils::PushFixed(ann.somaticScore, out);
+  pushTab();
+
+  if (ann.filters.none()) out->append("PASS");
+  for (std::size_t idx = 0, numAdded = 0; idx < NUM_VCF_FILTERS; ++idx) {
+    if (!ann.filters.test(idx)) continue;
+    if (numAdded++ > 0) out->push_back(';');
+    out->append(VCF_FILTER_NAMES[idx]);
+  }
 
-  if (!STRResult.empty()) info += absl::StrFormat(";MS=%s", STRResult);
+  pushTab();
+  out->append(ToString(ann.state));
+  out->append(";FETS=");
+  utils::PushFixed(ann.somaticScore, out);
+  out->append(";TYPE=");
+  out->append(ToString(Kind));
+  out->append(";LEN=");
+  utils::PushUnsigned(Length, out);
+  out->append(";KMERSIZE=");
+  utils::PushUnsigned(KmerSize, out);
+  out->append(";SB=");
+  utils::PushFixed(ann.strandBiasScore, out);
+
+  if (!STRResult.empty()) {
+    out->append(";MS=");
+    out->append(STRResult);
+  }
 
   if (params.tenxMode) {
-    const auto nmlHpScore = PhredFisherScore(NormalCov.RefHP(Haplotype::FIRST), NormalCov.RefHP(Haplotype::SECOND),
-                                             NormalCov.AltHP(Haplotype::FIRST), NormalCov.AltHP(Haplotype::SECOND));
-
-    const auto tmrHpScore = PhredFisherScore(TumorCov.RefHP(Haplotype::FIRST), TumorCov.RefHP(Haplotype::SECOND),
-                                             TumorCov.AltHP(Haplotype::FIRST), TumorCov.AltHP(Haplotype::SECOND));
-
-    const auto pairHpScore = PhredFisherScore(NormalCov.TotalHP(Haplotype::FIRST), NormalCov.TotalHP(Haplotype::SECOND),
-                                              TumorCov.TotalHP(Haplotype::FIRST), TumorCov.TotalHP(Haplotype::SECOND));
-
-    info += absl::StrFormat(";HPS=%f;HPSN=%f;HPST=%f", pairHpScore, nmlHpScore, tmrHpScore);
+    out->append(";HPS=");
+    utils::PushFixed(ann.pairHpScore, out);
+    out->append(";HPSN=");
+    utils::PushFixed(ann.nmlHpScore, out);
+    out->append(";HPST=");
+    utils::PushFixed(ann.tmrHpScore, out);
   }
 
-  const auto lowSomaticScore =
-      !STRResult.empty() ? somaticScore < params.minSTRFisher : somaticScore < params.minFisher;
+  out->append(params.tenxMode ? "\tGT:AD:SR:SA:DP:HPR:HPA\t" : "\tGT:AD:SR:SA:DP\t");
+  AppendSampleFormat(NormalCov, params.tenxMode, out);
+  pushTab();
+  AppendSampleFormat(TumorCov, params.tenxMode, out);
+  out->push_back('\n');
+}
+
+void Variant::RenderRecord(const CliParams& params) {
+  Record.clear();
+  AppendVcfLine(params, &Record);
+}
 
-  std::vector<std::string> filters;
-  if (lowSomaticScore && !STRResult.empty()) filters.emplace_back("LowFisherSTR");
-  if (lowSomaticScore && STRResult.empty()) filters.emplace_back("LowFisherScore");
-  if (NormalCov.TotalCov() < params.minNmlCov) filters.emplace_back("LowCovNormal");
-  if (NormalCov.TotalCov() > params.maxNmlCov) filters.emplace_back("HighCovNormal");
-  if (TumorCov.TotalCov() < params.minTmrCov) filters.emplace_back("LowCovTumor");
-  if (TumorCov.TotalCov() > params.maxTmrCov) filters.emplace_back("HighCovTumor");
+auto Variant::Annotate(const CliParams& params) const -> VariantAnnotation {
+  VariantAnnotation result;
+  result.state = ComputeState();
+  LANCET_ASSERT(result.state != VariantState::NONE);  // NOLINT
+
+  // FETS, SB and in tenx mode HPSN, HPST & HPS tables are scored in one batch
+  const std::array<FisherCounts, 5> tables{
+      FisherCounts{NormalCov.TotalRefCov(), TumorCov.TotalRefCov(), NormalCov.TotalAltCov(), TumorCov.TotalAltCov()},
+      FisherCounts{TumorCov.refAl.fwdCov, TumorCov.refAl.revCov, TumorCov.altAl.fwdCov, TumorCov.altAl.revCov},
+      FisherCounts{NormalCov.RefHP(Haplotype::FIRST), NormalCov.RefHP(Haplotype::SECOND),
+                   NormalCov.AltHP(Haplotype::FIRST), NormalCov.AltHP(Haplotype::SECOND)},
+      FisherCounts{TumorCov.RefHP(Haplotype::FIRST), TumorCov.RefHP(Haplotype::SECOND),
+                   TumorCov.AltHP(Haplotype::FIRST), TumorCov.AltHP(Haplotype::SECOND)},
+      FisherCounts{NormalCov.TotalHP(Haplotype::FIRST), NormalCov.TotalHP(Haplotype::SECOND),
+                   TumorCov.TotalHP(Haplotype::FIRST), TumorCov.TotalHP(Haplotype::SECOND)}};
+
+  std::array<double, 5> scores{};
+  const auto numTables = params.tenxMode ? tables.size() : 2;
+  PhredFisherScores(absl::MakeConstSpan(tables.data(), numTables), absl::MakeSpan(scores.data(), numTables));
+
+  result.somaticScore = scores[0];
+  result.strandBiasScore = scores[1];
+  result.nmlHpScore = scores[2];   // NOLINT
+  result.tmrHpScore = scores[3];   // NOLINT
+  result.pairHpScore = scores[4];  // NOLINT
+
+  const auto lowSomaticScore = !STRResult.empty() ? result.somaticScore < params.minSTRFisher
+                                                  : result.somaticScore < params.minFisher;
+
+  if (lowSomaticScore && !STRResult.empty()) result.AddFilter(VcfFilter::LOW_FISHER_STR);
+  if (lowSomaticScore && STRResult.empty()) result.AddFilter(VcfFilter::LOW_FISHER_SCORE);
+  if (NormalCov.TotalCov() < params.minNmlCov) result.AddFilter(VcfFilter::LOW_COV_NORMAL);
+  if (NormalCov.TotalCov() > params.maxNmlCov) result.AddFilter(VcfFilter::HIGH_COV_NORMAL);
+  if (TumorCov.TotalCov() < params.minTmrCov) result.AddFilter(VcfFilter::LOW_COV_TUMOR);
+  if (TumorCov.TotalCov() > params.maxTmrCov) result.AddFilter(VcfFilter::HIGH_COV_TUMOR);
 
   const auto tmrVaf = TumorCov.VAF();
   const auto nmlVaf = NormalCov.VAF();
 
-  if (tmrVaf < params.minTmrVAF) filters.emplace_back("LowVafTumor");
-  if (nmlVaf > params.maxNmlVAF) filters.emplace_back("HighVafNormal");
-  if (TumorCov.TotalAltCov() < params.minTmrAltCnt) filters.emplace_back("LowAltCntTumor");
-  if (NormalCov.TotalAltCov() > params.maxNmlAltCnt) filters.emplace_back("HighAltCntNormal");
+  if (tmrVaf < params.minTmrVAF) result.AddFilter(VcfFilter::LOW_VAF_TUMOR);
+  if (nmlVaf > params.maxNmlVAF) result.AddFilter(VcfFilter::HIGH_VAF_NORMAL);
+  if (TumorCov.TotalAltCov() < params.minTmrAltCnt) result.AddFilter(VcfFilter::LOW_ALT_CNT_TUMOR);
+  if (NormalCov.TotalAltCov() > params.maxNmlAltCnt) result.AddFilter(VcfFilter::HIGH_ALT_CNT_NORMAL);
 
   if (TumorCov.altAl.fwdCov < params.minStrandCnt || TumorCov.altAl.revCov < params.minStrandCnt) {
-    filters.emplace_back("StrandBias");
+    result.AddFilter(VcfFilter::STRAND_BIAS);
   }
 
-  if (params.tenxMode && varState == VariantState::SOMATIC && TumorCov.AltHP(Haplotype::FIRST) > 0 &&
+  if (params.tenxMode && result.state == VariantState::SOMATIC && TumorCov.AltHP(Haplotype::FIRST) > 0 &&
       TumorCov.AltHP(Haplotype::SECOND) > 0) {
-    filters.emplace_back("MultiHP");
+    result.AddFilter(VcfFilter::MULTI_HP);
   }
 
-  const std::string filter = filters.empty() ? "PASS" : absl::StrJoin(filters, ";");
-  const auto* format = params.tenxMode ? "GT:AD:SR:SA:DP:HPR:HPA" : "GT:AD:SR:SA:DP";
-
-  return absl::StrFormat("%s\t%d\t.\t%s\t%s\t%f\t%s\t%s\t%s\t%s\t%s\n", ChromName, Position, RefAllele, AltAllele,
-                         somaticScore, filter, info, format, BuildSampleFormat(NormalCov, params.tenxMode),
-                         BuildSampleFormat(TumorCov, params.tenxMode));
+  return result;
 }
 
-auto Variant::ID() const -> VariantID {
-  const auto state = absl::StrFormat("%s|%d|%s|%s", ChromName, Position, RefAllele, AltAllele);
-  return absl::hash_internal::CityHash64WithSeeds(state.c_str(), state.length(), utils::PRIME_0,  // NOLINT
-                                                  utils::PRIME_1);
+auto Variant::AlleleHash(std::string_view ref, std::string_view alt) -> VariantID {
+  // contig and position are compared before the hash, so only the alleles are hashed. Alleles are chained
+  // through the hash seeds, and ref allele length is part of the seed, so that alleles split at different
+  // offsets hash differently
+  using absl::hash_internal::CityHash64WithSeeds;
+  const auto refHash = CityHash64WithSeeds(ref.data(), ref.length(), utils::PRIME_0, utils::PRIME_1);
+  return CityHash64WithSeeds(alt.data(), alt.length(), refHash, ref.length());
 }
 
 auto Variant::ComputeState() const -> VariantState {
@@ -134,25 +211,36 @@ auto Variant::ComputeState() const -> VariantState {
   return VariantState::NONE;
 }
 
-auto Variant::Genotype(int ref, int alt) -> std::string {
+auto Variant::Genotype(int ref, int alt) -> const char* {
   if (ref > 0 && alt == 0) return "0/0";
   if (ref > 0 && alt > 0) return "0/1";
   if (ref == 0 && alt > 0) return "1/1";
   return "./.";
 }
 
-auto Variant::BuildSampleFormat(const VariantHpCov& v, bool is_tenx_mode) -> std::string {
-  //  const auto FORMAT = params.tenxModeOn ? "GT:AD:SR:SA:DP:HPR:HPA" : "GT:AD:SR:SA:DP";
-  auto result =
-      absl::StrFormat("%s:%d,%d:%d,%d:%d,%d:%d", Genotype(v.TotalRefCov(), v.TotalAltCov()), v.TotalRefCov(),
-                      v.TotalAltCov(), v.refAl.fwdCov, v.refAl.revCov, v.altAl.fwdCov, v.altAl.revCov, v.TotalCov());
+void Variant::AppendSampleFormat(const VariantHpCov& v, bool is_tenx_mode, std::string* out) {
+  //  FORMAT = is_tenx_mode ? "GT:AD:SR:SA:DP:HPR:HPA" : "GT:AD:SR:SA:DP";
+  const auto pushPair = [out](char sep, std::uint64_t first, std::uint64_t second) {
+    out->push_back(sep);
+    utils::PushUnsigned(first, out);
+    out->push_back(',');
+    utils::PushUnsigned(second, out);
+  };
+
+  out->append(Genotype(v.TotalRefCov(), v.TotalAltCov()));
+  pushPair(':', v.TotalRefCov(), v.TotalAltCov());
+  pushPair(':', v.refAl.fwdCov, v.refAl.revCov);
+  pushPair(':', v.altAl.fwdCov, v.altAl.revCov);
+  out->push_back(':');
+  utils::PushUnsigned(v.TotalCov(), out);
 
   if (is_tenx_mode) {
-    result += absl::StrFormat(":%d,%d,%d:%d,%d,%d", v.RefHP(Haplotype::FIRST), v.RefHP(Haplotype::SECOND),
-                              v.RefHP(Haplotype::UNASSIGNED), v.AltHP(Haplotype::FIRST), v.AltHP(Haplotype::SECOND),
-                              v.AltHP(Haplotype::UNASSIGNED));
+    pushPair(':', v.RefHP(Haplotype::FIRST), v.RefHP(Haplotype::SECOND));
+    out->push_back(',');
+    utils::PushUnsigned(v.RefHP(Haplotype::UNASSIGNED), out);
+    pushPair(':', v.AltHP(Haplotype::FIRST), v.AltHP(Haplotype::SECOND));
+    out->push_back(',');
+    utils::PushUnsigned(v.AltHP(Haplotype::UNASSIGNED), out);
   }
-
-  return result;
 }
 }  // namespace lancet
@@ -0,0 +1,152 @@
+#include "lancet/variant_evidence.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "absl/strings/str_format.h"
+#include "lancet/assert_macro.h"
+#include "lancet/binary_io.h"
+
+namespace lancet {
+static constexpr std::array<char, 8> EVIDENCE_MAGIC = {'L', 'N', 'C', 'T', 'E', 'V', 'I', 'D'};
+static constexpr std::uint32_t EVIDENCE_VERSION = 1;
+
+static inline void WriteCov(std::ostream& out, const HpCov& cov) {
+  for (const auto val : {cov.fwdCov, cov.revCov, cov.HP0, cov.HP1, cov.HP2}) WriteInt(out, val);
+}
+
+[[nodiscard]] static inline auto ReadCov(std::istream& inp) -> std::optional<HpCov> {
+  std::array<std::uint16_t, 5> vals{};
+  for (auto& val : vals) {
+    if (!ReadInt(inp, &val)) return std::nullopt;
+  }
+
+  return HpCov({vals[0], vals[1]}, {vals[2], vals[3], vals[4]});  // NOLINT
+}
+
+auto EvidenceWriter::Open(const EvidenceHeader& hdr) -> absl::Status {
+  outFh.open(outPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (!outFh.is_open()) {
+    return absl::PermissionDeniedError(absl::StrFormat("could not open evidence file %s", outPath.string()));
+  }
+
+  outFh.write(EVIDENCE_MAGIC.data(), EVIDENCE_MAGIC.size());
+  WriteInt(outFh, EVIDENCE_VERSION);
+  WriteInt(outFh, static_cast<std::uint8_t>(hdr.tenxMode));
+  WriteString(outFh, hdr.referencePath);
+
+  WriteInt(outFh, static_cast<std::uint32_t>(hdr.sampleNames.size()));
+  for (const auto& sampleName : hdr.sampleNames) WriteString(outFh, sampleName);
+
+  WriteInt(outFh, static_cast<std::uint32_t>(hdr.contigs.size()));
+  for (const auto& ctg : hdr.contigs) {
+    WriteString(outFh, ctg.contigName);
+    WriteInt(outFh, ctg.contigLen);
+  }
+
+  return outFh.good() ? absl::OkStatus()
+                      : absl::DataLossError(absl::StrFormat("could not write evidence file %s", outPath.string()));
+}
+
+void EvidenceWriter::Write(const Variant& var) {
+  LANCET_ASSERT(var.ContigIdx >= 0);  // NOLINT
+  WriteInt(outFh, static_cast<std::uint32_t>(var.ContigIdx));
+  WriteInt(outFh, static_cast<std::uint64_t>(var.Position));
+  WriteInt(outFh, static_cast<std::uint8_t>(var.Kind));
+  WriteInt(outFh, static_cast<std::uint32_t>(var.Length));
+  WriteInt(outFh, static_cast<std::uint32_t>(var.KmerSize));
+  WriteCov(outFh, var.TumorCov.refAl);
+  WriteCov(outFh, var.TumorCov.altAl);
+  WriteCov(outFh, var.NormalCov.refAl);
+  WriteCov(outFh, var.NormalCov.altAl);
+  WriteString(outFh, var.RefAllele);
+  WriteString(outFh, var.AltAllele);
+  WriteString(outFh, var.STRResult);
+}
+
+auto EvidenceWriter::Close() -> absl::Status {
+  outFh.close();
+  return outFh.fail() ? absl::DataLossError(absl::StrFormat("could not write evidence file %s", outPath.string()))
+                      : absl::OkStatus();
+}
+
+auto EvidenceReader::Open() -> absl::Status {
+  inFh.open(inPath, std::ios_base::in | std::ios_base::binary);
+  if (!inFh.is_open()) return absl::NotFoundError(absl::StrFormat("could not open evidence file %s", inPath.string()));
+
+  std::array<char, EVIDENCE_MAGIC.size()> magic{};
+  std::uint32_t version = 0;
+  std::uint8_t tenxMode = 0;
+  if (!inFh.read(magic.data(), magic.size()) || magic != EVIDENCE_MAGIC || !ReadInt(inFh, &version) ||
+      version != EVIDENCE_VERSION) {
+    return absl::InvalidArgumentError(absl::StrFormat("%s is not a lancet evidence file", inPath.string()));
+  }
+
+  const auto corrupt = absl::DataLossError(absl::StrFormat("corrupt header in evidence file %s", inPath.string()));
+  if (!ReadInt(inFh, &tenxMode) || !ReadString(inFh, &header.referencePath)) return corrupt;
+  header.tenxMode = tenxMode != 0;
+
+  std::uint32_t numSamples = 0;
+  if (!ReadInt(inFh, &numSamples)) return corrupt;
+  header.sampleNames.resize(numSamples);
+  for (auto& sampleName : header.sampleNames) {
+    if (!ReadString(inFh, &sampleName)) return corrupt;
+  }
+
+  std::uint32_t numContigs = 0;
+  if (!ReadInt(inFh, &numContigs)) return corrupt;
+  header.contigs.resize(numContigs);
+  for (auto& ctg : header.contigs) {
+    if (!ReadString(inFh, &ctg.contigName) || !ReadInt(inFh, &ctg.contigLen)) return corrupt;
+  }
+
+  return absl::OkStatus();
+}
+
+auto EvidenceReader::Next(std::optional<Variant>* result) -> absl::Status {
+  result->reset();
+
+  std::uint32_t ctgIdx = 0;
+  if (!ReadInt(inFh, &ctgIdx)) {
+    // clean end of file only if no bytes of the next record were read
+    return inFh.eof() && inFh.gcount() == 0
+               ? absl::OkStatus()
+               : absl::DataLossError(absl::StrFormat("truncated record in evidence file %s", inPath.string()));
+  }
+
+  std::uint64_t position = 0;
+  std::uint8_t kind = 0;
+  std::uint32_t length = 0;
+  std::uint32_t kmerSize = 0;
+  const auto truncated = absl::DataLossError(absl::StrFormat("truncated record in evidence file %s", inPath.string()));
+  if (!ReadInt(inFh, &position) || !ReadInt(inFh, &kind) || !ReadInt(inFh, &length) || !ReadInt(inFh, &kmerSize)) {
+    return truncated;
+  }
+
+  const auto tmrRef = ReadCov(inFh);
+  const auto tmrAlt = ReadCov(inFh);
+  const auto nmlRef = ReadCov(inFh);
+  const auto nmlAlt = ReadCov(inFh);
+  std::string refAllele;
+  std::string altAllele;
+  std::string strResult;
+  if (!tmrRef || !tmrAlt || !nmlRef || !nmlAlt || !ReadString(inFh, &refAllele) || !ReadString(inFh, &altAllele) ||
+      !ReadString(inFh, &strResult)) {
+    return truncated;
+  }
+
+  if (ctgIdx >= header.contigs.size() || kind > static_cast<std::uint8_t>(TranscriptCode::COMPLEX)) {
+    return absl::DataLossError(absl::StrFormat("corrupt record in evidence file %s", inPath.string()));
+  }
+
+  result->emplace(header.contigs[ctgIdx].contigName, position, std::move(refAllele), std::move(altAllele),
+                  static_cast<TranscriptCode>(kind), length, kmerSize, VariantHpCov(*tmrRef, *tmrAlt),
+                  VariantHpCov(*nmlRef, *nmlAlt));
+
+  auto& var = result->value();
+  var.ContigIdx = static_cast<std::int64_t>(ctgIdx);
+  var.STRResult = std::move(strResult);
+  return absl::OkStatus();
+}
+}  // namespace lancet
@@ -1,19 +1,83 @@
 #include "lancet/variant_store.h"
 
+#include <unistd.h>
+
 #include <algorithm>
-#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
 #include <utility>
+#include <vector>
 
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "generated/lancet_version.h"
+#include "lancet/assert_macro.h"
+#include "lancet/log_macros.h"
+#include "spdlog/spdlog.h"
 
 namespace lancet {
-VariantStore::VariantStore(std::shared_ptr<const CliParams> p) : params(std::move(p)) {}
+static constexpr std::size_t BYTES_PER_MB = 1024 * 1024;
+
+static inline auto SpillRunPath(std::size_t run_num) -> std::filesystem::path {
+  return std::filesystem::temp_directory_path() / absl::StrFormat("lancet-%d-spill-%d.bin", getpid(), run_num);
+}
+
+// Spilled runs use the evidence file format. Pre-rendered records are not spilled,
+// so spilled variants are formatted by the output thread when they are flushed.
+class VariantStore::SpillRun {
+ public:
+  /// `write_variants` must write variants to the run in sorted order
+  SpillRun(std::filesystem::path path, const EvidenceHeader& hdr,
+           absl::FunctionRef<void(EvidenceWriter&)> write_variants)
+      : runPath(std::move(path)), reader(runPath) {
+    EvidenceWriter writer(runPath);
+    CheckStatus(writer.Open(hdr));
+    write_variants(writer);
+    CheckStatus(writer.Close());
+
+    CheckStatus(reader.Open());
+    Advance();
+  }
+
+  SpillRun() = delete;
+  SpillRun(const SpillRun&) = delete;
+  auto operator=(const SpillRun&) -> SpillRun& = delete;
+  ~SpillRun() {
+    std::error_code err;
+    std::filesystem::remove(runPath, err);
+  }
+
+  /// Smallest variant of the run not flushed yet, empty once all variants in the run are flushed
+  [[nodiscard]] auto Head() -> std::optional<Variant>& { return head; }
+  void Advance() { CheckStatus(reader.Next(&head)); }
+
+ private:
+  std::filesystem::path runPath;
+  EvidenceReader reader;
+  std::optional<Variant> head;
+
+  static void CheckStatus(const absl::Status& status) {
+    if (!status.ok()) throw std::runtime_error(std::string(status.message()));
+  }
+};
+
+VariantStore::VariantStore(std::shared_ptr<const CliParams> p, ContigIDs ctg_ids)
+    : params(std::move(p)), contigIDs(std::move(ctg_ids)) {
+  maxMemBytes = static_cast<std::size_t>(params->maxStoreMemMb) * BYTES_PER_MB;
+
+  // spilled variants only need contig names to be read back, lengths are not used
+  spillHeader.contigs.resize(contigIDs.size());
+  for (const auto& [name, idx] : contigIDs) spillHeader.contigs[static_cast<std::size_t>(idx)] = {name, 0};
+  spillHeader.tenxMode = params->tenxMode;
+}
+
+VariantStore::~VariantStore() = default;
 
-auto VariantStore::GetHeader(const std::vector<std::string>& sample_names, const CliParams& p) -> std::string {
+auto VariantStore::GetHeader(const std::vector<std::string>& sample_names, absl::Span<const ContigInfo> ref_contigs,
+                             const CliParams& p) -> std::string {
   // clang-format off
   const auto stdResult = absl::StrFormat(R"raw(##fileformat=VCFv4.3
 ##fileDate=%s
@@ -59,106 +123,211 @@ auto VariantStore::GetHeader(const std::vector<std::string>& sample_names, const
 ##FORMAT=<ID=HPA,Number=3,Type=Integer,Description="Number of reads supporting alternate allele in haplotype 1, 2 and 0 respectively (0 = Reads with unassigned haplotype)">)raw";
   // clang-format on
 
+  std::string contigLines;
+  for (const auto& ctg : ref_contigs) {
+    absl::StrAppendFormat(&contigLines, "##contig=<ID=%s,length=%d>\n", ctg.contigName, ctg.contigLen);
+  }
+
   const auto chromLine =
       absl::StrFormat("#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t%s\n", absl::StrJoin(sample_names, "\t"));
 
-  return p.tenxMode ? absl::StrFormat("%s%s%s", stdResult, tenxTemplate, chromLine)
-                    : absl::StrFormat("%s%s", stdResult, chromLine);
+  return p.tenxMode ? absl::StrFormat("%s%s\n%s%s", stdResult, tenxTemplate, contigLines, chromLine)
+                    : absl::StrFormat("%s%s%s", stdResult, contigLines, chromLine);
 }
 
-auto VariantStore::TryAddVariants(absl::Span<const Variant> variants) -> bool {
-  const auto isLocked = spinLock.TryLock();
-  if (!isLocked) return false;
+void VariantStore::SetFlushedUpto(const std::string& chrom, std::int64_t end0) {
+  flushedChrom = chrom;
+  flushedEnd0 = end0;
+}
 
-  UnsafeAddVariantBatch(variants);
-  spinLock.Unlock();
-  return true;
+auto VariantStore::FlushWindow(const RefWindow& w, VcfWriter& out, const ExtraOutputs& extra) -> bool {
+  // variants starting upto one base after the window end are flushed along with the window
+  const auto endPos = static_cast<std::size_t>(w.EndPosition0() + 1);
+  const GenomePos bound{contigIDs.at(w.Chromosome()), endPos + 1};
+  return FlushUpto(&bound, out, extra);
 }
 
-void VariantStore::ForceAddVariants(absl::Span<const Variant> variants) {
-  std::lock_guard<utils::SpinLock> guard(spinLock);
-  UnsafeAddVariantBatch(variants);
+auto VariantStore::FlushAll(VcfWriter& out, const ExtraOutputs& extra) -> bool {
+  return FlushUpto(nullptr, out, extra);
 }
 
-auto VariantStore::FlushWindow(const RefWindow& w, std::ostream& out, const ContigIDs& ctg_ids) -> bool {
-  std::lock_guard<utils::SpinLock> guard(spinLock);
+static inline void WriteToOutputs(const Variant& var, const CliParams& params, VcfWriter& out,
+                                  const ExtraOutputs& extra) {
+  out.WriteVariant(var, params);
+  if (extra.evidence != nullptr) extra.evidence->Write(var);
+  for (const auto& [profileOut, profileParams] : extra.profileOutputs) {
+    profileOut->WriteVariantWith(var, *profileParams);
+  }
+}
 
-  using vDBPair = std::pair<std::uint64_t, Variant>;
-  std::vector<VariantID> variantIDsToFlush;
-  variantIDsToFlush.reserve(1024);
-  std::for_each(data.cbegin(), data.cend(), [&variantIDsToFlush, &w, &ctg_ids](const vDBPair& p) {
-    if (IsVariantInOrBefore(p.second, w, ctg_ids)) variantIDsToFlush.emplace_back(p.first);
-  });
+auto VariantStore::FlushUpto(const GenomePos* bound, VcfWriter& out, const ExtraOutputs& extra) -> bool {
+  if (!spillRuns.empty()) {
+    const auto writeVariant = [this, &out, &extra](const Variant& var) { WriteToOutputs(var, *params, out, extra); };
+    return MergeUpto(bound, true, writeVariant);
+  }
 
-  return Flush(absl::MakeConstSpan(variantIDsToFlush), out, ctg_ids);
-}
+  const auto last = bound == nullptr ? data.end() : data.lower_bound(*bound);
+  if (data.begin() == last) return false;
 
-auto VariantStore::FlushAll(std::ostream& out, const ContigIDs& ctg_ids) -> bool {
-  std::lock_guard<utils::SpinLock> guard(spinLock);
-  if (data.empty()) return false;
+  for (auto itr = data.begin(); itr != last; ++itr) {
+    WriteToOutputs(*itr, *params, out, extra);
+    memBytes -= ApproxBytes(*itr);
+  }
 
-  std::vector<std::uint64_t> variantIDsToFlush;
-  variantIDsToFlush.reserve(data.size());
-  for (const auto& p : data) variantIDsToFlush.emplace_back(p.first);
-  return Flush(absl::MakeConstSpan(variantIDsToFlush), out, ctg_ids);
+  // btree releases emptied nodes on erase, so memory shrinks without rebuilding the store
+  data.erase(data.begin(), last);
+  return true;
 }
 
-auto VariantStore::Flush(absl::Span<const VariantID> ids, std::ostream& out, const ContigIDs& ctg_ids) -> bool {
-  std::vector<Variant> variantsToFlush;
-  variantsToFlush.reserve(ids.size());
+auto VariantStore::MergeUpto(const GenomePos* bound, bool with_memory,
+                             absl::FunctionRef<void(const Variant&)> emit) -> bool {
+  const VariantOrder isLess;
+  const auto inRange = [&bound, &isLess](const Variant& var) { return bound == nullptr || isLess(var, *bound); };
+  const auto headOf = [this](std::size_t run_idx) -> const Variant& { return *spillRuns[run_idx]->Head(); };
+
+  // min-heap of runs with variants left, ordered by their head. Runs with the same head pop oldest first
+  const auto runGreater = [&headOf, &isLess](std::size_t lhs, std::size_t rhs) {
+    if (isLess(headOf(rhs), headOf(lhs))) return true;
+    if (isLess(headOf(lhs), headOf(rhs))) return false;
+    return lhs > rhs;
+  };
 
-  for (const auto variantId : ids) {
-    const auto handle = data.extract(variantId);
-    if (handle.empty()) continue;
-    variantsToFlush.emplace_back(handle.mapped());
+  std::vector<std::size_t> runHeap;
+  runHeap.reserve(spillRuns.size());
+  for (std::size_t idx = 0; idx < spillRuns.size(); ++idx) {
+    if (spillRuns[idx]->Head().has_value()) runHeap.push_back(idx);
   }
+  std::make_heap(runHeap.begin(), runHeap.end(), runGreater);
 
-  std::sort(variantsToFlush.begin(), variantsToFlush.end(),
-            [&ctg_ids](const Variant& v1, const Variant& v2) -> bool { return IsVariant1LessThan2(v1, v2, ctg_ids); });
+  std::vector<std::size_t> sameRuns;
+  sameRuns.reserve(spillRuns.size());
+  bool mergedAny = false;
 
-  for (const auto& v : variantsToFlush) {
-    const auto record = v.MakeVcfLine(*params);
-    out.write(record.c_str(), record.length());
-  }
+  while (true) {
+    // erasing from the btree invalidates its iterators, so the smallest variant in memory is looked up every time
+    const auto hasMemHead = with_memory && !data.empty() && inRange(*data.begin());
+    const auto* memHead = hasMemHead ? &(*data.begin()) : nullptr;
+    const auto* runHead = !runHeap.empty() && inRange(headOf(runHeap.front())) ? &headOf(runHeap.front()) : nullptr;
+
+    const auto* smallest = runHead == nullptr || (memHead != nullptr && isLess(*memHead, *runHead)) ? memHead : runHead;
+    if (smallest == nullptr) break;
+
+    const auto isSame = [&smallest](const Variant& var) { return var == *smallest; };
+
+    // same variant can be in several runs and in memory. Like `AddVariants`, the variant with higher
+    // coverage is kept, and the variant added first is kept on ties, so runs are popped oldest first
+    // and memory, which has the newest variants, is checked last
+    sameRuns.clear();
+    while (!runHeap.empty() && isSame(headOf(runHeap.front()))) {
+      std::pop_heap(runHeap.begin(), runHeap.end(), runGreater);
+      sameRuns.push_back(runHeap.back());
+      runHeap.pop_back();
+    }
+
+    const Variant* best = nullptr;
+    for (const auto runIdx : sameRuns) {
+      if (best == nullptr || TotalCov(*best) < TotalCov(headOf(runIdx))) best = &headOf(runIdx);
+    }
 
-  if (!variantsToFlush.empty() && data.load_factor() < 0.8) {
-    // swap data with temp to force releasing hash table memory
-    absl::flat_hash_map<VariantID, Variant> temp(data);
-    data.swap(temp);
+    const auto inMemory = memHead != nullptr && isSame(*memHead);
+    if (inMemory && (best == nullptr || TotalCov(*best) < TotalCov(*memHead))) best = memHead;
+
+    emit(*best);
+    mergedAny = true;
+
+    // `smallest` and `best` may point to run heads, so they are not used once runs are advanced
+    for (const auto runIdx : sameRuns) {
+      spillRuns[runIdx]->Advance();
+      if (!spillRuns[runIdx]->Head().has_value()) continue;
+      runHeap.push_back(runIdx);
+      std::push_heap(runHeap.begin(), runHeap.end(), runGreater);
+    }
+
+    if (inMemory) {
+      memBytes -= ApproxBytes(*memHead);
+      data.erase(data.begin());
+    }
   }
 
-  return !variantsToFlush.empty();
+  // runs are removed from disk as soon as all of their variants are merged
+  spillRuns.erase(std::remove_if(spillRuns.begin(), spillRuns.end(),
+                                 [](const std::unique_ptr<SpillRun>& run) { return !run->Head().has_value(); }),
+                  spillRuns.end());
+  return mergedAny;
 }
 
-auto VariantStore::IsVariant1LessThan2(const Variant& v1, const Variant& v2,
-                                       const absl::flat_hash_map<std::string, std::int64_t>& ctg_ids) -> bool {
-  if (v1.ChromName != v2.ChromName) return ctg_ids.at(v1.ChromName) < ctg_ids.at(v2.ChromName);
-  if (v1.Position != v2.Position) return v1.Position < v2.Position;
-  if (v1.RefAllele != v2.RefAllele) return v1.RefAllele < v2.RefAllele;
-  return v1.AltAllele < v2.AltAllele;
+void VariantStore::SpillToDisk() {
+  // every run keeps its file open until it is drained, so runs are compacted before adding one more
+  if (spillRuns.size() >= MAX_SPILL_RUNS) CompactSpillRuns();
+
+  const auto runPath = SpillRunPath(numSpilled++);
+  LOG_DEBUG("Spilling {} variants ({} MB) from variant store to {}", data.size(), memBytes / BYTES_PER_MB,
+            runPath.string());
+
+  spillRuns.emplace_back(std::make_unique<SpillRun>(runPath, spillHeader, [this](EvidenceWriter& writer) {
+    for (const auto& var : data) writer.Write(var);
+  }));
+
+  data.clear();
+  memBytes = 0;
 }
 
-auto VariantStore::IsVariantInOrBefore(const Variant& v, const RefWindow& w, const ContigIDs& ctg_ids) -> bool {
-  if (v.ChromName != w.Chromosome()) return ctg_ids.at(v.ChromName) < ctg_ids.at(w.Chromosome());
-  return v.Position <= (w.EndPosition0() + 1);
+void VariantStore::CompactSpillRuns() {
+  const auto runPath = SpillRunPath(numSpilled++);
+  LOG_DEBUG("Compacting {} spilled runs of variant store into {}", spillRuns.size(), runPath.string());
+
+  // merging all runs drains them, so they are removed from `spillRuns` and disk once the compacted run is written
+  auto compacted = std::make_unique<SpillRun>(runPath, spillHeader, [this](EvidenceWriter& writer) {
+    MergeUpto(nullptr, false, [&writer](const Variant& var) { writer.Write(var); });
+  });
+
+  LANCET_ASSERT(spillRuns.empty());  // NOLINT
+  spillRuns.emplace_back(std::move(compacted));
 }
 
-void VariantStore::UnsafeAddVariantBatch(absl::Span<const Variant> variants) {
-  for (const auto& variant : variants) {
-    const auto vID = variant.ID();
-    auto itr = data.find(vID);
+auto VariantStore::ApproxBytes(const Variant& var) -> std::size_t {
+  return sizeof(Variant) + var.ChromName.capacity() + var.RefAllele.capacity() + var.AltAllele.capacity() +
+         var.STRResult.capacity() + var.Record.capacity();
+}
+
+auto VariantStore::FindDuplicate(const Variant& var) const -> Container::const_iterator {
+  // only a few variants share a position, so they are scanned and told apart by allele hash before alleles
+  const GenomePos pos{var.ContigIdx, var.Position};
+  const auto atPos = [&var](const Variant& other) {
+    return other.ContigIdx == var.ContigIdx && other.Position == var.Position;
+  };
+
+  for (auto itr = data.lower_bound(pos); itr != data.end() && atPos(*itr); ++itr) {
+    if (*itr == var) return itr;
+  }
+  return data.end();
+}
+
+auto VariantStore::TotalCov(const Variant& var) -> int { return var.TumorCov.TotalCov() + var.NormalCov.TotalCov(); }
+
+void VariantStore::AddVariants(absl::Span<Variant> variants) {
+  for (auto& variant : variants) {
+    // windows after the resumed window can only produce already flushed variants on the same chromosome
+    const auto alreadyFlushed = variant.ChromName == flushedChrom &&
+                                static_cast<std::int64_t>(variant.Position) <= (flushedEnd0 + 1);
+    if (alreadyFlushed) continue;
+
+    variant.ContigIdx = contigIDs.at(variant.ChromName);
+    auto itr = FindDuplicate(variant);
     if (itr == data.end()) {
-      data.emplace(vID, variant);
+      memBytes += ApproxBytes(variant);
+      data.insert(std::move(variant));
       continue;
     }
 
-    const auto oldTotalCov = itr->second.TumorCov.TotalCov() + itr->second.NormalCov.TotalCov();
-    const auto newTotalCov = variant.TumorCov.TotalCov() + variant.NormalCov.TotalCov();
-    if (oldTotalCov < newTotalCov) {
-      itr->second.KmerSize = variant.KmerSize;
-      itr->second.TumorCov = variant.TumorCov;
-      itr->second.NormalCov = variant.NormalCov;
+    // whole variant is replaced, so that its pre-rendered record stays consistent with the kept coverage
+    if (TotalCov(*itr) < TotalCov(variant)) {
+      memBytes += ApproxBytes(variant);
+      memBytes -= ApproxBytes(*itr);
+      data.insert(data.erase(itr), std::move(variant));
     }
   }
+
+  if (maxMemBytes > 0 && memBytes > maxMemBytes) SpillToDisk();
 }
 }  // namespace lancet
@@ -0,0 +1,388 @@
+#include "lancet/vcf_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "lancet/hts_reader.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#pragma clang diagnostic ignored "-Wcast-qual"
+#elif defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+
+#include "htslib/bgzf.h"
+#include "htslib/hts.h"
+#include "htslib/kstring.h"
+#include "htslib/vcf.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace lancet {
+// Max. contig length that can be indexed with a tabix index, longer contigs need a CSI index
+static constexpr std::int64_t MAX_TBI_CONTIG_LENGTH = (std::int64_t(1) << 29) - 1;
+static constexpr int CSI_MIN_SHIFT = 14;
+static constexpr std::size_t NUM_SAMPLES = 2;
+static constexpr std::size_t NUM_HAPLOTYPES = 3;
+
+struct HtsfileDeleter {
+  void operator()(htsFile* sf) noexcept {
+    if (sf != nullptr) hts_close(sf);
+  }
+};
+
+struct BcfHdrDeleter {
+  void operator()(bcf_hdr_t* hdr) noexcept {
+    if (hdr != nullptr) bcf_hdr_destroy(hdr);
+  }
+};
+
+struct Bcf1Deleter {
+  void operator()(bcf1_t* rec) noexcept {
+    if (rec != nullptr) bcf_destroy(rec);
+  }
+};
+
+static inline auto MaxContigLength(const std::string& header) -> std::int64_t {
+  std::int64_t result = 0;
+  for (const auto line : absl::StrSplit(header, '\n')) {
+    if (!absl::StartsWith(line, "##contig=<")) continue;
+
+    const auto lenPos = line.find("length=");
+    if (lenPos == std::string_view::npos) continue;
+    const auto lenStart = lenPos + 7;
+    const auto lenEnd = line.find_first_of(",>", lenStart);
+
+    std::int64_t ctgLen = 0;
+    if (absl::SimpleAtoi(line.substr(lenStart, lenEnd - lenStart), &ctgLen)) result = std::max(result, ctgLen);
+  }
+
+  return result;
+}
+
+static inline void CheckEncoded(int status, const char* field) {
+  if (status < 0) throw std::runtime_error(absl::StrFormat("could not encode %s in BCF record", field));
+}
+
+// Same genotype calls as the VCF text output, encoded as unphased BCF genotype alleles
+static inline void EncodeGenotype(int ref, int alt, std::int32_t* gt) {
+  const auto setAlleles = [gt](std::int32_t first, std::int32_t second) {
+    gt[0] = first;   // NOLINT
+    gt[1] = second;  // NOLINT
+  };
+
+  if (ref > 0 && alt == 0) return setAlleles(bcf_gt_unphased(0), bcf_gt_unphased(0));
+  if (ref > 0 && alt > 0) return setAlleles(bcf_gt_unphased(0), bcf_gt_unphased(1));
+  if (ref == 0 && alt > 0) return setAlleles(bcf_gt_unphased(1), bcf_gt_unphased(1));
+  return setAlleles(bcf_gt_missing, bcf_gt_missing);
+}
+
+class VcfWriter::Impl {
+ public:
+  Impl(const std::filesystem::path& out_path, std::uint64_t resume_offset, bool as_bcf)
+      : outPath(out_path), isCompressed(as_bcf || IsCompressedPath(out_path)), isBcf(as_bcf) {
+    if (isCompressed) {
+      OpenCompressed();
+    } else {
+      OpenPlain(resume_offset);
+    }
+  }
+
+  ~Impl() { free(lineBuffer.s); }  // NOLINT
+
+  Impl() = delete;
+  Impl(Impl&&) = delete;
+  auto operator=(Impl&&) -> Impl& = delete;
+  Impl(const Impl&) = delete;
+  auto operator=(const Impl&) -> Impl& = delete;
+
+  void WriteHeader(const std::string& header) {
+    if (!isCompressed) {
+      plainOut.write(header.c_str(), static_cast<std::streamsize>(header.length()));
+      plainOut.flush();
+      return;
+    }
+
+    hdr.reset(bcf_hdr_init("w"));
+    std::vector<char> headerText(header.cbegin(), header.cend());
+    headerText.push_back('\0');
+    if (hdr == nullptr || bcf_hdr_parse(hdr.get(), headerText.data()) != 0 || bcf_hdr_write(fp.get(), hdr.get()) != 0) {
+      throw std::runtime_error(absl::StrFormat("could not write header to output VCF %s", outPath.string()));
+    }
+
+    // index is built on the fly as records are written. BCF and contigs longer than tabix limit need a CSI index
+    const auto needsCsi = isBcf || MaxContigLength(header) > MAX_TBI_CONTIG_LENGTH;
+    const auto idxPath = outPath.string() + (needsCsi ? ".csi" : ".tbi");
+    if (bcf_idx_init(fp.get(), hdr.get(), needsCsi ? CSI_MIN_SHIFT : 0, idxPath.c_str()) != 0) {
+      throw std::runtime_error(absl::StrFormat("could not initialize index %s for output VCF", idxPath));
+    }
+
+    idxOutPath = idxPath;
+  }
+
+  void WriteRecord(std::string_view record) {
+    if (!isCompressed) {
+      plainOut.write(record.data(), static_cast<std::streamsize>(record.length()));
+      return;
+    }
+
+    if (!record.empty() && record.back() == '\n') record.remove_suffix(1);
+    lineBuffer.l = 0;
+    kputsn(record.data(), record.length(), &lineBuffer);
+    if (vcf_parse(&lineBuffer, hdr.get(), rec.get()) != 0 || bcf_write(fp.get(), hdr.get(), rec.get()) != 0) {
+      throw std::runtime_error(absl::StrFormat("could not write record to output VCF %s", outPath.string()));
+    }
+  }
+
+  void WriteVariant(const Variant& var, const CliParams& params, bool use_record) {
+    if (!isBcf && use_record && !var.Record.empty()) {
+      WriteRendered(var, var.Record);
+      return;
+    }
+
+    if (!isBcf) {
+      // buffer keeps its capacity across records, so formatting does not allocate once it has grown
+      recordBuffer.clear();
+      var.AppendVcfLine(params, &recordBuffer);
+      WriteRendered(var, recordBuffer);
+      return;
+    }
+
+    EncodeVariant(var, params);
+    if (bcf_write(fp.get(), hdr.get(), rec.get()) != 0) {
+      throw std::runtime_error(absl::StrFormat("could not write record to output BCF %s", outPath.string()));
+    }
+  }
+
+  void Flush() {
+    if (!isCompressed) plainOut.flush();
+  }
+
+  [[nodiscard]] auto Offset() -> std::uint64_t {
+    return isCompressed ? 0 : static_cast<std::uint64_t>(plainOut.tellp());
+  }
+
+  void Close() {
+    if (!isCompressed) {
+      if (plainOut.is_open()) plainOut.close();
+      return;
+    }
+
+    if (fp == nullptr) return;
+    const auto savedIdx = idxOutPath.empty() || bcf_idx_save(fp.get()) == 0;
+    const auto closed = hts_close(fp.release()) == 0;
+
+    if (!savedIdx) throw std::runtime_error(absl::StrFormat("could not save index %s", idxOutPath));
+    if (!closed) throw std::runtime_error(absl::StrFormat("could not close output VCF %s", outPath.string()));
+  }
+
+  [[nodiscard]] auto IsCompressed() const -> bool { return isCompressed; }
+
+ private:
+  std::filesystem::path outPath;
+  bool isCompressed = false;
+  bool isBcf = false;
+  std::ofstream plainOut;
+
+  std::unique_ptr<htsFile, HtsfileDeleter> fp;
+  std::unique_ptr<bcf_hdr_t, BcfHdrDeleter> hdr;
+  std::unique_ptr<bcf1_t, Bcf1Deleter> rec{bcf_init()};
+  kstring_t lineBuffer{0, 0, nullptr};
+  std::string idxOutPath;
+  std::string recordBuffer;
+  std::vector<int> filterIds;
+
+  // Records rendered from a `Variant` are written straight to the BGZF stream and indexed with the coordinates
+  // of the variant. Only records from `WriteRecord`, which can be arbitrary text, are parsed into a bcf1_t
+  void WriteRendered(const Variant& var, std::string_view record) {
+    if (!isCompressed) {
+      plainOut.write(record.data(), static_cast<std::streamsize>(record.length()));
+      return;
+    }
+
+    // same as htslib's VCF writer, records are kept within one BGZF block when they fit
+    auto* bgzfp = hts_get_bgzfp(fp.get());
+    const auto numBytes = static_cast<ssize_t>(record.length());
+    if (bgzf_flush_try(bgzfp, numBytes) < 0 || bgzf_write(bgzfp, record.data(), record.length()) != numBytes) {
+      throw std::runtime_error(absl::StrFormat("could not write record to output VCF %s", outPath.string()));
+    }
+
+    const auto beg = static_cast<hts_pos_t>(var.Position) - 1;
+    const auto end = beg + static_cast<hts_pos_t>(var.RefAllele.length());
+    const auto tid = hts_idx_tbi_name(fp->idx, HeaderContigID(var), var.ChromName.c_str());
+    if (tid < 0 || hts_idx_push(fp->idx, tid, beg, end, static_cast<std::uint64_t>(bgzf_tell(bgzfp)), 1) < 0) {
+      throw std::runtime_error(absl::StrFormat("could not index record at %s:%d in output VCF %s", var.ChromName,
+                                               var.Position, outPath.string()));
+    }
+  }
+
+  // Header contigs are in reference order, so the contig index of variants from the store is the header ID
+  [[nodiscard]] auto HeaderContigID(const Variant& var) const -> int {
+    const auto* hdrPtr = hdr.get();
+    const auto numContigs = static_cast<std::int64_t>(hdrPtr->n[BCF_DT_CTG]);
+    if (var.ContigIdx >= 0 && var.ContigIdx < numContigs &&
+        var.ChromName == bcf_hdr_id2name(hdrPtr, static_cast<int>(var.ContigIdx))) {
+      return static_cast<int>(var.ContigIdx);
+    }
+
+    const auto rid = bcf_hdr_name2id(hdrPtr, var.ChromName.c_str());
+    if (rid < 0) throw std::runtime_error(absl::StrFormat("contig %s missing in VCF header", var.ChromName));
+    return rid;
+  }
+
+  void OpenPlain(std::uint64_t resume_offset) {
+    if (resume_offset == 0) {
+      plainOut.open(outPath, std::ios_base::out | std::ios_base::trunc);
+    } else {
+      // drop any partial output written after the last checkpoint
+      std::filesystem::resize_file(outPath, resume_offset);
+      plainOut.open(outPath, std::ios_base::in | std::ios_base::out);
+      plainOut.seekp(0, std::ios_base::end);
+    }
+
+    if (!plainOut.is_open()) {
+      throw std::runtime_error(absl::StrFormat("could not open output VCF %s", outPath.string()));
+    }
+  }
+
+  void OpenCompressed() {
+    fp.reset(hts_open(outPath.c_str(), isBcf ? "wb" : "wz"));
+    if (fp == nullptr) {
+      throw std::runtime_error(absl::StrFormat("could not open output VCF %s", outPath.string()));
+    }
+
+    if (!AttachSharedHtsThreadPool(fp.get())) {
+      const auto errMsg = absl::StrFormat("could not attach shared thread pool to output VCF %s", outPath.string());
+      throw std::runtime_error(errMsg);
+    }
+  }
+
+  // Encodes the same fields as `Variant::MakeVcfLine` using the header definitions from `VariantStore::GetHeader`
+  void EncodeVariant(const Variant& var, const CliParams& params) {
+    const auto ann = var.Annotate(params);
+    auto* hdrPtr = hdr.get();
+    auto* recPtr = rec.get();
+
+    bcf_clear(recPtr);
+    recPtr->rid = bcf_hdr_name2id(hdrPtr, var.ChromName.c_str());
+    recPtr->pos = static_cast<hts_pos_t>(var.Position) - 1;
+    recPtr->qual = static_cast<float>(ann.somaticScore);
+    if (recPtr->rid < 0) throw std::runtime_error(absl::StrFormat("contig %s missing in BCF header", var.ChromName));
+
+    const auto alleles = absl::StrFormat("%s,%s", var.RefAllele, var.AltAllele);
+    CheckEncoded(bcf_update_alleles_str(hdrPtr, recPtr, alleles.c_str()), "alleles");
+
+    filterIds.clear();
+    if (ann.filters.none()) filterIds.push_back(bcf_hdr_id2int(hdrPtr, BCF_DT_ID, "PASS"));
+    for (std::size_t idx = 0; idx < NUM_VCF_FILTERS; ++idx) {
+      if (ann.filters.test(idx)) filterIds.push_back(bcf_hdr_id2int(hdrPtr, BCF_DT_ID, VCF_FILTER_NAMES[idx]));
+    }
+    CheckEncoded(bcf_update_filter(hdrPtr, recPtr, filterIds.data(), static_cast<int>(filterIds.size())), "FILTER");
+
+    const auto stateTag = ToString(ann.state);
+    const auto typeTag = ToString(var.Kind);
+    const auto length = static_cast<std::int32_t>(var.Length);
+    const auto kmerSize = static_cast<std::int32_t>(var.KmerSize);
+    const auto fets = static_cast<float>(ann.somaticScore);
+    const auto sb = static_cast<float>(ann.strandBiasScore);
+
+    CheckEncoded(bcf_update_info_flag(hdrPtr, recPtr, stateTag.c_str(), nullptr, 1), "INFO state");
+    CheckEncoded(bcf_update_info_float(hdrPtr, recPtr, "FETS", &fets, 1), "FETS");
+    CheckEncoded(bcf_update_info_string(hdrPtr, recPtr, "TYPE", typeTag.c_str()), "TYPE");
+    CheckEncoded(bcf_update_info_int32(hdrPtr, recPtr, "LEN", &length, 1), "LEN");
+    CheckEncoded(bcf_update_info_int32(hdrPtr, recPtr, "KMERSIZE", &kmerSize, 1), "KMERSIZE");
+    CheckEncoded(bcf_update_info_float(hdrPtr, recPtr, "SB", &sb, 1), "SB");
+    if (!var.STRResult.empty()) {
+      CheckEncoded(bcf_update_info_string(hdrPtr, recPtr, "MS", var.STRResult.c_str()), "MS");
+    }
+
+    if (params.tenxMode) {
+      const auto hps = static_cast<float>(ann.pairHpScore);
+      const auto hpsn = static_cast<float>(ann.nmlHpScore);
+      const auto hpst = static_cast<float>(ann.tmrHpScore);
+      CheckEncoded(bcf_update_info_float(hdrPtr, recPtr, "HPS", &hps, 1), "HPS");
+      CheckEncoded(bcf_update_info_float(hdrPtr, recPtr, "HPSN", &hpsn, 1), "HPSN");
+      CheckEncoded(bcf_update_info_float(hdrPtr, recPtr, "HPST", &hpst, 1), "HPST");
+    }
+
+    // samples are in header order, normal followed by tumor
+    const std::array<const VariantHpCov*, NUM_SAMPLES> covs{&var.NormalCov, &var.TumorCov};
+    std::array<std::int32_t, NUM_SAMPLES * 2> gt{};
+    std::array<std::int32_t, NUM_SAMPLES * 2> ad{};
+    std::array<std::int32_t, NUM_SAMPLES * 2> sr{};
+    std::array<std::int32_t, NUM_SAMPLES * 2> sa{};
+    std::array<std::int32_t, NUM_SAMPLES> dp{};
+    std::array<std::int32_t, NUM_SAMPLES * NUM_HAPLOTYPES> hpr{};
+    std::array<std::int32_t, NUM_SAMPLES * NUM_HAPLOTYPES> hpa{};
+
+    for (std::size_t idx = 0; idx < NUM_SAMPLES; ++idx) {
+      const auto& cov = *covs[idx];
+      EncodeGenotype(cov.TotalRefCov(), cov.TotalAltCov(), &gt[idx * 2]);
+      ad[idx * 2] = cov.TotalRefCov();
+      ad[idx * 2 + 1] = cov.TotalAltCov();
+      sr[idx * 2] = cov.refAl.fwdCov;
+      sr[idx * 2 + 1] = cov.refAl.revCov;
+      sa[idx * 2] = cov.altAl.fwdCov;
+      sa[idx * 2 + 1] = cov.altAl.revCov;
+      dp[idx] = cov.TotalCov();
+
+      const auto hpOffset = idx * NUM_HAPLOTYPES;
+      hpr[hpOffset] = cov.RefHP(Haplotype::FIRST);
+      hpr[hpOffset + 1] = cov.RefHP(Haplotype::SECOND);
+      hpr[hpOffset + 2] = cov.RefHP(Haplotype::UNASSIGNED);
+      hpa[hpOffset] = cov.AltHP(Haplotype::FIRST);
+      hpa[hpOffset + 1] = cov.AltHP(Haplotype::SECOND);
+      hpa[hpOffset + 2] = cov.AltHP(Haplotype::UNASSIGNED);
+    }
+
+    CheckEncoded(bcf_update_genotypes(hdrPtr, recPtr, gt.data(), static_cast<int>(gt.size())), "GT");
+    CheckEncoded(bcf_update_format_int32(hdrPtr, recPtr, "AD", ad.data(), static_cast<int>(ad.size())), "AD");
+    CheckEncoded(bcf_update_format_int32(hdrPtr, recPtr, "SR", sr.data(), static_cast<int>(sr.size())), "SR");
+    CheckEncoded(bcf_update_format_int32(hdrPtr, recPtr, "SA", sa.data(), static_cast<int>(sa.size())), "SA");
+    CheckEncoded(bcf_update_format_int32(hdrPtr, recPtr, "DP", dp.data(), static_cast<int>(dp.size())), "DP");
+    if (params.tenxMode) {
+      CheckEncoded(bcf_update_format_int32(hdrPtr, recPtr, "HPR", hpr.data(), static_cast<int>(hpr.size())), "HPR");
+      CheckEncoded(bcf_update_format_int32(hdrPtr, recPtr, "HPA", hpa.data(), static_cast<int>(hpa.size())), "HPA");
+    }
+  }
+};
+
+VcfWriter::VcfWriter(const std::filesystem::path& out_path, std::uint64_t resume_offset, bool as_bcf)
+    : pimpl(std::make_unique<Impl>(out_path, resume_offset, as_bcf)) {}
+
+VcfWriter::~VcfWriter() = default;
+VcfWriter::VcfWriter(VcfWriter&&) noexcept = default;
+auto VcfWriter::operator=(VcfWriter&&) noexcept -> VcfWriter& = default;
+
+void VcfWriter::WriteHeader(const std::string& header) { return pimpl->WriteHeader(header); }
+void VcfWriter::WriteRecord(std::string_view record) { return pimpl->WriteRecord(record); }
+void VcfWriter::WriteVariant(const Variant& var, const CliParams& params) {
+  return pimpl->WriteVariant(var, params, true);
+}
+
+void VcfWriter::WriteVariantWith(const Variant& var, const CliParams& params) {
+  return pimpl->WriteVariant(var, params, false);
+}
+void VcfWriter::Flush() { return pimpl->Flush(); }
+auto VcfWriter::Offset() -> std::uint64_t { return pimpl->Offset(); }
+void VcfWriter::Close() { return pimpl->Close(); }
+auto VcfWriter::IsCompressed() const -> bool { return pimpl->IsCompressed(); }
+
+auto VcfWriter::IsCompressedPath(const std::filesystem::path& out_path) -> bool {
+  return absl::EndsWith(out_path.string(), ".gz");
+}
+}  // namespace lancet
@@ -12,6 +12,68 @@
 #include "spdlog/spdlog.h"
 
 namespace lancet {
+WindowGenerator::WindowGenerator(std::vector<RefWindow> sorted_regions, std::uint32_t window_length,
+                                 std::int64_t step_size)
+    : regions(std::move(sorted_regions)), windowLength(window_length), stepSize(step_size) {
+  for (const auto &region : regions) numTotalWindows += NumWindowsInRegion(region);
+  endWindowIdx = numTotalWindows;
+}
+
+auto WindowGenerator::Next() -> WindowPtr {
+  while (currRegionIdx < regions.size() && nextWindowIdx < endWindowIdx) {
+    const auto &region = regions[currRegionIdx];
+
+    if (region.Length() <= windowLength) {
+      auto result = std::make_shared<RefWindow>(region);
+      result->SetWindowIndex(nextWindowIdx++);
+      currRegionIdx++;
+      return result;
+    }
+
+    if (currWindowStart < 0) currWindowStart = region.StartPosition0();
+    if (currWindowStart < region.EndPosition0()) {
+      auto result = std::make_shared<RefWindow>();
+      result->SetWindowIndex(nextWindowIdx++);
+      result->SetChromosome(region.Chromosome());
+      result->SetStartPosition0(currWindowStart);
+      result->SetEndPosition0(currWindowStart + windowLength);
+      currWindowStart += stepSize;
+      return result;
+    }
+
+    currRegionIdx++;
+    currWindowStart = -1;
+  }
+
+  return nullptr;
+}
+
+void WindowGenerator::SkipWindows(std::size_t count) {
+  const auto targetIdx = nextWindowIdx + count;
+  while (nextWindowIdx < targetIdx && currRegionIdx < regions.size()) {
+    const auto &region = regions[currRegionIdx];
+    const auto numTotal = NumWindowsInRegion(region);
+    const auto numDone =
+        currWindowStart < 0 ? 0 : static_cast<std::size_t>((currWindowStart - region.StartPosition0()) / stepSize);
+    const auto numToSkip = std::min(numTotal - numDone, targetIdx - nextWindowIdx);
+
+    nextWindowIdx += numToSkip;
+    if (numDone + numToSkip == numTotal) {
+      currRegionIdx++;
+      currWindowStart = -1;
+      continue;
+    }
+
+    currWindowStart = region.StartPosition0() + static_cast<std::int64_t>(numDone + numToSkip) * stepSize;
+  }
+}
+
+auto WindowGenerator::NumWindowsInRegion(const RefWindow &region) const -> std::size_t {
+  if (region.Length() <= windowLength) return 1;
+  const auto regionLen = region.EndPosition0() - region.StartPosition0();
+  return static_cast<std::size_t>((regionLen + stepSize - 1) / stepSize);
+}
+
 WindowBuilder::WindowBuilder(const std::filesystem::path &ref, std::uint32_t region_padding,
                              std::uint32_t window_length, std::uint32_t pct_window_overlap)
     : refRdr(ref), regionPadding(region_padding), windowLength(window_length), pctWindowOverlap(pct_window_overlap) {}
@@ -42,12 +104,12 @@ void WindowBuilder::AddAllRefRegions() {
   }
 }
 
-auto WindowBuilder::BuildWindows(const absl::flat_hash_map<std::string, std::int64_t> &contig_ids) const
-    -> absl::StatusOr<std::vector<WindowPtr>> {
+auto WindowBuilder::BuildGenerator(const absl::flat_hash_map<std::string, std::int64_t> &contig_ids) const
+    -> absl::StatusOr<std::unique_ptr<WindowGenerator>> {
   if (IsEmpty()) return absl::FailedPreconditionError("no input regions provided to build windows");
 
-  std::vector<WindowPtr> results;
-  const auto stepSize = StepSize(pctWindowOverlap, windowLength);
+  std::vector<RefWindow> paddedRegions;
+  paddedRegions.reserve(inputRegions.size());
 
   for (const auto &rawReg : inputRegions) {
     if (!contig_ids.contains(rawReg.Chromosome())) {
@@ -56,42 +118,30 @@ auto WindowBuilder::BuildWindows(const absl::flat_hash_map<std::string, std::int
 
     const auto paddedResult = PadWindow(rawReg);
     if (!paddedResult.ok()) return paddedResult.status();
-    const auto &finalRegion = paddedResult.value();
-
-    if (finalRegion.Length() <= windowLength) {
-      results.emplace_back(std::make_shared<RefWindow>(finalRegion));
-      continue;
-    }
-
-    std::int64_t currWindowStart = finalRegion.StartPosition0();
-    const auto maxWindowPos = finalRegion.EndPosition0();
-
-    while (currWindowStart < maxWindowPos) {
-      const std::int64_t currWindowEnd = currWindowStart + windowLength;
-      results.emplace_back(std::make_shared<RefWindow>());
-      results.back()->SetChromosome(finalRegion.Chromosome());
-      results.back()->SetStartPosition0(currWindowStart);
-      results.back()->SetEndPosition0(currWindowEnd);
-      currWindowStart += stepSize;
-    }
+    paddedRegions.emplace_back(paddedResult.value());
   }
 
-  static const auto Comparator = [&contig_ids](const RefWindow &r1, const RefWindow &r2) -> bool {
+  std::sort(paddedRegions.begin(), paddedRegions.end(), [&contig_ids](const RefWindow &r1, const RefWindow &r2) {
     if (r1.Chromosome() != r2.Chromosome()) return contig_ids.at(r1.Chromosome()) < contig_ids.at(r2.Chromosome());
     if (r1.StartPosition0() != r2.StartPosition0()) return r1.StartPosition0() < r2.StartPosition0();
     return r1.EndPosition0() < r2.EndPosition0();
-  };
+  });
 
-  std::sort(results.begin(), results.end(),
-            [](const WindowPtr &r1, const WindowPtr &r2) -> bool { return Comparator(*r1, *r2); });
+  // merge overlapping regions, so that windows are generated in genome order without duplicates
+  std::vector<RefWindow> mergedRegions;
+  for (auto &region : paddedRegions) {
+    if (!mergedRegions.empty() && mergedRegions.back().Chromosome() == region.Chromosome() &&
+        region.StartPosition0() <= mergedRegions.back().EndPosition0()) {
+      const auto mergedEnd = std::max(mergedRegions.back().EndPosition0(), region.EndPosition0());
+      mergedRegions.back().SetEndPosition0(mergedEnd);
+      continue;
+    }
 
-  std::for_each(results.begin(), results.end(), [](WindowPtr &w) -> void {
-    static std::size_t currWindowIdx = 0;
-    w->SetWindowIndex(currWindowIdx);
-    currWindowIdx++;
-  });
+    mergedRegions.emplace_back(std::move(region));
+  }
 
-  return std::move(results);
+  const auto stepSize = StepSize(pctWindowOverlap, windowLength);
+  return std::make_unique<WindowGenerator>(std::move(mergedRegions), windowLength, stepSize);
 }
 
 auto WindowBuilder::StepSize(std::uint32_t pct_overlap, std::uint32_t window_length) -> std::int64_t {
@@ -181,8 +231,8 @@ auto WindowBuilder::PadWindow(const RefWindow &w) const -> absl::StatusOr<RefWin
   return std::move(result);
 }
 
-auto BuildWindows(const absl::flat_hash_map<std::string, std::int64_t> &contig_ids, const CliParams &params)
-    -> std::vector<WindowPtr> {
+auto BuildWindowGenerator(const absl::flat_hash_map<std::string, std::int64_t> &contig_ids, const CliParams &params)
+    -> std::unique_ptr<WindowGenerator> {
   WindowBuilder wb(params.referencePath, params.regionPadLength, params.windowLength, params.pctOverlap);
   for (const auto &region : params.inRegions) {
     const auto result = wb.AddSamtoolsRegion(region);
@@ -206,12 +256,12 @@ auto BuildWindows(const absl::flat_hash_map<std::string, std::int64_t> &contig_i
   }
 
   LOG_INFO("Building windows using {} input regions", wb.Size());
-  const auto windows = wb.BuildWindows(contig_ids);
-  if (!windows.ok()) {
-    LOG_ERROR(windows.status().message());
+  auto generator = wb.BuildGenerator(contig_ids);
+  if (!generator.ok()) {
+    LOG_ERROR(generator.status().message());
     std::exit(EXIT_FAILURE);
   }
 
-  return windows.value();
+  return std::move(generator).value();
 }
 }  // namespace lancet
@@ -0,0 +1,187 @@
+#include "lancet/window_prefetcher.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/str_format.h"
+#include "lancet/log_macros.h"
+#include "lancet/timer.h"
+#include "lancet/utils.h"
+#include "spdlog/spdlog.h"
+
+namespace lancet {
+static inline auto ShouldSkipWindow(const RefWindow& w, const CliParams& params) -> bool {
+  const auto refseq = w.SeqView();
+  const auto regionStr = w.ToRegionString();
+
+  if (static_cast<std::size_t>(std::count(refseq.begin(), refseq.end(), 'N')) == refseq.length()) {
+    LOG_DEBUG("Skipping {} since it has only N bases in reference", regionStr);
+    return true;
+  }
+
+  if (utils::HasRepeatKmer(refseq, params.maxKmerSize)) {
+    LOG_DEBUG("Skipping {} since reference has repeat {}-mers", regionStr, params.maxKmerSize);
+    return true;
+  }
+
+  return false;
+}
+
+auto PrepareWindow(WindowPtr w, FastaReader* ref, ReadExtractor* re, WindowScheduler* sched,
+                   const CliParams& params) -> WindowPayload {
+  Timer T;
+  WindowPayload result;
+  result.window = std::move(w);
+  const auto& window = result.window;
+  const auto regStr = window->ToRegionString();
+
+  try {
+    // reference sequence is usually pre-fetched by the scheduler while estimating cost of the window
+    if (window->SeqView().empty()) {
+      const auto regResult = ref->RegionSequence(window->ToGenomicRegion());
+      if (!regResult.ok() && absl::IsFailedPrecondition(regResult.status())) {
+        LOG_DEBUG("Skipping window {} with truncated reference sequence in fasta", regStr);
+        result.fetchRuntime = T.Runtime();
+        return result;
+      }
+
+      if (!regResult.ok()) {
+        result.status = regResult.status();
+        result.fetchRuntime = T.Runtime();
+        return result;
+      }
+
+      window->SetSequence(regResult.value());
+    }
+
+    LOG_DEBUG("Starting to process {} in MicroAssembler", regStr);
+    if (ShouldSkipWindow(*window, params)) {
+      result.fetchRuntime = T.Runtime();
+      return result;
+    }
+
+    // windows without evidence of mutation anywhere near them in the active region index need no reads
+    const auto* activeIdx = sched->ActiveIndex();
+    if (activeIdx != nullptr && !activeIdx->MayBeActive(window->ToGenomicRegion())) {
+      result.avgCoverage = activeIdx->AverageCoverage(window->ToGenomicRegion());
+      sched->ReportCoverage(window->WindowIndex(), result.avgCoverage);
+      LOG_DEBUG("Skipping {} since active region index has no evidence of mutation near it", regStr);
+      result.fetchRuntime = T.Runtime();
+      return result;
+    }
+
+    re->SetTargetRegion(window->ToGenomicRegion());
+    result.avgCoverage = re->AverageCoverage();
+    sched->ReportCoverage(window->WindowIndex(), result.avgCoverage);
+    if (!params.activeRegionOff && !re->IsActiveRegion()) {
+      LOG_DEBUG("Skipping {} since no evidence of mutation is found", regStr);
+      result.fetchRuntime = T.Runtime();
+      return result;
+    }
+
+    result.reads = re->Extract();
+    result.shouldAssemble = true;
+  } catch (const std::exception& exception) {
+    result.status = absl::InternalError(exception.what());
+  } catch (...) {
+    result.status = absl::UnknownError("unknown exception caught");
+  }
+
+  result.fetchRuntime = T.Runtime();
+  return result;
+}
+
+WindowPrefetcher::WindowPrefetcher(std::shared_ptr<WindowScheduler> sched, std::size_t max_queued,
+                                   std::shared_ptr<const CliParams> p)
+    : schedulerPtr(std::move(sched)), maxQueued(std::max(max_queued, std::size_t(1))), params(std::move(p)) {}
+
+void WindowPrefetcher::Start(std::size_t num_threads) {
+  {
+    std::lock_guard<std::mutex> guard(queueMutex);
+    numActiveThreads += num_threads;
+  }
+
+  prefetchers.reserve(prefetchers.size() + num_threads);
+  for (std::size_t idx = 0; idx < num_threads; ++idx) {
+    prefetchers.emplace_back(std::async(std::launch::async, [this, idx]() -> void { Prefetch(idx); }));
+  }
+}
+
+auto WindowPrefetcher::Next(WindowPayload* result) -> bool {
+  std::unique_lock<std::mutex> lock(queueMutex);
+  notEmpty.wait(lock, [this]() -> bool { return !payloads.empty() || numActiveThreads == 0; });
+  if (payloads.empty()) return false;
+
+  *result = std::move(payloads.front());
+  payloads.pop_front();
+  lock.unlock();
+  notFull.notify_one();
+  return true;
+}
+
+void WindowPrefetcher::Join() {
+  std::for_each(prefetchers.begin(), prefetchers.end(), [](std::future<void>& fut) { return fut.get(); });
+  prefetchers.clear();
+}
+
+void WindowPrefetcher::Prefetch(std::size_t thread_idx) {
+  static thread_local const auto tid = std::this_thread::get_id();
+  LOG_INFO("Started WindowPrefetcher thread {:#x}", absl::Hash<std::thread::id>()(tid));
+
+  // Windows are still pulled when readers cannot be opened, so that every window reaches a worker with the
+  // error instead of never being done. Counter is decremented on every exit, so that `Next` cannot block forever
+  std::size_t numPrefetched = 0;
+  try {
+    const auto readers = OpenReaders();
+    for (auto window = schedulerPtr->Next(thread_idx); window != nullptr; window = schedulerPtr->Next(thread_idx)) {
+      if (!readers.ok()) {
+        WindowPayload failed;
+        failed.window = std::move(window);
+        failed.status = readers.status();
+        Push(std::move(failed));
+      } else {
+        Push(PrepareWindow(std::move(window), readers->first.get(), readers->second.get(), schedulerPtr.get(),
+                           *params));
+      }
+      numPrefetched++;
+    }
+  } catch (const std::exception& exception) {
+    LOG_ERROR("WindowPrefetcher thread {:#x} stopped early: {}", absl::Hash<std::thread::id>()(tid), exception.what());
+  } catch (...) {
+    LOG_ERROR("WindowPrefetcher thread {:#x} stopped early: unknown exception caught",
+              absl::Hash<std::thread::id>()(tid));
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(queueMutex);
+    numActiveThreads--;
+  }
+
+  notEmpty.notify_all();
+  LOG_INFO("Done prefetching {} windows in WindowPrefetcher thread {:#x}", numPrefetched,
+           absl::Hash<std::thread::id>()(tid));
+}
+
+auto WindowPrefetcher::OpenReaders() const -> absl::StatusOr<Readers> {
+  try {
+    return Readers(std::make_unique<FastaReader>(params->referencePath), std::make_unique<ReadExtractor>(params));
+  } catch (const std::exception& exception) {
+    return absl::InternalError(absl::StrFormat("could not open readers to prefetch windows: %s", exception.what()));
+  } catch (...) {
+    return absl::UnknownError("could not open readers to prefetch windows: unknown exception caught");
+  }
+}
+
+void WindowPrefetcher::Push(WindowPayload&& payload) {
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    notFull.wait(lock, [this]() -> bool { return payloads.size() < maxQueued; });
+    payloads.emplace_back(std::move(payload));
+  }
+
+  notEmpty.notify_one();
+}
+}  // namespace lancet
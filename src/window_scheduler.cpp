@@ -0,0 +1,257 @@
+#include "lancet/window_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "lancet/utils.h"
+
+namespace lancet {
+// Windows with many repeated k-mers need graphs to be re-built with increasing K until the repeats
+// are resolved. Weight of the repeated k-mer fraction in the estimated cost of a window.
+static constexpr double REPEAT_COST_WEIGHT = 8.0;
+
+WindowScheduler::WindowScheduler(std::unique_ptr<WindowGenerator> gen, std::size_t num_workers,
+                                 std::shared_ptr<const CliParams> p,
+                                 std::shared_ptr<const ActiveRegionIndex> active_idx)
+    : params(std::move(p)),
+      activeIndex(std::move(active_idx)),
+      windowGen(std::move(gen)),
+      maxPendingRuns(std::max(num_workers, std::size_t(1)) * DEFAULT_PENDING_RUNS_PER_WORKER),
+      workerRuns(std::max(num_workers, std::size_t(1))) {}
+
+auto WindowScheduler::Next(std::size_t worker_idx) -> WindowPtr {
+  auto& ownRun = workerRuns[worker_idx];
+
+  for (;;) {
+    {
+      std::lock_guard<utils::SpinLock> guard(ownRun.spinLock);
+      if (!ownRun.windows.empty()) {
+        auto result = std::move(ownRun.windows.front());
+        ownRun.windows.pop_front();
+        return result;
+      }
+    }
+
+    auto claimed = ClaimCostliestRun(worker_idx);
+    if (!claimed.empty()) {
+      std::lock_guard<utils::SpinLock> guard(ownRun.spinLock);
+      auto result = std::move(claimed.front());
+      claimed.pop_front();
+      ownRun.windows = std::move(claimed);
+      return result;
+    }
+
+    auto stolen = StealWindow(worker_idx);
+    if (stolen != nullptr) return stolen;
+
+    // runs being costed by other workers are not pending yet, so wait for them before giving up
+    std::unique_lock<std::mutex> lock(poolMutex);
+    if (pendingRuns.empty() && numRunsCosting == 0 && isGenExhausted) return nullptr;
+    runsReady.wait(lock, [this]() -> bool { return numRunsCosting == 0 || !pendingRuns.empty(); });
+  }
+}
+
+void WindowScheduler::ReportCoverage(std::size_t win_idx, double avg_cov) {
+  std::lock_guard<std::mutex> guard(poolMutex);
+  coverageStats.Add(avg_cov);
+  RecordNeighbourStat(win_idx, avg_cov, false);
+}
+
+void WindowScheduler::ReportRuntime(std::size_t win_idx, absl::Duration runtime) {
+  const auto secs = absl::ToDoubleSeconds(runtime);
+  std::lock_guard<std::mutex> guard(poolMutex);
+  runtimeStats.Add(secs);
+  RecordNeighbourStat(win_idx, secs, true);
+}
+
+auto WindowScheduler::ReferenceCostFactor(std::string_view seq, std::size_t k) -> double {
+  const auto numNs = static_cast<std::size_t>(std::count(seq.begin(), seq.end(), 'N'));
+  if (seq.length() < k || numNs == seq.length()) return 0.0;
+
+  absl::flat_hash_set<std::string_view> mers;
+  const auto endOffset = seq.length() - k + 1;
+  mers.reserve(endOffset);
+
+  std::size_t numRepeats = 0;
+  for (std::size_t offset = 0; offset < endOffset; ++offset) {
+    if (!mers.emplace(absl::ClippedSubstr(seq, offset, k)).second) numRepeats++;
+  }
+
+  const auto pctNonN = 1.0 - (static_cast<double>(numNs) / static_cast<double>(seq.length()));
+  const auto repeatFraction = static_cast<double>(numRepeats) / static_cast<double>(endOffset);
+  return pctNonN * (1.0 + REPEAT_COST_WEIGHT * repeatFraction);
+}
+
+auto WindowScheduler::ClaimCostliestRun(std::size_t worker_idx) -> std::deque<WindowPtr> {
+  // reader is opened before pulling runs, so that a failure to open it cannot leave runs stuck in costing
+  auto& ownRefRdr = workerRuns[worker_idx].refRdr;
+  if (ownRefRdr == nullptr) ownRefRdr = std::make_unique<FastaReader>(params->referencePath);
+
+  std::vector<WindowRun> pulled;
+  {
+    std::lock_guard<std::mutex> guard(poolMutex);
+    const auto numInFlight = pendingRuns.size() + numRunsCosting;
+    if (numInFlight < maxPendingRuns) {
+      pulled = PullRuns(std::min(maxPendingRuns - numInFlight, DEFAULT_PENDING_RUNS_PER_WORKER));
+      numRunsCosting += pulled.size();
+    }
+  }
+
+  // reference fetch and k-mer hashing of pulled runs is done without the lock, in parallel across workers
+  for (auto& run : pulled) CostRun(&run, ownRefRdr.get());
+
+  std::lock_guard<std::mutex> guard(poolMutex);
+  if (!pulled.empty()) {
+    numRunsCosting -= pulled.size();
+    for (auto& run : pulled) AddPendingRun(std::move(run));
+    runsReady.notify_all();
+  }
+
+  if (pendingRuns.empty()) return {};
+
+  // Oldest pending run is claimed once it has been passed over too many times, so that the
+  // flush watermark in `RunPipeline` keeps advancing even when costlier runs keep arriving
+  std::size_t claimIdx = 0;
+  if (pendingRuns.front().numTimesSkipped < maxPendingRuns) {
+    double maxCost = -1.0;
+    for (std::size_t idx = 0; idx < pendingRuns.size(); ++idx) {
+      const auto currCost = EstimatedCost(pendingRuns[idx]);
+      if (currCost > maxCost) {
+        maxCost = currCost;
+        claimIdx = idx;
+      }
+    }
+  }
+
+  for (std::size_t idx = 0; idx < claimIdx; ++idx) pendingRuns[idx].numTimesSkipped++;
+
+  auto result = std::move(pendingRuns[claimIdx].windows);
+  pendingRuns.erase(pendingRuns.begin() + static_cast<std::ptrdiff_t>(claimIdx));
+  return result;
+}
+
+auto WindowScheduler::StealWindow(std::size_t thief_idx) -> WindowPtr {
+  for (;;) {
+    std::size_t victimIdx = thief_idx;
+    std::size_t victimSize = 0;
+
+    for (std::size_t idx = 0; idx < workerRuns.size(); ++idx) {
+      if (idx == thief_idx) continue;
+      std::lock_guard<utils::SpinLock> guard(workerRuns[idx].spinLock);
+      if (workerRuns[idx].windows.size() > victimSize) {
+        victimIdx = idx;
+        victimSize = workerRuns[idx].windows.size();
+      }
+    }
+
+    if (victimSize == 0) return nullptr;
+
+    auto& victim = workerRuns[victimIdx];
+    std::lock_guard<utils::SpinLock> guard(victim.spinLock);
+    if (victim.windows.empty()) continue;
+
+    auto result = std::move(victim.windows.back());
+    victim.windows.pop_back();
+    return result;
+  }
+}
+
+auto WindowScheduler::PullRuns(std::size_t max_runs) -> std::vector<WindowRun> {
+  std::vector<WindowRun> result;
+
+  while (result.size() < max_runs) {
+    if (nextWindow == nullptr && !isGenExhausted) nextWindow = windowGen->Next();
+    if (nextWindow == nullptr) {
+      isGenExhausted = true;
+      break;
+    }
+
+    WindowRun run;
+    const auto runChrom = nextWindow->Chromosome();
+    while (run.windows.size() < DEFAULT_WINDOWS_PER_RUN && nextWindow != nullptr &&
+           nextWindow->Chromosome() == runChrom) {
+      run.windows.emplace_back(std::move(nextWindow));
+      nextWindow = windowGen->Next();
+    }
+
+    isGenExhausted = nextWindow == nullptr;
+    run.firstIdx = run.windows.front()->WindowIndex();
+    run.lastIdx = run.windows.back()->WindowIndex();
+    result.emplace_back(std::move(run));
+  }
+
+  return result;
+}
+
+void WindowScheduler::CostRun(WindowRun* run, FastaReader* ref) const {
+  const auto minK = static_cast<std::size_t>(params->minKmerSize);
+  const auto maxK = static_cast<std::size_t>(params->maxKmerSize);
+  double sumCostFactors = 0.0;
+
+  for (const auto& window : run->windows) {
+    // Reference sequence is fetched here, so that MicroAssembler workers do not have to fetch it again.
+    // Windows with failed fetches are left as is, so that errors get reported by the workers.
+    if (window->SeqView().empty()) {
+      const auto regResult = ref->RegionSequence(window->ToGenomicRegion());
+      if (regResult.ok()) window->SetSequence(regResult.value());
+    }
+
+    const auto refseq = window->SeqView();
+    const auto knownInactive = activeIndex != nullptr && !activeIndex->MayBeActive(window->ToGenomicRegion());
+    if (!knownInactive) {
+      const auto skipsAssembly = !refseq.empty() && refseq.length() >= maxK && utils::HasRepeatKmer(refseq, maxK);
+      sumCostFactors += refseq.empty() ? 1.0 : (skipsAssembly ? 0.0 : ReferenceCostFactor(refseq, minK));
+    }
+  }
+
+  run->refCostFactor = sumCostFactors / static_cast<double>(run->windows.size());
+}
+
+void WindowScheduler::AddPendingRun(WindowRun&& run) {
+  const auto seedFromNeighbours = [&run](const std::deque<NeighbourStat>& recents) -> double {
+    OnlineStats stats;
+    for (const auto& item : recents) {
+      if (IsNeighbour(run, item.windowIdx)) stats.Add(item.value);
+    }
+    return stats.IsEmpty() ? -1.0 : stats.Mean();
+  };
+
+  run.neighbourSecs = seedFromNeighbours(recentRuntimes);
+  run.neighbourCov = seedFromNeighbours(recentCoverages);
+
+  // runs costed by different workers can finish out of order, pending runs are kept in genome order
+  const auto itr = std::upper_bound(pendingRuns.begin(), pendingRuns.end(), run.firstIdx,
+                                    [](std::size_t idx, const WindowRun& other) { return idx < other.firstIdx; });
+  pendingRuns.insert(itr, std::move(run));
+}
+
+auto WindowScheduler::EstimatedCost(const WindowRun& run) const -> double {
+  auto perWindowSecs = run.neighbourSecs;
+  if (perWindowSecs < 0) {
+    const auto meanSecs = runtimeStats.IsEmpty() ? 1.0 : runtimeStats.Mean();
+    const auto meanCov = coverageStats.Mean();
+    const auto covRatio = (run.neighbourCov >= 0 && meanCov > 0) ? run.neighbourCov / meanCov : 1.0;
+    perWindowSecs = meanSecs * covRatio;
+  }
+
+  return perWindowSecs * run.refCostFactor * static_cast<double>(run.windows.size());
+}
+
+void WindowScheduler::RecordNeighbourStat(std::size_t win_idx, double value, bool is_runtime) {
+  auto& recents = is_runtime ? recentRuntimes : recentCoverages;
+  recents.emplace_back(NeighbourStat{win_idx, value});
+  while (recents.size() > maxPendingRuns * DEFAULT_WINDOWS_PER_RUN) recents.pop_front();
+
+  for (auto& run : pendingRuns) {
+    if (!IsNeighbour(run, win_idx)) continue;
+    auto& neighbourVal = is_runtime ? run.neighbourSecs : run.neighbourCov;
+    neighbourVal = neighbourVal < 0 ? value : 0.5 * (neighbourVal + value);
+  }
+}
+
+auto WindowScheduler::IsNeighbour(const WindowRun& run, std::size_t win_idx) -> bool {
+  return (win_idx + DEFAULT_WINDOWS_PER_RUN) >= run.firstIdx && win_idx <= (run.lastIdx + DEFAULT_WINDOWS_PER_RUN);
+}
+}  // namespace lancet
@@ -0,0 +1,119 @@
+#include "lancet/active_region_index.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "catch2/catch.hpp"
+
+namespace {
+// Stand-ins for the tumor and normal BAMs, only their path, size and modification time are read
+auto WriteAlignmentFile(const std::string& name) -> std::filesystem::path {
+  const auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream(path, std::ios_base::trunc) << "not a bam";
+  return path;
+}
+
+const auto TUMOR_PATH = WriteAlignmentFile("lancet_active_region_index_test_tumor.bam");
+const auto NORMAL_PATH = WriteAlignmentFile("lancet_active_region_index_test_normal.bam");
+
+auto MakeIndex() -> lancet::ActiveRegionIndex {
+  const std::vector<lancet::ContigInfo> contigs{{"chr1", 5000}, {"chr2", 1500}};
+  lancet::ActiveRegionIndex result(contigs, 3, 17, 1000);
+
+  lancet::SampleScan tmrScan;
+  tmrScan.intervals = {{{100, 110}, {500, 501}}, {}};
+  tmrScan.binBases = {{30000, 0, 0, 0, 0}, {0, 5000}};
+  tmrScan.maxReadSpan = 150;
+  tmrScan.source = lancet::StampAlignmentFile(TUMOR_PATH.string());
+  result.AddSample(tmrScan, lancet::SampleLabel::TUMOR);
+
+  lancet::SampleScan nmlScan;
+  nmlScan.intervals = {{{105, 120}, {2000, 2010}}, {}};
+  nmlScan.binBases = {{10000, 0, 0, 0, 0}, {0, 0}};
+  nmlScan.maxReadSpan = 100;
+  nmlScan.source = lancet::StampAlignmentFile(NORMAL_PATH.string());
+  result.AddSample(nmlScan, lancet::SampleLabel::NORMAL);
+  return result;
+}
+
+void CheckIndex(const lancet::ActiveRegionIndex& idx) {
+  CHECK(idx.NumActiveIntervals() == 3);
+  CHECK(idx.NumActiveBases() == 31);
+
+  // active positions are padded by the longest read span on both sides of a window
+  CHECK(idx.MayBeActive(lancet::GenomicRegion("chr1", 2161, 2760)));
+  CHECK_FALSE(idx.MayBeActive(lancet::GenomicRegion("chr1", 2162, 2760)));
+  CHECK(idx.MayBeActive(lancet::GenomicRegion("chr1", 1001, 1850)));
+  CHECK_FALSE(idx.MayBeActive(lancet::GenomicRegion("chr1", 1001, 1849)));
+  CHECK_FALSE(idx.MayBeActive(lancet::GenomicRegion("chr2", 1, 600)));
+  CHECK(idx.MayBeActive(lancet::GenomicRegion("chr3", 1, 600)));
+
+  CHECK(idx.AverageCoverage(lancet::GenomicRegion("chr1", 1, 1000)) == Approx(20.0));
+  CHECK(idx.AverageCoverage(lancet::GenomicRegion("chr2", 1001, 1500)) == Approx(5.0));
+}
+}  // namespace
+
+TEST_CASE("active region index merges samples and skips only windows far from active positions",
+          "active_region_index.h") {
+  const auto idx = MakeIndex();
+  CheckIndex(idx);
+
+  SECTION("index round trips through file") {
+    const auto path = std::filesystem::temp_directory_path() / "lancet_active_region_index_test.bin";
+    REQUIRE(idx.Write(path).ok());
+
+    const auto loaded = lancet::ActiveRegionIndex::Load(path);
+    REQUIRE(loaded.ok());
+    CheckIndex(loaded.value());
+
+    lancet::CliParams params;
+    params.tumorPath = TUMOR_PATH.string();
+    params.normalPath = NORMAL_PATH.string();
+    CHECK(loaded.value().CheckCompatible(params, {{"chr1", 5000}, {"chr2", 1500}}).ok());
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    CHECK(absl::IsDataLoss(lancet::ActiveRegionIndex::Load(path).status()));
+
+    std::ofstream(path, std::ios_base::trunc) << "not an index";
+    CHECK(absl::IsInvalidArgument(lancet::ActiveRegionIndex::Load(path).status()));
+    std::filesystem::remove(path);
+  }
+
+  SECTION("index is only compatible with same or stricter thresholds and same reference") {
+    const std::vector<lancet::ContigInfo> refContigs{{"chr1", 5000}, {"chr2", 1500}};
+    lancet::CliParams params;
+    params.tumorPath = TUMOR_PATH.string();
+    params.normalPath = NORMAL_PATH.string();
+    CHECK(idx.CheckCompatible(params, refContigs).ok());
+
+    params.minTmrAltCnt = 5;
+    CHECK(idx.CheckCompatible(params, refContigs).ok());
+
+    params.minTmrAltCnt = 2;
+    CHECK_FALSE(idx.CheckCompatible(params, refContigs).ok());
+
+    params.minTmrAltCnt = 3;
+    params.minBaseQual = 10;
+    CHECK_FALSE(idx.CheckCompatible(params, refContigs).ok());
+
+    params.minBaseQual = 17;
+    const std::vector<lancet::ContigInfo> otherContigs{{"chr1", 5000}, {"chr2", 1600}};
+    CHECK_FALSE(idx.CheckCompatible(params, otherContigs).ok());
+  }
+
+  SECTION("index is only compatible with the tumor and normal BAMs it was built from") {
+    const std::vector<lancet::ContigInfo> refContigs{{"chr1", 5000}, {"chr2", 1500}};
+    lancet::CliParams params;
+    params.tumorPath = NORMAL_PATH.string();
+    params.normalPath = TUMOR_PATH.string();
+    CHECK(absl::IsFailedPrecondition(idx.CheckCompatible(params, refContigs)));
+
+    params.tumorPath = TUMOR_PATH.string();
+    params.normalPath = NORMAL_PATH.string();
+    std::ofstream(TUMOR_PATH, std::ios_base::app) << " anymore";
+    CHECK(absl::IsFailedPrecondition(idx.CheckCompatible(params, refContigs)));
+  }
+}
@@ -0,0 +1,39 @@
+#include "lancet/base_decode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+TEST_CASE("vector base decode kernels match scalar decode", "base_decode.h") {
+  static constexpr const char* NT16_ASCII = "=ACMGRSVTWYHKDBN";
+
+  std::mt19937 gen(42);  // NOLINT
+  std::uniform_int_distribution<unsigned> byteDist(0, 255);  // NOLINT
+  std::vector<std::uint8_t> packed(128);                       // NOLINT
+  for (auto& byte : packed) byte = static_cast<std::uint8_t>(byteDist(gen));
+
+  std::string expected(packed.size() * 2, 'N');
+  for (std::size_t idx = 0; idx < expected.size(); ++idx) {
+    const auto code = (packed[idx / 2] >> ((idx % 2 == 0) ? 4U : 0U)) & 0xFU;  // NOLINT
+    expected[idx] = NT16_ASCII[code];                                          // NOLINT
+  }
+
+  const auto best = static_cast<int>(lancet::BestDecodeKernel());
+  for (int kernelIdx = 0; kernelIdx <= best; ++kernelIdx) {
+    const auto kernel = static_cast<lancet::DecodeKernel>(kernelIdx);
+    INFO("kernel " << lancet::ToString(kernel));
+
+    // odd starts and lengths exercise the unaligned head and the scalar tail of each kernel
+    for (const std::size_t start : {0U, 1U, 2U, 7U, 33U}) {
+      for (const std::size_t count : {0U, 1U, 15U, 16U, 17U, 31U, 32U, 33U, 150U, 200U}) {
+        std::string result(count, '\0');
+        lancet::DecodeBases(kernel, packed.data(), start, count, result.data());
+        CHECK(result == expected.substr(start, count));
+      }
+    }
+  }
+}
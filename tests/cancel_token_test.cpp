@@ -0,0 +1,76 @@
+#include "lancet/cancel_token.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "lancet/align.h"
+#include "lancet/cli_params.h"
+#include "lancet/graph_builder.h"
+#include "lancet/read_info.h"
+#include "lancet/ref_window.h"
+
+namespace {
+auto ExpiredToken() -> lancet::CancelToken {
+  lancet::CancelToken result(absl::Nanoseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  return result;
+}
+}  // namespace
+
+TEST_CASE("cancel token expires only after a positive time budget", "cancel_token.h") {
+  SECTION("default and non-positive budgets never expire") {
+    const lancet::CancelToken noBudget;
+    const lancet::CancelToken zeroBudget(absl::ZeroDuration());
+    const lancet::CancelToken negativeBudget(absl::Seconds(-1));
+    CHECK_FALSE(noBudget.IsExpired());
+    CHECK_FALSE(zeroBudget.IsExpired());
+    CHECK_FALSE(negativeBudget.IsExpired());
+    CHECK_NOTHROW(zeroBudget.ThrowIfExpired("test"));
+  }
+
+  SECTION("token within budget does not throw") {
+    const lancet::CancelToken token(absl::Hours(1));
+    CHECK_FALSE(token.IsExpired());
+    CHECK_NOTHROW(lancet::ThrowIfExpired(&token, "test"));
+  }
+
+  SECTION("expired token throws timeout error naming the stage") {
+    const auto token = ExpiredToken();
+    CHECK(token.IsExpired());
+    CHECK_THROWS_AS(token.ThrowIfExpired("test stage"), lancet::WindowTimeoutError);
+    CHECK_THROWS_WITH(token.ThrowIfExpired("test stage"), Catch::Contains("test stage"));
+  }
+
+  SECTION("missing token is never expired") { CHECK_NOTHROW(lancet::ThrowIfExpired(nullptr, "test")); }
+}
+
+TEST_CASE("window assembly stages report expired budget as window timeout", "cancel_token.h") {
+  const auto token = ExpiredToken();
+
+  SECTION("path alignment") {
+    CHECK_THROWS_AS(lancet::Align("ACGTACGTACGTTTGACCA", "ACGTACGAAACGTTTGACCA", &token), lancet::WindowTimeoutError);
+  }
+
+  SECTION("graph building") {
+    auto window = std::make_shared<lancet::RefWindow>();
+    window->SetChromosome("chr1");
+    window->SetStartPosition0(0);
+    window->SetEndPosition0(40);
+    window->SetSequence("ACGTTGCATGCCATGAGGTACCTTAGCAGTCAGATCGGAT");
+
+    lancet::ReadInfo read;
+    read.chromName = "chr1";
+    read.sequence = window->Sequence();
+    read.quality = std::string(read.sequence.length(), 'I');
+    read.startPos0 = 0;
+    const std::vector<lancet::ReadInfo> reads{read};
+
+    const auto params = std::make_shared<const lancet::CliParams>();
+    lancet::GraphBuilder builder(window, reads, 1.0, params, &token);
+    CHECK_THROWS_AS(builder.BuildGraph(params->minKmerSize, params->maxKmerSize), lancet::WindowTimeoutError);
+  }
+}
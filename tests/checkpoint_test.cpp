@@ -0,0 +1,282 @@
+#include "lancet/checkpoint.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "lancet/variant_store.h"
+#include "lancet/vcf_writer.h"
+#include "lancet/window_builder.h"
+
+namespace {
+constexpr std::uint32_t WINDOW_LENGTH = 600;
+constexpr std::int64_t STEP_SIZE = 300;
+constexpr std::size_t FLUSH_LAG = 3;
+
+auto JournalParams() -> lancet::CliParams {
+  lancet::CliParams params;
+  params.referencePath = "ref.fa";
+  params.tumorPath = "tumor.bam";
+  params.normalPath = "normal.bam";
+  return params;
+}
+
+auto FreshVcfPath(const std::string& name) -> std::filesystem::path {
+  const auto path = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove(path);
+  std::filesystem::remove(path.string() + ".ckpt");
+  return path;
+}
+
+void AppendText(const std::filesystem::path& path, const std::string& text) {
+  std::ofstream outFh(path, std::ios_base::out | std::ios_base::app);
+  outFh << text;
+}
+
+auto ReadText(const std::filesystem::path& path) -> std::string {
+  std::ifstream inFh(path);
+  std::stringstream result;
+  result << inFh.rdbuf();
+  return result.str();
+}
+
+auto MakeGenerator() -> std::unique_ptr<lancet::WindowGenerator> {
+  std::vector<lancet::RefWindow> regions(2);
+  regions[0].SetChromosome("chr1");
+  regions[0].SetStartPosition0(0);
+  regions[0].SetEndPosition0(6000);  // NOLINT
+  regions[1].SetChromosome("chr2");
+  regions[1].SetStartPosition0(0);
+  regions[1].SetEndPosition0(3000);  // NOLINT
+  return std::make_unique<lancet::WindowGenerator>(std::move(regions), WINDOW_LENGTH, STEP_SIZE);
+}
+
+// Variants at fixed genome positions, so that overlapping windows call the same variants with different coverage
+auto WindowVariants(const lancet::RefWindow& window) -> std::vector<lancet::Variant> {
+  std::vector<lancet::Variant> result;
+  const auto extraCov = static_cast<std::uint16_t>(window.WindowIndex() % 3);
+  for (auto pos = window.StartPosition0(); pos < window.EndPosition0(); ++pos) {
+    if (pos % 97 != 0) continue;  // NOLINT
+    const lancet::VariantHpCov tmrCov(lancet::HpCov({10, 9}, {0, 0, 0}),
+                                      lancet::HpCov({3, static_cast<std::uint16_t>(2 + extraCov)}, {0, 0, 0}));
+    const lancet::VariantHpCov nmlCov(lancet::HpCov({12, 11}, {0, 0, 0}), lancet::HpCov({0, 0}, {0, 0, 0}));
+    result.emplace_back(window.Chromosome(), static_cast<std::size_t>(pos + 1), "A", "T", lancet::TranscriptCode::SNV,
+                        1, 31, tmrCov, nmlCov);
+  }
+  return result;
+}
+
+// Processes windows in order like the pipeline output thread, flushing each window once `FLUSH_LAG` windows
+// after it are done. Returns the checkpoint recorded after `stop_after` windows, or after all windows are done.
+auto RunWindows(lancet::WindowGenerator* gen, const lancet::Checkpoint& resume_from, lancet::VcfWriter* out,
+                lancet::VariantStore* store, std::size_t stop_after) -> lancet::Checkpoint {
+  lancet::Checkpoint result = resume_from;
+  std::vector<lancet::WindowPtr> unflushed;
+  std::size_t numDone = resume_from.numFlushedWindows;
+
+  for (auto window = gen->Next(); window != nullptr; window = gen->Next()) {
+    auto variants = WindowVariants(*window);
+    store->AddVariants(absl::MakeSpan(variants));
+    unflushed.push_back(window);
+    numDone++;
+
+    while (!unflushed.empty() && unflushed.front()->WindowIndex() + FLUSH_LAG <= numDone) {
+      store->FlushWindow(*unflushed.front(), *out);
+      result.numFlushedWindows = unflushed.front()->WindowIndex() + 1;
+      result.lastFlushedChrom = unflushed.front()->Chromosome();
+      result.lastFlushedEnd0 = unflushed.front()->EndPosition0();
+      unflushed.erase(unflushed.begin());
+    }
+
+    if (numDone == stop_after) break;
+  }
+
+  out->Flush();
+  result.numDoneWindows = numDone;
+  result.vcfOffset = out->Offset();
+  return result;
+}
+
+auto RunWithoutInterrupt(const std::filesystem::path& out_path, const lancet::CliParams& params) -> std::string {
+  const auto paramsPtr = std::make_shared<const lancet::CliParams>(params);
+  lancet::VariantStore store(paramsPtr, {{"chr1", 0}, {"chr2", 1}});
+  lancet::VcfWriter out(out_path, 0);
+  out.WriteHeader("##fileformat=VCFv4.3\n");
+  const auto gen = MakeGenerator();
+  RunWindows(gen.get(), {}, &out, &store, gen->TotalWindows());
+  store.FlushAll(out);
+  out.Close();
+  return ReadText(out_path);
+}
+}  // namespace
+
+TEST_CASE("checkpoint journal keeps the last complete checkpoint", "checkpoint.h") {
+  const auto vcfPath = FreshVcfPath("lancet_checkpoint_test.vcf");
+  lancet::CheckpointJournal journal(vcfPath, JournalParams());
+  CHECK(journal.Path() == vcfPath.string() + ".ckpt");
+
+  SECTION("missing journal cannot be loaded") { CHECK(absl::IsNotFound(journal.LoadLast().status())); }
+
+  SECTION("journal with only a header loads the first window checkpoint") {
+    REQUIRE(journal.Open(false).ok());
+    const auto result = journal.LoadLast();
+    REQUIRE(result.ok());
+    CHECK(result.value().numFlushedWindows == 0);
+    CHECK(result.value().vcfOffset == 0);
+    CHECK(result.value().lastFlushedChrom.empty());
+    CHECK(result.value().lastFlushedEnd0 == -1);
+  }
+
+  SECTION("last complete record is loaded and a truncated last line is ignored") {
+    REQUIRE(journal.Open(false).ok());
+    journal.Record({0, 0, 21, "", -1});          // NOLINT
+    journal.Record({7, 9, 1234, "chr2", 2400});  // NOLINT
+    AppendText(journal.Path(), "11\t14\t20");
+
+    const auto result = journal.LoadLast();
+    REQUIRE(result.ok());
+    CHECK(result.value().numFlushedWindows == 7);
+    CHECK(result.value().numDoneWindows == 9);
+    CHECK(result.value().vcfOffset == 1234);
+    CHECK(result.value().lastFlushedChrom == "chr2");
+    CHECK(result.value().lastFlushedEnd0 == 2400);
+  }
+
+  SECTION("reopened journal appends records after the existing ones") {
+    REQUIRE(journal.Open(false).ok());
+    journal.Record({3, 4, 100, "chr1", 1200});  // NOLINT
+
+    lancet::CheckpointJournal resumed(vcfPath, JournalParams());
+    REQUIRE(resumed.Open(true).ok());
+    resumed.Record({5, 6, 200, "chr1", 1800});  // NOLINT
+
+    const auto result = resumed.LoadLast();
+    REQUIRE(result.ok());
+    CHECK(result.value().numFlushedWindows == 5);
+    CHECK(result.value().vcfOffset == 200);
+  }
+
+  SECTION("corrupt complete record is reported") {
+    REQUIRE(journal.Open(false).ok());
+    AppendText(journal.Path(), "3\tfour\t100\tchr1\t1200\n");
+    CHECK(absl::IsDataLoss(journal.LoadLast().status()));
+  }
+
+  SECTION("journal without header is reported") {
+    AppendText(journal.Path(), "3\t4\t100\tchr1\t1200\n");
+    CHECK(absl::IsDataLoss(journal.LoadLast().status()));
+  }
+
+  SECTION("removed journal is deleted from disk") {
+    REQUIRE(journal.Open(false).ok());
+    journal.Remove();
+    CHECK_FALSE(std::filesystem::exists(journal.Path()));
+  }
+}
+
+TEST_CASE("checkpoint journal from a run with different parameters is rejected", "checkpoint.h") {
+  const auto vcfPath = FreshVcfPath("lancet_checkpoint_fingerprint_test.vcf");
+  {
+    lancet::CheckpointJournal journal(vcfPath, JournalParams());
+    REQUIRE(journal.Open(false).ok());
+    journal.Record({3, 4, 100, "chr1", 1200});  // NOLINT
+  }
+
+  SECTION("different window length") {
+    auto params = JournalParams();
+    params.windowLength += 100;  // NOLINT
+    CHECK(absl::IsFailedPrecondition(lancet::CheckpointJournal(vcfPath, params).LoadLast().status()));
+  }
+
+  SECTION("different shard") {
+    auto params = JournalParams();
+    params.shardIdx = 2;
+    params.numShards = 2;
+    CHECK(absl::IsFailedPrecondition(lancet::CheckpointJournal(vcfPath, params).LoadLast().status()));
+  }
+
+  SECTION("different tumor") {
+    auto params = JournalParams();
+    params.tumorPath = "other_tumor.bam";
+    CHECK(absl::IsFailedPrecondition(lancet::CheckpointJournal(vcfPath, params).LoadLast().status()));
+  }
+
+  SECTION("different variant filter") {
+    auto params = JournalParams();
+    params.minTmrVAF = 0.1;  // NOLINT
+    CHECK(absl::IsFailedPrecondition(lancet::CheckpointJournal(vcfPath, params).LoadLast().status()));
+  }
+
+  SECTION("different kmer range") {
+    auto params = JournalParams();
+    params.maxKmerSize -= 10;  // NOLINT
+    CHECK(absl::IsFailedPrecondition(lancet::CheckpointJournal(vcfPath, params).LoadLast().status()));
+  }
+
+  SECTION("different tenx mode") {
+    auto params = JournalParams();
+    params.tenxMode = true;
+    CHECK(absl::IsFailedPrecondition(lancet::CheckpointJournal(vcfPath, params).LoadLast().status()));
+  }
+
+  SECTION("different number of threads can resume") {
+    auto params = JournalParams();
+    params.numWorkerThreads += 3;  // NOLINT
+    params.numHtsThreads += 2;     // NOLINT
+    params.resumeRun = true;
+    const auto result = lancet::CheckpointJournal(vcfPath, params).LoadLast();
+    REQUIRE(result.ok());
+    CHECK(result.value().numFlushedWindows == 3);
+  }
+}
+
+TEST_CASE("resumed run writes every variant exactly once", "checkpoint.h") {
+  const auto params = JournalParams();
+  const auto expected = RunWithoutInterrupt(FreshVcfPath("lancet_checkpoint_full_run_test.vcf"), params);
+  REQUIRE(expected.length() > std::string("##fileformat=VCFv4.3\n").length());
+
+  const auto numTotal = MakeGenerator()->TotalWindows();
+  // interrupt after every window, including windows just before and after the contig boundary
+  for (std::size_t stopAfter = 1; stopAfter < numTotal; ++stopAfter) {
+    INFO("interrupted after " << stopAfter << " windows");
+    const auto vcfPath = FreshVcfPath("lancet_checkpoint_resume_test.vcf");
+    const auto paramsPtr = std::make_shared<const lancet::CliParams>(params);
+
+    {
+      // interrupted run records checkpoint, then writes more output before it gets killed
+      lancet::CheckpointJournal journal(vcfPath, params);
+      REQUIRE(journal.Open(false).ok());
+      lancet::VariantStore store(paramsPtr, {{"chr1", 0}, {"chr2", 1}});
+      lancet::VcfWriter out(vcfPath, 0);
+      out.WriteHeader("##fileformat=VCFv4.3\n");
+      const auto gen = MakeGenerator();
+      journal.Record(RunWindows(gen.get(), {}, &out, &store, stopAfter));
+      RunWindows(gen.get(), {}, &out, &store, numTotal);
+      store.FlushAll(out);
+      out.Close();
+      AppendText(journal.Path(), "99\t99\t");
+    }
+
+    const auto resumeFrom = lancet::CheckpointJournal(vcfPath, params).LoadLast();
+    REQUIRE(resumeFrom.ok());
+    const auto& ckpt = resumeFrom.value();
+
+    // same steps as `RunPipeline` takes to resume from the last checkpoint
+    lancet::VariantStore store(paramsPtr, {{"chr1", 0}, {"chr2", 1}});
+    lancet::VcfWriter out(vcfPath, ckpt.vcfOffset);
+    const auto gen = MakeGenerator();
+    gen->SkipWindows(ckpt.numFlushedWindows);
+    if (ckpt.vcfOffset > 0) store.SetFlushedUpto(ckpt.lastFlushedChrom, ckpt.lastFlushedEnd0);
+    RunWindows(gen.get(), ckpt, &out, &store, numTotal);
+    store.FlushAll(out);
+    out.Close();
+
+    CHECK(ReadText(vcfPath) == expected);
+  }
+}
@@ -0,0 +1,20 @@
+#include "lancet/cli_params.h"
+
+#include "catch2/catch.hpp"
+
+TEST_CASE("output path extension must match output format", "cli_params.h") {
+  lancet::CliParams params;
+  for (const auto* path : {"calls.vcf", "calls.vcf.gz"}) {
+    params.outVcfPath = path;
+    params.outputFormat = "vcf";
+    CHECK(params.ValidateOutputFormat());
+    params.outputFormat = "bcf";
+    CHECK_FALSE(params.ValidateOutputFormat());
+  }
+
+  params.outVcfPath = "calls.bcf";
+  params.outputFormat = "bcf";
+  CHECK(params.ValidateOutputFormat());
+  params.outputFormat = "vcf";
+  CHECK_FALSE(params.ValidateOutputFormat());
+}
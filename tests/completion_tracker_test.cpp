@@ -0,0 +1,36 @@
+#include "lancet/completion_tracker.h"
+
+#include "catch2/catch.hpp"
+
+TEST_CASE("tracks watermark of windows completed out of order", "completion_tracker.h") {
+  lancet::CompletionTracker tracker;
+  CHECK(tracker.Watermark() == 0);
+
+  SECTION("watermark advances only past contiguously done windows") {
+    CHECK(tracker.MarkDone(2));
+    CHECK(tracker.MarkDone(1));
+    CHECK(tracker.Watermark() == 0);
+    CHECK(tracker.IsDone(2));
+    CHECK_FALSE(tracker.IsDone(0));
+
+    CHECK(tracker.MarkDone(0));
+    CHECK(tracker.Watermark() == 3);
+    CHECK(tracker.NumDone() == 3);
+  }
+
+  SECTION("long running window moves watermark past many windows at once") {
+    for (std::size_t idx = 1; idx < 100; ++idx) CHECK(tracker.MarkDone(idx));
+    CHECK(tracker.Watermark() == 0);
+    CHECK(tracker.MarkDone(0));
+    CHECK(tracker.Watermark() == 100);
+  }
+
+  SECTION("windows already done are not counted twice") {
+    CHECK(tracker.MarkDone(0));
+    CHECK(tracker.MarkDone(5));
+    CHECK_FALSE(tracker.MarkDone(0));
+    CHECK_FALSE(tracker.MarkDone(5));
+    CHECK(tracker.NumDone() == 2);
+    CHECK(tracker.Watermark() == 1);
+  }
+}
@@ -0,0 +1,55 @@
+#include "lancet/filter_profile.h"
+
+#include "catch2/catch.hpp"
+
+TEST_CASE("parses named filter profiles on top of pipeline params", "filter_profile.h") {
+  lancet::CliParams params;
+  params.outVcfPath = "calls.vcf.gz";
+  params.minTmrAltCnt = 3;
+
+  SECTION("filters not set in a profile keep their pipeline values") {
+    params.filterProfiles = {"strict:min-fisher=10,min-tmr-vaf=0.1", "permissive:max-nml-alt-cnt=2"};
+    const auto result = lancet::ParseFilterProfiles(params);
+    REQUIRE(result.ok());
+    REQUIRE(result->size() == 2);
+
+    const auto& strict = result->at(0);
+    CHECK(strict.name == "strict");
+    CHECK(strict.outPath == "calls.strict.vcf.gz");
+    CHECK(strict.params.minFisher == 10.0);
+    CHECK(strict.params.minTmrVAF == 0.1);
+    CHECK(strict.params.minTmrAltCnt == 3);
+
+    const auto& permissive = result->at(1);
+    CHECK(permissive.params.maxNmlAltCnt == 2);
+    CHECK(permissive.params.minFisher == params.minFisher);
+  }
+
+  SECTION("invalid profiles are rejected") {
+    for (const auto* spec : {"strict:min-fisher", "strict:unknown=1", "strict:min-tmr-cov=-1", ":min-fisher=1",
+                             "a/b:min-fisher=1"}) {
+      params.filterProfiles = {spec};
+      CHECK_FALSE(lancet::ParseFilterProfiles(params).ok());
+    }
+
+    params.filterProfiles = {"strict:min-fisher=10", "strict:min-fisher=20"};
+    CHECK_FALSE(lancet::ParseFilterProfiles(params).ok());
+  }
+
+  SECTION("profiles can not lower min-tmr-alt-cnt below the pipeline value used to find active regions") {
+    params.filterProfiles = {"permissive:min-tmr-alt-cnt=2"};
+    CHECK_FALSE(lancet::ParseFilterProfiles(params).ok());
+
+    params.filterProfiles = {"same:min-tmr-alt-cnt=3", "strict:min-tmr-alt-cnt=5"};
+    const auto result = lancet::ParseFilterProfiles(params);
+    REQUIRE(result.ok());
+    CHECK(result->at(1).params.minTmrAltCnt == 5);
+  }
+}
+
+TEST_CASE("profile name is added before output extension", "filter_profile.h") {
+  CHECK(lancet::ProfileOutputPath("out/calls.vcf", "strict") == "out/calls.strict.vcf");
+  CHECK(lancet::ProfileOutputPath("calls.vcf.gz", "strict") == "calls.strict.vcf.gz");
+  CHECK(lancet::ProfileOutputPath("calls.bcf", "strict") == "calls.strict.bcf");
+  CHECK(lancet::ProfileOutputPath("calls.txt", "strict") == "calls.txt.strict");
+}
@@ -0,0 +1,51 @@
+#include "lancet/fisher_exact.h"
+
+#include <array>
+#include <cstring>
+
+#include "catch2/catch.hpp"
+
+namespace {
+// Compare bit patterns, so that differences in the last ulp are not hidden by floating point comparisons
+auto SameBits(double lhs, double rhs) -> bool { return std::memcmp(&lhs, &rhs, sizeof(double)) == 0; }
+}  // namespace
+
+TEST_CASE("table based fisher scores are bit-identical to htslib", "fisher_exact.h") {
+  // each section starts the grid at a different offset, so that scores cached by earlier sections are not reused
+  const auto checkGrid = [](int first_n11) {
+    for (int n11 = first_n11; n11 <= 40; n11 += 3) {
+      for (int n12 = 0; n12 <= 40; n12 += 5) {
+        for (int n21 = 0; n21 <= 40; n21 += 7) {
+          for (int n22 = 0; n22 <= 40; n22 += 2) {
+            const auto expected = lancet::PhredScaled(lancet::FisherTest(n11, n12, n21, n22));
+            // score is computed once and then served from the per-thread cache
+            CHECK(SameBits(lancet::PhredFisherScore(n11, n12, n21, n22), expected));
+            CHECK(SameBits(lancet::PhredFisherScore(n11, n12, n21, n22), expected));
+          }
+        }
+      }
+    }
+  };
+
+  SECTION("without log-factorial table") { checkGrid(0); }
+
+  SECTION("with log-factorial table smaller than some tables") {
+    lancet::InitLogFactorialTable(100);
+    checkGrid(1);
+  }
+
+  SECTION("large counts beyond coverage caps") {
+    lancet::InitLogFactorialTable(2000);
+    const std::array<lancet::FisherCounts, 4> tables{lancet::FisherCounts{1500, 1480, 3, 240},
+                                                     lancet::FisherCounts{900, 1100, 0, 0},
+                                                     lancet::FisherCounts{70000, 3, 65535, 9},
+                                                     lancet::FisherCounts{0, 0, 0, 0}};
+    std::array<double, 4> scores{};
+    lancet::PhredFisherScores(tables, absl::MakeSpan(scores));
+
+    for (std::size_t idx = 0; idx < tables.size(); ++idx) {
+      const auto& tbl = tables[idx];
+      CHECK(SameBits(scores[idx], lancet::PhredScaled(lancet::FisherTest(tbl.n11, tbl.n12, tbl.n21, tbl.n22))));
+    }
+  }
+}
@@ -1,8 +1,11 @@
 #define CATCH_CONFIG_RUNNER
 #include "catch2/catch.hpp"
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "spdlog/spdlog.h"
 
 auto main(int argc, char** argv) -> int {
   // Do any global test setup here
+  spdlog::stderr_color_mt("stderr")->set_level(spdlog::level::warn);
   int result = Catch::Session().run(argc, argv);
   // Do any global test teardown here
   return result;
@@ -0,0 +1,120 @@
+#include "lancet/merge_vcfs.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "catch2/catch.hpp"
+#include "lancet/vcf_writer.h"
+#include "test_utils.h"
+
+namespace {
+constexpr auto SHARD_HEADER = R"raw(##fileformat=VCFv4.3
+##commandLine="lancet pipeline --shard 1/2"
+##FILTER=<ID=LowFisherScore,Description="Fisher exact test score for tumor/normal allele counts less than 5">
+##INFO=<ID=SOMATIC,Number=0,Type=Flag,Description="Mutation present only in tumor">
+##FORMAT=<ID=GT,Number=1,Type=String,Description="Genotype">
+##FORMAT=<ID=DP,Number=1,Type=Integer,Description="Read depth">
+##contig=<ID=chr1,length=1000>
+##contig=<ID=chr2,length=1000>
+#CHROM	POS	ID	REF	ALT	QUAL	FILTER	INFO	FORMAT	normal	tumor
+)raw";
+
+auto Record(const std::string& chrom, int pos, int tmr_depth) -> std::string {
+  return chrom + "\t" + std::to_string(pos) + "\t.\tA\tT\t30\tPASS\tSOMATIC\tGT:DP\t0/0:10\t0/1:" +
+         std::to_string(tmr_depth);
+}
+
+using lancet::test::TempPath;
+
+// Reference only needs contig names for the merge
+auto WriteReference() -> std::filesystem::path {
+  return lancet::test::WriteTempFasta("lancet_merge_vcfs_test.fa",
+                                      {{"chr1", std::string(1000, 'A')}, {"chr2", std::string(1000, 'A')}});  // NOLINT
+}
+
+void WriteShard(const std::filesystem::path& path, const std::vector<std::string>& records, bool as_bcf = false) {
+  lancet::VcfWriter out(path, 0, as_bcf);
+  out.WriteHeader(SHARD_HEADER);
+  for (const auto& rec : records) out.WriteRecord(rec + "\n");
+  out.Close();
+}
+
+auto ReadLines(const std::filesystem::path& path) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  std::ifstream inFh(path);
+  for (std::string line; std::getline(inFh, line);) result.push_back(line);
+  return result;
+}
+}  // namespace
+
+TEST_CASE("merging shard VCFs drops duplicates and keeps reference order", "merge_vcfs.h") {
+  lancet::MergeParams params;
+  params.referencePath = WriteReference().string();
+  params.commandLine = "lancet merge";
+
+  // first shard is plain text, second shard is BGZF compressed like shards written with `-o *.vcf.gz`
+  const auto firstShard = TempPath("lancet_merge_vcfs_test_1.vcf");
+  const auto secondShard = TempPath("lancet_merge_vcfs_test_2.vcf.gz");
+  WriteShard(firstShard, {Record("chr1", 100, 12), Record("chr1", 500, 8), Record("chr2", 20, 9)});
+  WriteShard(secondShard, {Record("chr1", 300, 11), Record("chr1", 500, 25), Record("chr2", 10, 7)});
+  params.inVcfPaths = {firstShard.string(), secondShard.string()};
+
+  const std::vector<std::string> expected{Record("chr1", 100, 12), Record("chr1", 300, 11), Record("chr1", 500, 25),
+                                          Record("chr2", 10, 7), Record("chr2", 20, 9)};
+
+  SECTION("plain output") {
+    const auto outPath = TempPath("lancet_merge_vcfs_test_out.vcf");
+    params.outVcfPath = outPath.string();
+    REQUIRE(lancet::MergeShardVcfs(params).ok());
+
+    std::vector<std::string> records;
+    std::vector<std::string> commandLines;
+    for (const auto& line : ReadLines(outPath)) {
+      if (absl::StartsWith(line, "##commandLine=")) commandLines.push_back(line);
+      if (!absl::StartsWith(line, "#")) records.push_back(line);
+    }
+
+    CHECK(commandLines == std::vector<std::string>{R"(##commandLine="lancet merge")"});
+    CHECK(records == expected);
+  }
+
+  SECTION("compressed and indexed output") {
+    const auto outPath = TempPath("lancet_merge_vcfs_test_out.vcf.gz");
+    std::filesystem::remove(outPath.string() + ".tbi");
+    params.outVcfPath = outPath.string();
+    REQUIRE(lancet::MergeShardVcfs(params).ok());
+
+    CHECK(std::filesystem::exists(outPath.string() + ".tbi"));
+
+    // merged output can be merged again, which only works if it is read back through htslib
+    const auto remergedPath = TempPath("lancet_merge_vcfs_test_remerged.vcf");
+    params.inVcfPaths = {outPath.string()};
+    params.outVcfPath = remergedPath.string();
+    REQUIRE(lancet::MergeShardVcfs(params).ok());
+
+    std::vector<std::string> records;
+    for (const auto& line : ReadLines(remergedPath)) {
+      if (!absl::StartsWith(line, "#")) records.push_back(line);
+    }
+    CHECK(records == expected);
+  }
+
+  SECTION("unsorted shard is rejected") {
+    const auto unsortedShard = TempPath("lancet_merge_vcfs_test_unsorted.vcf");
+    WriteShard(unsortedShard, {Record("chr2", 10, 7), Record("chr1", 100, 12)});
+    params.inVcfPaths = {unsortedShard.string()};
+    params.outVcfPath = TempPath("lancet_merge_vcfs_test_unsorted_out.vcf").string();
+    CHECK(absl::IsFailedPrecondition(lancet::MergeShardVcfs(params)));
+  }
+
+  SECTION("bcf shard is rejected") {
+    const auto bcfShard = TempPath("lancet_merge_vcfs_test_3.bcf");
+    WriteShard(bcfShard, {Record("chr1", 200, 10)}, true);
+    params.inVcfPaths = {firstShard.string(), bcfShard.string()};
+    params.outVcfPath = TempPath("lancet_merge_vcfs_test_bcf_out.vcf").string();
+    CHECK(absl::IsInvalidArgument(lancet::MergeShardVcfs(params)));
+  }
+}
@@ -0,0 +1,148 @@
+#include "lancet/read_extractor.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "generated/test_config.h"
+
+namespace {
+constexpr std::int64_t WINDOW_LENGTH = 600;
+constexpr std::int64_t STEP_SIZE = 300;
+constexpr std::int64_t FIRST_START1 = 82960001;  // test BAMs have reads in 1:82959850-82970000
+constexpr std::array<lancet::SampleLabel, 2> LABELS{lancet::SampleLabel::TUMOR, lancet::SampleLabel::NORMAL};
+
+auto TestParams() -> std::shared_ptr<const lancet::CliParams> {
+  const std::filesystem::path dataDir(TEST_DATA_DIR);
+  auto result = std::make_shared<lancet::CliParams>();
+  result->referencePath = (dataDir / "human_g1k_v37.1_1_90000000.fa.gz").string();
+  result->tumorPath = (dataDir / "tumor.bam").string();
+  result->normalPath = (dataDir / "normal.bam").string();
+  result->maxWindowCov = 1e6;  // NOLINT -- no downsampling, so extracted reads can be compared
+  return result;
+}
+
+auto Window(std::size_t idx) -> lancet::GenomicRegion {
+  const auto start1 = FIRST_START1 + static_cast<std::int64_t>(idx) * STEP_SIZE;
+  return {"1", start1, start1 + WINDOW_LENGTH - 1};
+}
+
+using ReadKey = std::tuple<std::string, std::string, std::int64_t, int>;
+
+auto ExtractedReads(lancet::ReadExtractor* extractor) -> std::vector<ReadKey> {
+  std::vector<ReadKey> result;
+  for (const auto& read : extractor->Extract()) {
+    result.emplace_back(read.readName, read.sequence, read.startPos0, static_cast<int>(read.label));
+  }
+  return result;
+}
+
+auto CachedStates(const lancet::ReadExtractor& extractor) -> std::array<lancet::ReadExtractor::CacheState, 2> {
+  return {extractor.CachedState(LABELS[0]), extractor.CachedState(LABELS[1])};
+}
+
+// Reads decoded into the cache of a new extractor after its first target region
+auto FreshState(const lancet::GenomicRegion& region, lancet::SampleLabel label) -> lancet::ReadExtractor::CacheState {
+  lancet::ReadExtractor fresh(TestParams());
+  fresh.SetTargetRegion(region);
+  return fresh.CachedState(label);
+}
+}  // namespace
+
+TEST_CASE("read extractor slides its read cache between windows", "read_extractor.h") {
+  const auto params = TestParams();
+  lancet::ReadExtractor slid(params);
+
+  SECTION("forward slides reuse overlapping reads and see the same reads as a new extractor") {
+    static constexpr std::size_t NUM_WINDOWS = 20;
+    for (std::size_t idx = 0; idx < NUM_WINDOWS; ++idx) {
+      INFO("window " << idx);
+      const auto window = Window(idx);
+      const auto tmrBefore = slid.CachedState(lancet::SampleLabel::TUMOR);
+      slid.SetTargetRegion(window);
+
+      lancet::ReadExtractor fresh(params);
+      fresh.SetTargetRegion(window);
+      CHECK(slid.IsActiveRegion() == fresh.IsActiveRegion());
+      CHECK(slid.AverageCoverage() == fresh.AverageCoverage());
+      CHECK(ExtractedReads(&slid) == ExtractedReads(&fresh));
+
+      const auto tmrAfter = slid.CachedState(lancet::SampleLabel::TUMOR);
+      const auto tmrFresh = fresh.CachedState(lancet::SampleLabel::TUMOR);
+      REQUIRE(tmrFresh.numReads > 0);
+      CHECK(tmrAfter.start1 == window.StartPosition1());
+      CHECK(tmrAfter.end1 == window.EndPosition1());
+      CHECK(tmrAfter.numReads >= tmrFresh.numReads);
+      if (idx > 0) CHECK(tmrAfter.numDecoded - tmrBefore.numDecoded < tmrFresh.numDecoded);
+    }
+
+    // every read overlapping the windows is decoded exactly once
+    const lancet::GenomicRegion span("1", Window(0).StartPosition1(), Window(NUM_WINDOWS - 1).EndPosition1());
+    for (const auto label : LABELS) {
+      CHECK(slid.CachedState(label).numDecoded == FreshState(span, label).numDecoded);
+    }
+  }
+
+  SECTION("backward jumps reset the cache") {
+    for (std::size_t idx = 0; idx < 3; ++idx) slid.SetTargetRegion(Window(idx));
+    const auto before = CachedStates(slid);
+    slid.SetTargetRegion(Window(0));
+    const auto after = CachedStates(slid);
+
+    for (std::size_t idx = 0; idx < LABELS.size(); ++idx) {
+      const auto fresh = FreshState(Window(0), LABELS[idx]);
+      CHECK(after[idx].start1 == Window(0).StartPosition1());
+      CHECK(after[idx].end1 == Window(0).EndPosition1());
+      CHECK(after[idx].numReads == fresh.numReads);
+      CHECK(after[idx].numDecoded - before[idx].numDecoded == fresh.numDecoded);
+    }
+  }
+
+  SECTION("cross contig jumps reset the cache") {
+    slid.SetTargetRegion(Window(0));
+    slid.SetTargetRegion(lancet::GenomicRegion("2", Window(1).StartPosition1(), Window(1).EndPosition1()));
+    for (const auto label : LABELS) {
+      const auto state = slid.CachedState(label);
+      CHECK(state.chrom == "2");
+      CHECK(state.numReads == 0);
+      CHECK(state.firstReadEnd0 == -1);
+    }
+
+    // same positions as the previous window on chromosome 1, still nothing cached to slide from
+    const auto tmrBefore = slid.CachedState(lancet::SampleLabel::TUMOR);
+    slid.SetTargetRegion(Window(1));
+    const auto tmrAfter = slid.CachedState(lancet::SampleLabel::TUMOR);
+    const auto tmrFresh = FreshState(Window(1), lancet::SampleLabel::TUMOR);
+    CHECK(tmrAfter.chrom == "1");
+    CHECK(tmrAfter.numReads == tmrFresh.numReads);
+    CHECK(tmrAfter.numDecoded - tmrBefore.numDecoded == tmrFresh.numDecoded);
+  }
+
+  SECTION("reads behind the window start are evicted") {
+    const auto first = Window(0);
+    const lancet::GenomicRegion adjacent("1", first.EndPosition1() + 1, first.EndPosition1() + WINDOW_LENGTH);
+    slid.SetTargetRegion(first);
+    const auto before = CachedStates(slid);
+    slid.SetTargetRegion(adjacent);
+    const auto after = CachedStates(slid);
+
+    for (std::size_t idx = 0; idx < LABELS.size(); ++idx) {
+      REQUIRE(before[idx].numReads > 0);
+      const auto fresh = FreshState(adjacent, LABELS[idx]);
+      const auto numAdded = after[idx].numDecoded - before[idx].numDecoded;
+
+      // adjacent window slides, so only reads starting after the previous window are decoded
+      CHECK(after[idx].start1 == adjacent.StartPosition1());
+      CHECK(numAdded < fresh.numDecoded);
+      CHECK(after[idx].firstReadEnd0 >= adjacent.StartPosition1());
+      CHECK(after[idx].numReads < before[idx].numReads + numAdded);
+      CHECK(after[idx].numReads >= fresh.numReads);
+    }
+  }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lancet::test {
+/// Contig name and sequence of a reference FASTA written by `WriteTempFasta`
+using FastaContig = std::pair<std::string, std::string>;
+
+[[nodiscard]] inline auto TempPath(const std::string& name) -> std::filesystem::path {
+  return std::filesystem::temp_directory_path() / name;
+}
+
+/// Write `contigs` to FASTA `name` in the temp directory. Stale index from a previous test run is removed,
+/// so that htslib builds the index for the new sequences on first use
+[[nodiscard]] inline auto WriteTempFasta(const std::string& name, const std::vector<FastaContig>& contigs)
+    -> std::filesystem::path {
+  const auto path = TempPath(name);
+  std::filesystem::remove(path.string() + ".fai");
+  std::ofstream outFa(path, std::ios_base::out | std::ios_base::trunc);
+  for (const auto& [ctgName, ctgSeq] : contigs) outFa << ">" << ctgName << "\n" << ctgSeq << "\n";
+  return path;
+}
+}  // namespace lancet::test
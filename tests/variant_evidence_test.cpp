@@ -0,0 +1,68 @@
+#include "lancet/variant_evidence.h"
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "catch2/catch.hpp"
+#include "lancet/cli_params.h"
+
+namespace {
+auto MakeVariant(std::size_t pos, std::string ref, std::string alt) -> lancet::Variant {
+  const lancet::VariantHpCov tmrCov(lancet::HpCov({20, 18}, {30, 4, 4}), lancet::HpCov({6, 5}, {7, 3, 1}));
+  const lancet::VariantHpCov nmlCov(lancet::HpCov({25, 22}, {40, 5, 2}), lancet::HpCov({0, 1}, {1, 0, 0}));
+  const auto kind = ref.length() == alt.length() ? lancet::TranscriptCode::SNV : lancet::TranscriptCode::INSERTION;
+  const auto length = kind == lancet::TranscriptCode::SNV ? 1 : alt.length() - ref.length();
+  return {"chr1", pos, std::move(ref), std::move(alt), kind, length, 31, tmrCov, nmlCov};
+}
+}  // namespace
+
+TEST_CASE("variants read back from evidence file format the same VCF records", "variant_evidence.h") {
+  const auto path = std::filesystem::temp_directory_path() / "lancet_variant_evidence_test.bin";
+  const lancet::EvidenceHeader hdr{{"normal", "tumor"}, {{"chr1", 1000}, {"chr2", 500}}, "ref.fa", false};
+
+  std::vector<lancet::Variant> variants{MakeVariant(100, "A", "T"), MakeVariant(250, "C", "CGT")};
+  variants[1].STRResult = "2:GT";
+  for (auto& var : variants) var.ContigIdx = 0;
+
+  lancet::EvidenceWriter writer(path);
+  REQUIRE(writer.Open(hdr).ok());
+  for (const auto& var : variants) writer.Write(var);
+  REQUIRE(writer.Close().ok());
+
+  SECTION("header and records round trip") {
+    lancet::EvidenceReader reader(path);
+    REQUIRE(reader.Open().ok());
+    CHECK(reader.Header().sampleNames == hdr.sampleNames);
+    CHECK(reader.Header().referencePath == hdr.referencePath);
+    REQUIRE(reader.Header().contigs.size() == 2);
+    CHECK(reader.Header().contigs[1].contigName == "chr2");
+    CHECK(reader.Header().contigs[1].contigLen == 500);
+
+    const lancet::CliParams params;
+    std::optional<lancet::Variant> result;
+    for (const auto& var : variants) {
+      REQUIRE(reader.Next(&result).ok());
+      REQUIRE(result.has_value());
+      CHECK(result->ID() == var.ID());
+      CHECK(result->ContigIdx == var.ContigIdx);
+      CHECK(result->MakeVcfLine(params) == var.MakeVcfLine(params));
+    }
+
+    REQUIRE(reader.Next(&result).ok());
+    CHECK_FALSE(result.has_value());
+  }
+
+  SECTION("truncated file is reported as data loss") {
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    lancet::EvidenceReader reader(path);
+    REQUIRE(reader.Open().ok());
+
+    std::optional<lancet::Variant> result;
+    REQUIRE(reader.Next(&result).ok());
+    CHECK(absl::IsDataLoss(reader.Next(&result)));
+  }
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,95 @@
+#include "lancet/variant_store.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catch2/catch.hpp"
+
+namespace {
+constexpr int DEFAULT_NUM_WINDOWS = 120;
+constexpr int DEFAULT_FLUSH_LAG = 40;
+
+// Variants of `num_windows` overlapping windows, flushed `flush_lag` windows behind the last window added like
+// in the pipeline. Returns the output VCF and the max. number of spilled runs seen while adding variants.
+auto RunStore(std::uint32_t max_store_mem_mb, std::size_t* max_spill_runs, int num_windows = DEFAULT_NUM_WINDOWS,
+              int flush_lag = DEFAULT_FLUSH_LAG) -> std::string {
+  static constexpr std::size_t WINDOW_STEP = 100;
+
+  auto params = std::make_shared<lancet::CliParams>();
+  params->maxStoreMemMb = max_store_mem_mb;
+  lancet::VariantStore store(params, {{"chr1", 0}});
+
+  const auto outPath = std::filesystem::temp_directory_path() / "lancet_variant_store_test.vcf";
+  lancet::VcfWriter out(outPath, 0);
+
+  std::mt19937 rng(42);  // NOLINT
+  static constexpr std::string_view bases = "ACGT";
+  *max_spill_runs = 0;
+  for (int win = 0; win < num_windows; ++win) {
+    std::vector<lancet::Variant> variants;
+    for (int idx = 0; idx < 300; ++idx) {  // NOLINT
+      const auto pos = static_cast<std::size_t>(win) * WINDOW_STEP + rng() % 600;
+      const auto extraCov = static_cast<std::uint16_t>(rng() % 4);
+      const auto tmrRefFwd = static_cast<std::uint16_t>(10 + extraCov);
+      const auto tmrAltRev = static_cast<std::uint16_t>(2 + extraCov);
+      const lancet::VariantHpCov tmrCov(lancet::HpCov({tmrRefFwd, 9}, {0, 0, 0}),
+                                        lancet::HpCov({3, tmrAltRev}, {0, 0, 0}));
+      const lancet::VariantHpCov nmlCov(lancet::HpCov({12, 11}, {0, 0, 0}), lancet::HpCov({0, 0}, {0, 0, 0}));
+      variants.emplace_back("chr1", pos, std::string(1, bases[pos % 4]), std::string(1, bases[(pos + 1) % 4]),
+                            lancet::TranscriptCode::SNV, 1, 31, tmrCov, nmlCov);
+      if (rng() % 2 == 0) variants.back().RenderRecord(*params);
+    }
+
+    store.AddVariants(absl::MakeSpan(variants));
+    *max_spill_runs = std::max(*max_spill_runs, store.NumSpillRuns());
+    if (win < flush_lag) continue;
+
+    const auto flushIdx = static_cast<std::size_t>(win - flush_lag);
+    lancet::RefWindow window;
+    window.SetChromosome("chr1");
+    window.SetStartPosition0(static_cast<std::int64_t>(flushIdx * WINDOW_STEP));
+    window.SetEndPosition0(static_cast<std::int64_t>((flushIdx + 1) * WINDOW_STEP - 1));
+    store.FlushWindow(window, out);
+  }
+
+  store.FlushAll(out);
+  out.Close();
+  CHECK(store.IsEmpty());
+
+  std::ifstream inFh(outPath);
+  std::stringstream result;
+  result << inFh.rdbuf();
+  std::filesystem::remove(outPath);
+  return result.str();
+}
+}  // namespace
+
+TEST_CASE("spilled variant store writes the same variants as in-memory store", "variant_store.h") {
+  std::size_t inMemoryRuns = 0;
+  std::size_t spilledRuns = 0;
+  const auto inMemory = RunStore(0, &inMemoryRuns);
+  const auto spilled = RunStore(1, &spilledRuns);
+
+  CHECK(inMemoryRuns == 0);
+  CHECK(spilledRuns > 1);
+  CHECK_FALSE(inMemory.empty());
+  CHECK(spilled == inMemory);
+}
+
+TEST_CASE("spilled runs are compacted while no window can be flushed", "variant_store.h") {
+  // enough variants for more spills than the max. number of runs, all held back until the final flush
+  static constexpr int NUM_WINDOWS = 600;
+  std::size_t inMemoryRuns = 0;
+  std::size_t spilledRuns = 0;
+  const auto inMemory = RunStore(0, &inMemoryRuns, NUM_WINDOWS, NUM_WINDOWS);
+  const auto spilled = RunStore(1, &spilledRuns, NUM_WINDOWS, NUM_WINDOWS);
+
+  CHECK(inMemoryRuns == 0);
+  CHECK(spilledRuns == lancet::VariantStore::MAX_SPILL_RUNS);
+  CHECK_FALSE(inMemory.empty());
+  CHECK(spilled == inMemory);
+}
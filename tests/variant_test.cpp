@@ -0,0 +1,106 @@
+#include "lancet/variant.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "catch2/catch.hpp"
+
+namespace {
+// Haplotype counts are in HP0, HP1, HP2 order
+auto Cov(std::uint16_t ref_fwd, std::uint16_t ref_rev, std::uint16_t alt_fwd, std::uint16_t alt_rev,
+         const std::array<std::uint16_t, 3>& ref_hps = {0, 0, 0},
+         const std::array<std::uint16_t, 3>& alt_hps = {0, 0, 0}) -> lancet::VariantHpCov {
+  return {lancet::HpCov({ref_fwd, ref_rev}, ref_hps), lancet::HpCov({alt_fwd, alt_rev}, alt_hps)};
+}
+}  // namespace
+
+// Expected records were produced by the `StrFormat` based formatter that `AppendVcfLine` replaced
+TEST_CASE("vcf records are formatted byte for byte like the previous formatter", "variant.h") {
+  using lancet::TranscriptCode;
+  const lancet::CliParams params;
+  lancet::CliParams tenxParams;
+  tenxParams.tenxMode = true;
+
+  SECTION("passing somatic SNV") {
+    const lancet::Variant var("chr1", 1234, "A", "T", TranscriptCode::SNV, 1, 31, Cov(20, 18, 6, 5),  // NOLINT
+                              Cov(15, 16, 0, 0));                                                      // NOLINT
+    CHECK(var.MakeVcfLine(params) ==
+          "chr1\t1234\t.\tA\tT\t25.558363\tPASS\tSOMATIC;FETS=25.558363;TYPE=snv;LEN=1;KMERSIZE=31;SB=5.752946\t"
+          "GT:AD:SR:SA:DP\t0/0:31,0:15,16:0,0:31\t0/1:38,11:20,18:6,5:49\n");
+  }
+
+  SECTION("low fisher score, low tumor VAF and strand bias filters") {
+    const lancet::Variant var("chr2", 50000, "G", "C", TranscriptCode::SNV, 1, 21, Cov(100, 90, 3, 0),  // NOLINT
+                              Cov(40, 38, 0, 0));                                                        // NOLINT
+    CHECK(var.MakeVcfLine(params) ==
+          "chr2\t50000\t.\tG\tC\t4.441934\tLowFisherScore;LowVafTumor;StrandBias\t"
+          "SOMATIC;FETS=4.441934;TYPE=snv;LEN=1;KMERSIZE=21;SB=8.241331\t"
+          "GT:AD:SR:SA:DP\t0/0:78,0:40,38:0,0:78\t0/1:190,3:100,90:3,0:193\n");
+  }
+
+  SECTION("shared deletion in a microsatellite") {
+    lancet::Variant var("chr1", 777, "CAC", "C", TranscriptCode::DELETION, 2, 41, Cov(12, 11, 4, 4),  // NOLINT
+                        Cov(14, 13, 1, 0));                                                           // NOLINT
+    var.STRResult = "2:AC";
+    CHECK(var.MakeVcfLine(params) ==
+          "chr1\t777\t.\tCAC\tC\t17.550208\tLowFisherSTR;HighVafNormal;HighAltCntNormal\t"
+          "SHARED;FETS=17.550208;TYPE=del;LEN=2;KMERSIZE=41;SB=5.018028;MS=2:AC\t"
+          "GT:AD:SR:SA:DP\t0/1:27,1:14,13:1,0:28\t0/1:23,8:12,11:4,4:31\n");
+  }
+
+  SECTION("tenx insertion in both haplotypes") {
+    const lancet::Variant var("chrX", 98765, "T", "TGG", TranscriptCode::INSERTION, 2, 25,  // NOLINT
+                              Cov(10, 12, 5, 4, {2, 10, 10}, {0, 4, 5}),                    // NOLINT
+                              Cov(16, 14, 0, 0, {3, 14, 13}, {0, 0, 0}));                   // NOLINT
+    CHECK(var.MakeVcfLine(tenxParams) ==
+          "chrX\t98765\t.\tT\tTGG\t29.346011\tMultiHP\t"
+          "SOMATIC;FETS=29.346011;TYPE=ins;LEN=2;KMERSIZE=25;SB=5.668654;HPS=6.916621;HPSN=0.000000;HPST=5.226618\t"
+          "GT:AD:SR:SA:DP:HPR:HPA\t0/0:30,0:16,14:0,0:30:14,13,3:0,0,0\t0/1:22,9:10,12:5,4:31:10,10,2:4,5,0\n");
+  }
+
+  SECTION("tenx complex event with low coverage filters") {
+    const lancet::Variant var("chr3", 42, "AT", "GC", TranscriptCode::COMPLEX, 2, 31,  // NOLINT
+                              Cov(2, 1, 1, 0, {1, 1, 1}, {0, 1, 0}), Cov(3, 2, 0, 0, {1, 2, 2}, {0, 0, 0}));
+    CHECK(var.MakeVcfLine(tenxParams) ==
+          "chr3\t42\t.\tAT\tGC\t3.521825\tLowFisherScore;LowCovNormal;LowAltCntTumor;StrandBias\t"
+          "SOMATIC;FETS=3.521825;TYPE=complex;LEN=2;KMERSIZE=31;SB=1.249387;HPS=2.887955;HPSN=0.000000;HPST=1.760913\t"
+          "GT:AD:SR:SA:DP:HPR:HPA\t0/0:5,0:3,2:0,0:5:2,2,1:0,0,0\t0/1:3,1:2,1:1,0:4:1,1,1:1,0,0\n");
+  }
+}
+
+TEST_CASE("vcf records are appended after existing buffer contents", "variant.h") {
+  const lancet::CliParams params;
+  const lancet::Variant first("chr1", 10, "A", "T", lancet::TranscriptCode::SNV, 1, 31, Cov(20, 18, 6, 5),  // NOLINT
+                              Cov(15, 16, 0, 0));                                                            // NOLINT
+  const lancet::Variant second("chr1", 20, "C", "G", lancet::TranscriptCode::SNV, 1, 31, Cov(9, 8, 3, 3),  // NOLINT
+                               Cov(11, 12, 0, 0));                                                          // NOLINT
+
+  std::string buffer;
+  first.AppendVcfLine(params, &buffer);
+  second.AppendVcfLine(params, &buffer);
+  CHECK(buffer == first.MakeVcfLine(params) + second.MakeVcfLine(params));
+}
+
+TEST_CASE("variants are identified by contig, position and allele hash", "variant.h") {
+  using lancet::TranscriptCode;
+  const auto makeVar = [](const char* chrom, std::size_t pos, const char* ref, const char* alt) {
+    return lancet::Variant(chrom, pos, ref, alt, TranscriptCode::SNV, 1, 31, Cov(10, 10, 2, 2),  // NOLINT
+                           Cov(10, 10, 0, 0));                                                    // NOLINT
+  };
+
+  const auto var = makeVar("chr1", 100, "A", "T");  // NOLINT
+  CHECK(var.ID() == lancet::Variant::AlleleHash("A", "T"));
+  CHECK(var.ID() != lancet::Variant::AlleleHash("AT", ""));
+  CHECK(var == makeVar("chr1", 100, "A", "T"));  // NOLINT
+  CHECK(var != makeVar("chr1", 101, "A", "T"));  // NOLINT
+  CHECK(var != makeVar("chr2", 100, "A", "T"));  // NOLINT
+  CHECK(var != makeVar("chr1", 100, "A", "G"));  // NOLINT
+
+  // position is compared before alleles, and variants at the same position are ordered by alleles
+  const auto next = makeVar("chr1", 101, "C", "G");  // NOLINT
+  CHECK(var.SortKey() < next.SortKey());
+  CHECK_FALSE(next.SortKey() < var.SortKey());
+  CHECK(makeVar("chr1", 100, "A", "G").SortKey() < var.SortKey());  // NOLINT
+}
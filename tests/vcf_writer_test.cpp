@@ -0,0 +1,207 @@
+#include "lancet/vcf_writer.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "lancet/hts_reader.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wcast-align"
+#pragma clang diagnostic ignored "-Wcast-qual"
+#elif defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+
+#include "htslib/hts.h"
+#include "htslib/kseq.h"
+#include "htslib/kstring.h"
+#include "htslib/tbx.h"
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+auto Header(std::int64_t contig_len) -> std::string {
+  return R"raw(##fileformat=VCFv4.3
+##INFO=<ID=SOMATIC,Number=0,Type=Flag,Description="Mutation present only in tumor">
+##FORMAT=<ID=GT,Number=1,Type=String,Description="Genotype">
+##FORMAT=<ID=DP,Number=1,Type=Integer,Description="Read depth">
+##contig=<ID=chr1,length=)raw" +
+         std::to_string(contig_len) + ">\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tnormal\ttumor\n";
+}
+
+const std::vector<std::string> RECORDS{
+    "chr1\t100\t.\tA\tT\t30\tPASS\tSOMATIC\tGT:DP\t0/0:10\t0/1:12",
+    "chr1\t250\t.\tC\tCTT\t41\tPASS\tSOMATIC\tGT:DP\t0/0:14\t0/1:9",
+    "chr1\t900\t.\tGA\tG\t17\tPASS\tSOMATIC\tGT:DP\t0/0:8\t0/1:20",
+};
+
+void WriteVcf(const std::filesystem::path& path, std::int64_t contig_len) {
+  lancet::VcfWriter out(path, 0);
+  out.WriteHeader(Header(contig_len));
+  for (const auto& rec : RECORDS) out.WriteRecord(rec + "\n");
+  out.Close();
+}
+
+// Read all lines through htslib, which transparently decompresses BGZF output
+auto ReadLines(const std::filesystem::path& path) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  htsFile* fp = hts_open(path.c_str(), "r");
+  if (fp == nullptr) return result;
+
+  kstring_t line{0, 0, nullptr};
+  while (hts_getline(fp, KS_SEP_LINE, &line) >= 0) result.emplace_back(line.s, line.l);
+  free(line.s);  // NOLINT
+  hts_close(fp);
+  return result;
+}
+
+auto ReadRecords(const std::filesystem::path& path) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  for (auto& line : ReadLines(path)) {
+    if (line.rfind('#', 0) != 0) result.push_back(std::move(line));
+  }
+  return result;
+}
+
+// Records overlapping `region`, fetched through the tabix index of `path`
+auto QueryRecords(const std::filesystem::path& path, const char* region) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  htsFile* fp = hts_open(path.c_str(), "r");
+  tbx_t* tbx = tbx_index_load(path.c_str());
+  hts_itr_t* itr = tbx == nullptr ? nullptr : tbx_itr_querys(tbx, region);
+
+  kstring_t line{0, 0, nullptr};
+  while (itr != nullptr && tbx_itr_next(fp, tbx, itr, &line) >= 0) result.emplace_back(line.s, line.l);
+  free(line.s);  // NOLINT
+  hts_itr_destroy(itr);
+  if (tbx != nullptr) tbx_destroy(tbx);
+  hts_close(fp);
+  return result;
+}
+
+auto IsBgzf(const std::filesystem::path& path) -> bool {
+  std::array<unsigned char, 2> magic{};
+  std::ifstream inFh(path, std::ios_base::in | std::ios_base::binary);
+  inFh.read(reinterpret_cast<char*>(magic.data()), magic.size());  // NOLINT
+  return inFh.good() && magic[0] == 0x1f && magic[1] == 0x8b;      // NOLINT
+}
+
+auto FreshPath(const std::string& name) -> std::filesystem::path {
+  const auto path = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove(path);
+  std::filesystem::remove(path.string() + ".tbi");
+  std::filesystem::remove(path.string() + ".csi");
+  return path;
+}
+}  // namespace
+
+TEST_CASE("vcf writer round trips records", "vcf_writer.h") {
+  SECTION("plain VCF") {
+    const auto path = FreshPath("lancet_vcf_writer_test.vcf");
+    CHECK_FALSE(lancet::VcfWriter::IsCompressedPath(path));
+    WriteVcf(path, 1000);  // NOLINT
+
+    CHECK_FALSE(IsBgzf(path));
+    CHECK(ReadRecords(path) == RECORDS);
+    CHECK_FALSE(std::filesystem::exists(path.string() + ".tbi"));
+  }
+
+  SECTION("plain VCF resumed from offset drops output after the offset") {
+    const auto path = FreshPath("lancet_vcf_writer_resume_test.vcf");
+    std::uint64_t offset = 0;
+    {
+      lancet::VcfWriter out(path, 0);
+      out.WriteHeader(Header(1000));  // NOLINT
+      out.WriteRecord(RECORDS[0] + "\n");
+      out.Flush();
+      offset = out.Offset();
+      out.WriteRecord(RECORDS[2] + "\n");
+      out.Close();
+    }
+
+    lancet::VcfWriter resumed(path, offset);
+    resumed.WriteRecord(RECORDS[1] + "\n");
+    resumed.WriteRecord(RECORDS[2] + "\n");
+    resumed.Close();
+    CHECK(ReadRecords(path) == RECORDS);
+  }
+
+  SECTION("BGZF compressed VCF with tabix index") {
+    const auto path = FreshPath("lancet_vcf_writer_test.vcf.gz");
+    CHECK(lancet::VcfWriter::IsCompressedPath(path));
+    WriteVcf(path, 1000);  // NOLINT
+
+    CHECK(IsBgzf(path));
+    CHECK(ReadRecords(path) == RECORDS);
+    CHECK(std::filesystem::exists(path.string() + ".tbi"));
+    CHECK_FALSE(std::filesystem::exists(path.string() + ".csi"));
+  }
+
+  SECTION("BGZF compressed VCF with contig too long for tabix gets CSI index") {
+    const auto path = FreshPath("lancet_vcf_writer_long_contig_test.vcf.gz");
+    WriteVcf(path, std::int64_t(1) << 30);  // NOLINT
+
+    CHECK(ReadRecords(path) == RECORDS);
+    CHECK(std::filesystem::exists(path.string() + ".csi"));
+    CHECK_FALSE(std::filesystem::exists(path.string() + ".tbi"));
+  }
+
+  SECTION("BGZF compressed VCF written with the shared thread pool") {
+    lancet::InitSharedHtsThreadPool(2);
+    const auto path = FreshPath("lancet_vcf_writer_pool_test.vcf.gz");
+    WriteVcf(path, 1000);  // NOLINT
+
+    CHECK(IsBgzf(path));
+    CHECK(ReadRecords(path) == RECORDS);
+    CHECK(std::filesystem::exists(path.string() + ".tbi"));
+  }
+
+  SECTION("BGZF compressed VCF of variants is indexed at variant positions") {
+    const auto path = FreshPath("lancet_vcf_writer_variants_test.vcf.gz");
+    const lancet::CliParams params;
+    const lancet::VariantHpCov tmrCov(lancet::HpCov({10, 9}, {0, 0, 0}), lancet::HpCov({3, 4}, {0, 0, 0}));
+    const lancet::VariantHpCov nmlCov(lancet::HpCov({12, 11}, {0, 0, 0}), lancet::HpCov({0, 0}, {0, 0, 0}));
+
+    std::vector<lancet::Variant> variants;
+    variants.emplace_back("chr1", 100, "A", "T", lancet::TranscriptCode::SNV, 1, 31, tmrCov, nmlCov);  // NOLINT
+    variants.emplace_back("chr1", 250, "CAGT", "C", lancet::TranscriptCode::DELETION, 3, 31, tmrCov,  // NOLINT
+                          nmlCov);
+    variants.emplace_back("chr1", 900, "G", "GTT", lancet::TranscriptCode::INSERTION, 2, 31, tmrCov,  // NOLINT
+                          nmlCov);
+    variants[0].ContigIdx = 0;
+    variants[1].RenderRecord(params);
+
+    {
+      lancet::VcfWriter out(path, 0);
+      out.WriteHeader(Header(1000));  // NOLINT
+      for (const auto& var : variants) out.WriteVariant(var, params);
+      out.Close();
+    }
+
+    std::vector<std::string> expected;
+    for (const auto& var : variants) {
+      auto line = var.MakeVcfLine(params);
+      line.pop_back();
+      expected.push_back(std::move(line));
+    }
+
+    CHECK(ReadRecords(path) == expected);
+    REQUIRE(std::filesystem::exists(path.string() + ".tbi"));
+    CHECK(QueryRecords(path, "chr1:100-100") == std::vector<std::string>{expected[0]});
+    CHECK(QueryRecords(path, "chr1:253-253") == std::vector<std::string>{expected[1]});
+    CHECK(QueryRecords(path, "chr1:260-899").empty());
+    CHECK(QueryRecords(path, "chr1:900-900") == std::vector<std::string>{expected[2]});
+  }
+}
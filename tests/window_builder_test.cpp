@@ -0,0 +1,120 @@
+#include "lancet/window_builder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "test_utils.h"
+
+namespace {
+constexpr std::uint32_t WINDOW_LENGTH = 600;
+constexpr std::uint32_t PCT_OVERLAP = 50;
+
+using lancet::test::TempPath;
+
+auto WriteReference() -> std::filesystem::path {
+  return lancet::test::WriteTempFasta("lancet_window_builder_test.fa",
+                                      {{"chr1", std::string(20000, 'A')}, {"chr2", std::string(5000, 'C')}});  // NOLINT
+}
+
+auto WriteBed(const std::vector<std::string>& lines) -> std::filesystem::path {
+  const auto path = TempPath("lancet_window_builder_test.bed");
+  std::ofstream outBed(path, std::ios_base::out | std::ios_base::trunc);
+  for (const auto& line : lines) outBed << line << "\n";
+  return path;
+}
+
+auto BuildGenerator(const std::vector<std::string>& bed_lines, std::uint32_t region_padding)
+    -> std::unique_ptr<lancet::WindowGenerator> {
+  const auto refPath = WriteReference();
+  lancet::WindowBuilder builder(refPath, region_padding, WINDOW_LENGTH, PCT_OVERLAP);
+  REQUIRE(builder.AddBedFileRegions(WriteBed(bed_lines)).ok());
+
+  auto result = builder.BuildGenerator(lancet::FastaReader(refPath).ContigIDs());
+  REQUIRE(result.ok());
+  return std::move(result.value());
+}
+
+auto DrainWindows(lancet::WindowGenerator* gen) -> std::vector<lancet::WindowPtr> {
+  std::vector<lancet::WindowPtr> result;
+  for (auto window = gen->Next(); window != nullptr; window = gen->Next()) result.push_back(window);
+  return result;
+}
+
+// Windows are in genome order with consecutive indices and no window starts twice
+void CheckGenomeOrder(const std::vector<lancet::WindowPtr>& windows) {
+  for (std::size_t idx = 0; idx < windows.size(); ++idx) {
+    CHECK(windows[idx]->WindowIndex() == idx);
+    if (idx == 0 || windows[idx]->Chromosome() != windows[idx - 1]->Chromosome()) continue;
+    CHECK(windows[idx]->StartPosition0() > windows[idx - 1]->StartPosition0());
+  }
+}
+}  // namespace
+
+TEST_CASE("window generator makes as many windows as it reports in total", "window_builder.h") {
+  SECTION("overlapping and adjacent regions are merged") {
+    const auto gen = BuildGenerator({"chr1\t1000\t3000", "chr1\t2500\t4000", "chr1\t4000\t5000"}, 0);
+    const auto windows = DrainWindows(gen.get());
+
+    // single merged region chr1:1000-5000 with 300bp steps
+    CHECK(gen->TotalWindows() == 14);
+    CHECK(windows.size() == gen->TotalWindows());
+    CHECK(gen->NumGenerated() == gen->TotalWindows());
+    REQUIRE_FALSE(windows.empty());
+    CHECK(windows.front()->StartPosition0() == 1000);
+    CHECK(windows.back()->StartPosition0() == 4900);
+    CheckGenomeOrder(windows);
+  }
+
+  SECTION("regions shorter than one window become a single window") {
+    const auto gen = BuildGenerator({"chr1\t100\t150", "chr1\t10000\t10600", "chr2\t40\t41"}, 0);
+    const auto windows = DrainWindows(gen.get());
+
+    CHECK(gen->TotalWindows() == 3);
+    CHECK(windows.size() == gen->TotalWindows());
+    REQUIRE(windows.size() == 3);
+    CHECK(windows[0]->Length() == 50);
+    CHECK(windows[1]->Length() == WINDOW_LENGTH);
+    CHECK(windows[2]->Chromosome() == "chr2");
+    CHECK(windows[2]->Length() == 1);
+    CheckGenomeOrder(windows);
+  }
+
+  SECTION("padding merges nearby regions and is clipped at contig ends") {
+    const auto gen = BuildGenerator({"chr2\t4900\t4950", "chr1\t0\t200", "chr1\t500\t700", "chr1\t9000\t9010"}, 250);
+    const auto windows = DrainWindows(gen.get());
+
+    // chr1:0-950 is merged from padded regions, chr1:8750-9260 is one short window, chr2:4650-5000 too
+    CHECK(gen->TotalWindows() == 6);
+    CHECK(windows.size() == gen->TotalWindows());
+    REQUIRE(windows.size() == 6);
+    CHECK(windows.back()->Chromosome() == "chr2");
+    CHECK(windows.back()->EndPosition0() == 5000);
+    CheckGenomeOrder(windows);
+  }
+
+  SECTION("skipped and limited windows are not generated") {
+    const std::vector<std::string> bedLines{"chr1\t0\t3000", "chr1\t3200\t3300", "chr2\t0\t5000"};
+    const auto allWindows = DrainWindows(BuildGenerator(bedLines, 0).get());
+
+    const auto gen = BuildGenerator(bedLines, 0);
+    REQUIRE(allWindows.size() == gen->TotalWindows());
+    gen->SkipWindows(9);  // NOLINT
+    gen->LimitWindows(gen->TotalWindows() - 2);
+    const auto windows = DrainWindows(gen.get());
+
+    REQUIRE(windows.size() == gen->TotalWindows() - 11);
+    for (std::size_t idx = 0; idx < windows.size(); ++idx) {
+      const auto& expected = allWindows[idx + 9];
+      CHECK(windows[idx]->WindowIndex() == expected->WindowIndex());
+      CHECK(windows[idx]->Chromosome() == expected->Chromosome());
+      CHECK(windows[idx]->StartPosition0() == expected->StartPosition0());
+    }
+  }
+}
@@ -0,0 +1,61 @@
+#include "lancet/window_prefetcher.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "catch2/catch.hpp"
+#include "test_utils.h"
+
+namespace {
+constexpr std::uint32_t WINDOW_LENGTH = 100;
+constexpr std::int64_t REGION_LENGTH = 2000;
+
+auto WriteReference() -> std::filesystem::path {
+  std::string seq;
+  for (std::int64_t pos = 0; pos < REGION_LENGTH; ++pos) seq.push_back("ACGTTGCA"[(pos * 7 + pos / 3) % 8]);  // NOLINT
+  return lancet::test::WriteTempFasta("lancet_window_prefetcher_test.fa", {{"chr1", seq}});
+}
+}  // namespace
+
+TEST_CASE("prefetch threads that cannot open readers send the error with every window", "window_prefetcher.h") {
+  auto params = std::make_shared<lancet::CliParams>();
+  params->referencePath = WriteReference().string();
+  params->tumorPath = lancet::test::TempPath("lancet_missing_tumor.bam").string();
+  params->normalPath = params->tumorPath;
+
+  lancet::RefWindow region;
+  region.SetChromosome("chr1");
+  region.SetStartPosition0(0);
+  region.SetEndPosition0(REGION_LENGTH);
+  auto gen = std::make_unique<lancet::WindowGenerator>(std::vector<lancet::RefWindow>{region}, WINDOW_LENGTH,
+                                                       WINDOW_LENGTH);
+  const auto numWindows = gen->TotalWindows();
+
+  static constexpr std::size_t NUM_THREADS = 2;
+  const auto sched = std::make_shared<lancet::WindowScheduler>(std::move(gen), NUM_THREADS, params);
+  lancet::WindowPrefetcher prefetcher(sched, 4, params);
+  prefetcher.Start(NUM_THREADS);
+
+  std::vector<std::size_t> windowIdxs;
+  lancet::WindowPayload payload;
+  while (prefetcher.Next(&payload)) {
+    REQUIRE(payload.window != nullptr);
+    CHECK_FALSE(payload.status.ok());
+    CHECK_FALSE(payload.shouldAssemble);
+    CHECK(absl::StrContains(payload.status.message(), "could not open readers"));
+    windowIdxs.push_back(payload.window->WindowIndex());
+  }
+
+  CHECK_NOTHROW(prefetcher.Join());
+
+  std::sort(windowIdxs.begin(), windowIdxs.end());
+  std::vector<std::size_t> expected(numWindows);
+  for (std::size_t idx = 0; idx < numWindows; ++idx) expected[idx] = idx;
+  CHECK(windowIdxs == expected);
+}
@@ -0,0 +1,140 @@
+#include "lancet/window_scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "test_utils.h"
+
+namespace {
+constexpr std::uint32_t WINDOW_LENGTH = 100;
+constexpr std::size_t RUN_LENGTH = WINDOW_LENGTH * lancet::DEFAULT_WINDOWS_PER_RUN;
+
+enum class RunSeq { RANDOM, REPEAT, ALL_N };
+
+// Write single contig FASTA with one sequence kind per run of windows
+auto WriteReference(const std::vector<RunSeq>& runs) -> std::filesystem::path {
+  std::mt19937 rng(7);  // NOLINT
+  static constexpr std::string_view bases = "ACGT";
+  std::string seq;
+  for (const auto kind : runs) {
+    for (std::size_t idx = 0; idx < RUN_LENGTH; ++idx) {
+      if (kind == RunSeq::RANDOM) seq.push_back(bases[rng() % 4]);
+      if (kind == RunSeq::REPEAT) seq.push_back("ACGTT"[idx % 5]);
+      if (kind == RunSeq::ALL_N) seq.push_back('N');
+    }
+  }
+
+  return lancet::test::WriteTempFasta("lancet_window_scheduler_test.fa", {{"chr1", seq}});
+}
+
+auto MakeScheduler(const std::vector<RunSeq>& runs, std::size_t num_workers)
+    -> std::unique_ptr<lancet::WindowScheduler> {
+  auto params = std::make_shared<lancet::CliParams>();
+  params->referencePath = WriteReference(runs).string();
+
+  lancet::RefWindow region;
+  region.SetChromosome("chr1");
+  region.SetStartPosition0(0);
+  region.SetEndPosition0(static_cast<std::int64_t>(runs.size() * RUN_LENGTH));
+  auto gen = std::make_unique<lancet::WindowGenerator>(std::vector<lancet::RefWindow>{region}, WINDOW_LENGTH,
+                                                       WINDOW_LENGTH);
+  return std::make_unique<lancet::WindowScheduler>(std::move(gen), num_workers, params);
+}
+
+auto RunIndices(std::size_t first_run, std::size_t last_run) -> std::vector<std::size_t> {
+  std::vector<std::size_t> result;
+  const auto endIdx = last_run * lancet::DEFAULT_WINDOWS_PER_RUN;
+  for (auto idx = first_run * lancet::DEFAULT_WINDOWS_PER_RUN; idx < endIdx; ++idx) result.push_back(idx);
+  return result;
+}
+}  // namespace
+
+TEST_CASE("scheduler hands out costliest runs first in genome order", "window_scheduler.h") {
+  const auto sched = MakeScheduler({RunSeq::RANDOM, RunSeq::RANDOM, RunSeq::REPEAT, RunSeq::RANDOM}, 1);
+
+  std::vector<std::size_t> firstRun;
+  for (std::size_t idx = 0; idx < lancet::DEFAULT_WINDOWS_PER_RUN; ++idx) {
+    const auto window = sched->Next(0);
+    REQUIRE(window != nullptr);
+    CHECK_FALSE(window->SeqView().empty());
+    firstRun.push_back(window->WindowIndex());
+  }
+
+  CHECK(firstRun == RunIndices(2, 3));
+
+  std::size_t numRemaining = 0;
+  while (sched->Next(0) != nullptr) numRemaining++;
+  CHECK(numRemaining == 3 * lancet::DEFAULT_WINDOWS_PER_RUN);
+}
+
+TEST_CASE("scheduler claims oldest run once it has been skipped too often", "window_scheduler.h") {
+  // windows with only N bases cost nothing, so the first run is always passed over for costlier runs
+  const auto sched = MakeScheduler({RunSeq::ALL_N, RunSeq::REPEAT, RunSeq::REPEAT, RunSeq::REPEAT, RunSeq::REPEAT,
+                                    RunSeq::REPEAT},
+                                   1);
+
+  std::vector<std::size_t> order;
+  for (auto window = sched->Next(0); window != nullptr; window = sched->Next(0)) order.push_back(window->WindowIndex());
+
+  // single worker keeps `DEFAULT_PENDING_RUNS_PER_WORKER` runs pending, so first run is skipped as many times
+  std::vector<std::size_t> expected = RunIndices(1, 5);
+  const auto oldestRun = RunIndices(0, 1);
+  const auto lastRun = RunIndices(5, 6);
+  expected.insert(expected.end(), oldestRun.cbegin(), oldestRun.cend());
+  expected.insert(expected.end(), lastRun.cbegin(), lastRun.cend());
+  CHECK(order == expected);
+}
+
+TEST_CASE("idle workers steal windows from the back of the busiest run", "window_scheduler.h") {
+  const auto sched = MakeScheduler({RunSeq::RANDOM}, 2);
+
+  const auto first = sched->Next(0);
+  REQUIRE(first != nullptr);
+  CHECK(first->WindowIndex() == 0);
+
+  const auto stolen = sched->Next(1);
+  REQUIRE(stolen != nullptr);
+  CHECK(stolen->WindowIndex() == lancet::DEFAULT_WINDOWS_PER_RUN - 1);
+
+  const auto second = sched->Next(0);
+  REQUIRE(second != nullptr);
+  CHECK(second->WindowIndex() == 1);
+
+  std::size_t numRemaining = 0;
+  while (sched->Next(1) != nullptr) numRemaining++;
+  CHECK(numRemaining == lancet::DEFAULT_WINDOWS_PER_RUN - 3);
+  CHECK(sched->Next(0) == nullptr);
+}
+
+TEST_CASE("concurrent workers get every window exactly once", "window_scheduler.h") {
+  static constexpr std::size_t NUM_WORKERS = 4;
+  const std::vector<RunSeq> runs(20, RunSeq::RANDOM);  // NOLINT
+  const auto sched = MakeScheduler(runs, NUM_WORKERS);
+
+  std::vector<std::vector<std::size_t>> perWorker(NUM_WORKERS);
+  std::vector<std::thread> workers;
+  for (std::size_t idx = 0; idx < NUM_WORKERS; ++idx) {
+    workers.emplace_back([&sched, &perWorker, idx]() {
+      for (auto window = sched->Next(idx); window != nullptr; window = sched->Next(idx)) {
+        perWorker[idx].push_back(window->WindowIndex());
+      }
+    });
+  }
+
+  for (auto& thread : workers) thread.join();
+
+  std::vector<std::size_t> allIndices;
+  for (const auto& indices : perWorker) allIndices.insert(allIndices.end(), indices.cbegin(), indices.cend());
+  std::sort(allIndices.begin(), allIndices.end());
+  CHECK(allIndices == RunIndices(0, runs.size()));
+}